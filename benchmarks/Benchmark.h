@@ -0,0 +1,221 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief Keep the compiler from optimizing away a value computed by a benchmark
+ */
+template<typename T>
+inline void do_not_optimize(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static volatile const void *sink;
+    sink = &value;
+#endif
+}
+
+
+/**
+ * @brief Minimal microbenchmark runner: calibrates the number of iterations of each benchmark to a minimum time,
+ *  repeats the measurement, prints a markdown table and writes the results to a JSON file, to track them over time
+ */
+class BenchmarkRunner {
+public:
+    using Params = std::vector<std::pair<std::string, double>>;
+
+    struct Options {
+        std::string filter;     ///< Only run the benchmarks whose full name contains it
+        double min_time = 0.1;  ///< Minimum time of each repetition (s)
+        int repetitions = 5;    ///< Measurements per benchmark, the median is reported
+        std::string json_path;  ///< Results file (none if empty)
+        std::string label;      ///< Free-form label of the run (e.g. the commit), stored in the JSON file
+    };
+
+    struct Result {
+        std::string name;
+        Params params;
+        uint64_t iterations = 0;
+        double median_ns = 0, min_ns = 0, mean_ns = 0;
+        Params counters;
+    };
+
+private:
+    Options _options;
+    std::vector<Result> _results;
+
+
+public:
+    explicit BenchmarkRunner(Options options) : _options(std::move(options)) {
+        std::cout << "| Benchmark | Iterations | Median (us) | Min (us) | Mean (us) | Counters |\n"
+                  << "| --- | --- | --- | --- | --- | --- |" << std::endl;
+    }
+
+    ~BenchmarkRunner() {
+        if (!_options.json_path.empty()) {
+            write_json(_options.json_path);
+        }
+    }
+
+    /**
+     * @brief Full name of a benchmark: its name followed by its parameters (e.g. iou_distance/tracks:100/detections:100)
+     */
+    static std::string full_name(const std::string &name, const Params &params) {
+        std::ostringstream out;
+        out << name;
+        for (const auto &[key, value]: params) {
+            out << "/" << key << ":" << value;
+        }
+        return out.str();
+    }
+
+    /**
+     * @brief Check whether the benchmark is selected by the filter, to skip its (possibly expensive) setup
+     */
+    bool enabled(const std::string &name, const Params &params) const {
+        return _options.filter.empty() || full_name(name, params).find(_options.filter) != std::string::npos;
+    }
+
+    /**
+     * @brief Run a benchmark, if it is selected by the filter
+     *
+     * @param name Name of the benchmark
+     * @param params Parameters of the benchmark (sizes, ...)
+     * @param body Operation to time, called once per iteration
+     * @param counters (Optional) Called once after the measurements, values reported with the timings (memory, ...)
+     */
+    template<typename Body>
+    void run(const std::string &name, const Params &params, Body &&body, const std::function<Params()> &counters = nullptr) {
+        if (!enabled(name, params)) {
+            return;
+        }
+
+        auto time_batch = [&body](uint64_t iterations) {
+            auto start = std::chrono::steady_clock::now();
+            for (uint64_t i = 0; i < iterations; i++) {
+                body();
+            }
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        };
+
+        // Double the batch until it takes the minimum time, then extrapolate to it
+        uint64_t iterations = 1;
+        double elapsed = time_batch(iterations);
+        while (elapsed < _options.min_time && iterations < (uint64_t(1) << 40)) {
+            uint64_t next = elapsed > 0 ? static_cast<uint64_t>(1.2 * _options.min_time / elapsed * iterations) : iterations * 10;
+            iterations = std::clamp(next, iterations * 2, iterations * 100);
+            elapsed = time_batch(iterations);
+        }
+
+        std::vector<double> ns_per_iteration(std::max(1, _options.repetitions));
+        for (double &ns: ns_per_iteration) {
+            ns = time_batch(iterations) * 1e9 / static_cast<double>(iterations);
+        }
+        std::sort(ns_per_iteration.begin(), ns_per_iteration.end());
+
+        Result result;
+        result.name = name;
+        result.params = params;
+        result.iterations = iterations;
+        result.median_ns = ns_per_iteration[ns_per_iteration.size() / 2];
+        result.min_ns = ns_per_iteration.front();
+        for (double ns: ns_per_iteration) {
+            result.mean_ns += ns / static_cast<double>(ns_per_iteration.size());
+        }
+        if (counters) {
+            result.counters = counters();
+        }
+        _results.push_back(result);
+
+        std::cout << std::fixed << std::setprecision(3)
+                  << "| " << full_name(name, params)
+                  << " | " << iterations
+                  << " | " << result.median_ns * 1e-3
+                  << " | " << result.min_ns * 1e-3
+                  << " | " << result.mean_ns * 1e-3
+                  << " |";
+        for (const auto &[key, value]: result.counters) {
+            std::cout << " " << key << "=" << value;
+        }
+        std::cout << " |" << std::endl;
+    }
+
+    /**
+     * @brief Write the results and the context of the run (date, label, build) to a JSON file
+     */
+    void write_json(const std::string &path) const {
+        std::ofstream file(path);
+        if (!file) {
+            std::cout << "Can't write the benchmark results to " << path << std::endl;
+            return;
+        }
+
+        std::time_t now = std::time(nullptr);
+        char date[32];
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+        file << "{\n  \"context\": {\n"
+             << "    \"date\": \"" << date << "\",\n"
+             << "    \"label\": \"" << _escape(_options.label) << "\",\n"
+#ifdef NDEBUG
+             << "    \"build_type\": \"release\",\n"
+#else
+             << "    \"build_type\": \"debug\",\n"
+#endif
+             << "    \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n"
+             << "    \"min_time\": " << _options.min_time << ",\n"
+             << "    \"repetitions\": " << _options.repetitions << "\n"
+             << "  },\n  \"benchmarks\": [";
+
+        file << std::setprecision(9);
+        for (size_t i = 0; i < _results.size(); i++) {
+            const Result &result = _results[i];
+            file << (i ? ",\n" : "\n") << "    {\"name\": \"" << _escape(full_name(result.name, result.params))
+                 << "\", \"benchmark\": \"" << _escape(result.name) << "\", \"params\": {";
+            for (size_t p = 0; p < result.params.size(); p++) {
+                file << (p ? ", " : "") << "\"" << _escape(result.params[p].first) << "\": " << result.params[p].second;
+            }
+            file << "}, \"iterations\": " << result.iterations
+                 << ", \"median_ns\": " << result.median_ns
+                 << ", \"min_ns\": " << result.min_ns
+                 << ", \"mean_ns\": " << result.mean_ns;
+            if (!result.counters.empty()) {
+                file << ", \"counters\": {";
+                for (size_t c = 0; c < result.counters.size(); c++) {
+                    file << (c ? ", " : "") << "\"" << _escape(result.counters[c].first) << "\": " << result.counters[c].second;
+                }
+                file << "}";
+            }
+            file << "}";
+        }
+        file << "\n  ]\n}\n";
+        std::cout << "Results written to " << path << std::endl;
+    }
+
+private:
+    static std::string _escape(const std::string &text) {
+        std::string escaped;
+        for (char c: text) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+            }
+            if (static_cast<unsigned char>(c) >= 0x20) {
+                escaped += c;
+            }
+        }
+        return escaped;
+    }
+};
@@ -0,0 +1,396 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <opencv2/imgproc.hpp>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+#include "Benchmark.h"
+#include "BoTSORT.h"
+#include "GlobalMotionCompensation.h"
+#include "KalmanFilter.h"
+#include "KalmanFilterAccBased.h"
+#include "SyntheticScene.h"
+#include "matching.h"
+#include "utils.h"
+
+
+/**
+ * @brief Command line options of the benchmark suite
+ */
+struct BenchOptions {
+    BenchmarkRunner::Options runner;
+    std::string config_dir = "../config";
+    std::vector<int> object_counts = {10, 100, 500, 1000};
+    std::vector<int> feature_dims = {128, 512};
+    std::vector<cv::Size> frame_sizes = {{640, 360}, {1280, 720}, {1920, 1080}};
+    SyntheticSceneParams scene;     ///< Scene of the tracker benchmarks, num_targets and frame_size are set per run
+    float crowd_density = 200.0F;   ///< Objects per 1920x1080 area above which the scene grows with the object count
+};
+
+
+/**
+ * @brief Generate pedestrian-like bounding boxes (aspect ratio around 0.4) spread over the frame
+ */
+std::vector<std::vector<float>> generate_boxes(int num_boxes, cv::Size frame_size, std::mt19937 &rng) {
+    std::uniform_real_distribution<float> height_dist(40.0F, 300.0F);
+    std::uniform_real_distribution<float> aspect_dist(0.3F, 0.5F);
+    std::uniform_real_distribution<float> position_dist(0.0F, 1.0F);
+
+    std::vector<std::vector<float>> boxes;
+    for (int i = 0; i < num_boxes; i++) {
+        float height = std::min(height_dist(rng), 0.8F * static_cast<float>(frame_size.height));
+        float width = height * aspect_dist(rng);
+        boxes.push_back({position_dist(rng) * (static_cast<float>(frame_size.width) - width),
+                         position_dist(rng) * (static_cast<float>(frame_size.height) - height),
+                         width,
+                         height});
+    }
+    return boxes;
+}
+
+
+/**
+ * @brief Tracks and detections of a frame: the detections are the (shuffled) track boxes moved by a few pixels,
+ *  so that the cost matrices have the sparse structure of real scenes
+ */
+struct AssociationScene {
+    std::shared_ptr<AppearanceStore> appearance_store;
+    std::vector<std::shared_ptr<Track>> tracks, detections;
+
+    AssociationScene(int num_tracks, int num_detections, int feature_dim, KalmanFilter &kalman_filter, uint32_t seed = 42) {
+        std::mt19937 rng(seed);
+        std::normal_distribution<float> normal(0.0F, 1.0F);
+        auto random_feature = [&]() {
+            FeatureVector feature(feature_dim);
+            for (Eigen::Index i = 0; i < feature.size(); i++) {
+                feature(i) = normal(rng);
+            }
+            return FeatureVector(feature.normalized());
+        };
+
+        appearance_store = std::make_shared<AppearanceStore>(feature_dim, FeaturePrecision::FP32);
+        std::vector<std::vector<float>> boxes = generate_boxes(std::max(num_tracks, num_detections), cv::Size(1920, 1080), rng);
+        for (int i = 0; i < num_tracks; i++) {
+            auto track = std::make_shared<Track>(boxes[i], 0.9F, 0, random_feature(), appearance_store);
+            track->activate(kalman_filter, 1, i + 1);
+            tracks.push_back(track);
+        }
+
+        std::shuffle(boxes.begin(), boxes.end(), rng);
+        for (int i = 0; i < num_detections; i++) {
+            std::vector<float> box = boxes[i];
+            box[0] += 3.0F * normal(rng), box[1] += 3.0F * normal(rng);
+            detections.push_back(std::make_shared<Track>(box, 0.8F, 0, random_feature(), appearance_store));
+        }
+    }
+};
+
+
+/**
+ * @brief Resident memory of the process in bytes (Linux only, 0 elsewhere)
+ */
+size_t resident_memory() {
+#ifdef __linux__
+    std::ifstream statm("/proc/self/statm");
+    size_t total_pages = 0, resident_pages = 0;
+    statm >> total_pages >> resident_pages;
+    return resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
+
+
+/**
+ * @brief Textured frames of a camera panning by a few pixels per frame
+ */
+std::vector<cv::Mat> generate_frames(cv::Size frame_size, int num_frames) {
+    const int max_shift = 4 * num_frames;
+    cv::Mat scene(frame_size.height + max_shift, frame_size.width + max_shift, CV_8UC3);
+    cv::randu(scene, cv::Scalar::all(0), cv::Scalar::all(255));
+    cv::GaussianBlur(scene, scene, cv::Size(7, 7), 2.0);
+
+    std::vector<cv::Mat> frames;
+    for (int f = 0; f < num_frames; f++) {
+        frames.push_back(scene(cv::Rect(3 * f, 2 * f, frame_size.width, frame_size.height)).clone());
+    }
+    return frames;
+}
+
+
+void bench_matching(BenchmarkRunner &runner, const BenchOptions &options) {
+    KalmanFilter kalman_filter(1.0 / 30);
+
+    for (int n: options.object_counts) {
+        BenchmarkRunner::Params params = {{"tracks", n}, {"detections", n}};
+        if (!runner.enabled("iou_distance", params) && !runner.enabled("fuse_motion", params) &&
+            !runner.enabled("fuse_iou_with_emb", params) && !runner.enabled("linear_assignment", params) &&
+            !runner.enabled("lapjv", params)) {
+            continue;
+        }
+        AssociationScene scene(n, n, 128, kalman_filter);
+
+        runner.run("iou_distance", params, [&]() {
+            auto [iou_dists, mask] = iou_distance(scene.tracks, scene.detections, 0.5F);
+            do_not_optimize(iou_dists);
+        });
+
+        CostMatrix iou_dists, iou_dists_mask, emb_dists, emb_dists_mask;
+        std::tie(iou_dists, iou_dists_mask) = iou_distance(scene.tracks, scene.detections, 0.5F);
+        std::tie(emb_dists, emb_dists_mask) = embedding_distance(scene.tracks, scene.detections, 0.25F);
+
+        // The functions below modify the cost matrices in place, the copies are part of the measurement
+        runner.run("fuse_motion", params, [&]() {
+            CostMatrix cost = emb_dists;
+            fuse_motion(kalman_filter, cost, scene.tracks, scene.detections, 0.985F);
+            do_not_optimize(cost);
+        });
+
+        runner.run("fuse_iou_with_emb", params, [&]() {
+            CostMatrix iou = iou_dists, emb = emb_dists;
+            CostMatrix cost = fuse_iou_with_emb(iou, emb, iou_dists_mask, emb_dists_mask);
+            do_not_optimize(cost);
+        });
+
+        runner.run("linear_assignment", params, [&]() {
+            CostMatrix cost = iou_dists;
+            AssociationData associations = linear_assignment(cost, 0.8F);
+            do_not_optimize(associations);
+        });
+
+        runner.run("lapjv", params, [&]() {
+            CostMatrix cost = iou_dists;
+            std::vector<int> rowsol, colsol;
+            double total_cost = lapjv(cost, rowsol, colsol, true, 0.8F);
+            do_not_optimize(total_cost);
+        });
+    }
+
+    for (int feature_dim: options.feature_dims) {
+        for (int n: options.object_counts) {
+            BenchmarkRunner::Params params = {{"tracks", n}, {"detections", n}, {"feature_dim", feature_dim}};
+            if (!runner.enabled("embedding_distance", params)) {
+                continue;
+            }
+            AssociationScene scene(n, n, feature_dim, kalman_filter);
+            EmbeddingDistanceKernel kernel = select_embedding_distance_kernel(feature_dim);
+
+            runner.run("embedding_distance", params, [&]() {
+                auto [emb_dists, mask] = embedding_distance(scene.tracks, scene.detections, 0.25F, kernel);
+                do_not_optimize(emb_dists);
+            });
+        }
+    }
+}
+
+
+template<typename KF>
+void bench_kalman_filter(BenchmarkRunner &runner, const BenchOptions &options, const std::string &name) {
+    KF kalman_filter(1.0 / 30);
+    DetVec detection;
+    detection << 960.0F, 540.0F, 60.0F, 150.0F;
+    const KFDataStateSpace initial_state = kalman_filter.init(detection);
+    DetVec measurement;
+    measurement << 963.0F, 538.0F, 61.0F, 149.0F;
+
+    runner.run(name + "/predict", {}, [&]() {
+        KFStateSpaceVec mean = initial_state.first;
+        KFStateSpaceMatrix covariance = initial_state.second;
+        kalman_filter.predict(mean, covariance);
+        do_not_optimize(mean);
+        do_not_optimize(covariance);
+    });
+
+    runner.run(name + "/update", {}, [&]() {
+        KFDataStateSpace state = kalman_filter.update(initial_state.first, initial_state.second, measurement);
+        do_not_optimize(state);
+    });
+
+    std::mt19937 rng(42);
+    std::normal_distribution<float> normal(0.0F, 20.0F);
+    for (int n: options.object_counts) {
+        std::vector<DetVec> measurements(n, measurement);
+        for (DetVec &m: measurements) {
+            m(0) += normal(rng), m(1) += normal(rng);
+        }
+        runner.run(name + "/gating_distance", {{"measurements", n}}, [&]() {
+            Eigen::Matrix<float, 1, Eigen::Dynamic> distances = kalman_filter.gating_distance(initial_state.first, initial_state.second, measurements);
+            do_not_optimize(distances);
+        });
+    }
+}
+
+
+void bench_gmc(BenchmarkRunner &runner, const BenchOptions &options) {
+    const int num_frames = 16;
+
+    for (const cv::Size &frame_size: options.frame_sizes) {
+        BenchmarkRunner::Params params = {{"width", frame_size.width}, {"height", frame_size.height}};
+        std::vector<cv::Mat> frames;
+
+        // OptFlowModified is a stub returning the identity (with a warning on every call), there is nothing to measure
+        for (const auto &[method_name, method]: GlobalMotionCompensation::GMC_method_map) {
+            if (method == GMC_Method::NoGMC || method == GMC_Method::OptFlowModified ||
+                !runner.enabled("gmc_apply/" + method_name, params)) {
+                continue;
+            }
+            if (frames.empty()) {
+                frames = generate_frames(frame_size, num_frames);
+            }
+
+            std::mt19937 rng(42);
+            std::vector<std::vector<float>> boxes = generate_boxes(50, frame_size, rng);
+            std::vector<Detection> detections;
+            for (const std::vector<float> &box: boxes) {
+                detections.push_back({cv::Rect_<float>(box[0], box[1], box[2], box[3]), 0, 0.9F});
+            }
+
+            // Frames are taken in a forward / backward cycle, so that every call sees a small camera motion
+            GlobalMotionCompensation gmc(method, options.config_dir);
+            size_t call = 0;
+            runner.run("gmc_apply/" + method_name, params, [&]() {
+                size_t position = call++ % (2 * num_frames - 2);
+                size_t index = position < num_frames ? position : 2 * num_frames - 2 - position;
+                HomographyMatrix H = gmc.apply(frames[index], detections);
+                do_not_optimize(H);
+            });
+        }
+    }
+}
+
+
+void bench_tracker(BenchmarkRunner &runner, const BenchOptions &options) {
+    const size_t num_frames = 300;
+
+    for (int n: options.object_counts) {
+        BenchmarkRunner::Params params = {{"objects", n}};
+        if (!runner.enabled("botsort_track", params)) {
+            continue;
+        }
+
+        // Beyond the crowd density, the view grows with the number of objects instead of filling up with occlusions
+        SyntheticSceneParams scene_params = options.scene;
+        const double scale = std::max(1.0, std::sqrt(static_cast<double>(n) / options.crowd_density));
+        scene_params.num_targets = n;
+        scene_params.frame_size = cv::Size(static_cast<int>(1920 * scale), static_cast<int>(1080 * scale));
+        std::vector<SyntheticFrame> sequence = SyntheticScene(scene_params).generate(num_frames, false);
+
+        // The sequence is played forward then backward, so that the motion stays continuous however long it runs
+        auto frame_index = [num_frames](size_t call) {
+            const size_t period = 2 * (num_frames - 1), i = call % period;
+            return i < num_frames ? i : period - i;
+        };
+
+        // GMC is measured on its own, the tracker is run with gmc_method = none and without frames
+        const size_t memory_before = resident_memory();
+        BoTSORT tracker(options.config_dir, "none");
+        for (size_t f = 0; f < 30; f++) {
+            tracker.track(sequence[f].detections, scene_params.frame_size);
+        }
+
+        size_t call = 30;
+        uint64_t num_tracks = 0;
+        runner.run(
+                "botsort_track", params,
+                [&]() {
+                    std::vector<std::shared_ptr<Track>> tracks = tracker.track(sequence[frame_index(call++)].detections, scene_params.frame_size);
+                    num_tracks += tracks.size();
+                    do_not_optimize(tracks);
+                },
+                [&]() -> BenchmarkRunner::Params {
+                    size_t num_detections = 0;
+                    for (const SyntheticFrame &frame: sequence) {
+                        num_detections += frame.detections.size();
+                    }
+                    return {{"detections_per_frame", static_cast<double>(num_detections) / num_frames},
+                            {"tracks_per_frame", static_cast<double>(num_tracks) / static_cast<double>(call - 30)},
+                            {"tracker_memory_mb", (static_cast<double>(resident_memory()) - static_cast<double>(memory_before)) / (1 << 20)}};
+                });
+    }
+}
+
+
+std::vector<int> parse_int_list(const std::string &list) {
+    std::vector<int> values;
+    std::istringstream stream(list);
+    std::string value;
+    while (std::getline(stream, value, ',')) {
+        values.push_back(std::stoi(value));
+    }
+    return values;
+}
+
+
+int main(int argc, char **argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--filter" && has_value) {
+            options.runner.filter = argv[++i];
+        } else if (arg == "--json" && has_value) {
+            options.runner.json_path = argv[++i];
+        } else if (arg == "--label" && has_value) {
+            options.runner.label = argv[++i];
+        } else if (arg == "--min-time" && has_value) {
+            options.runner.min_time = std::stod(argv[++i]);
+        } else if (arg == "--repetitions" && has_value) {
+            options.runner.repetitions = std::stoi(argv[++i]);
+        } else if (arg == "--config" && has_value) {
+            options.config_dir = argv[++i];
+        } else if (arg == "--objects" && has_value) {
+            options.object_counts = parse_int_list(argv[++i]);
+        } else if (arg == "--feature-dims" && has_value) {
+            options.feature_dims = parse_int_list(argv[++i]);
+        } else if (arg == "--motion" && has_value) {
+            std::string model = argv[++i];
+            if (SyntheticScene::motion_model_map.count(model) == 0) {
+                std::cout << "Unknown motion model: " << model << std::endl;
+                return -1;
+            }
+            options.scene.motion_model = SyntheticScene::motion_model_map[model];
+        } else if (arg == "--pan" && has_value) {
+            options.scene.pan_x = std::stof(argv[++i]);
+        } else if (arg == "--density" && has_value) {
+            options.crowd_density = std::stof(argv[++i]);
+        } else if (arg == "--frame-heights" && has_value) {
+            options.frame_sizes.clear();
+            for (int height: parse_int_list(argv[++i])) {
+                options.frame_sizes.emplace_back(height * 16 / 9, height);
+            }
+        } else {
+            std::cout << "Usage: ./botsort_bench [options]\n"
+                      << "  --filter <text>            only run the benchmarks whose name contains the text (e.g. lapjv, gmc_apply/orb)\n"
+                      << "  --json <file>              write the results to a JSON file\n"
+                      << "  --label <text>             label of the run stored in the JSON file (e.g. the commit)\n"
+                      << "  --min-time <s>             minimum time of each measurement (default: 0.1)\n"
+                      << "  --repetitions <n>          measurements per benchmark, the median is reported (default: 5)\n"
+                      << "  --config <dir>             config directory of the tracker and GMC (default: ../config)\n"
+                      << "  --objects <n,...>          track / detection counts (default: 10,100,500,1000)\n"
+                      << "  --feature-dims <n,...>     Re-ID feature dimensions (default: 128,512)\n"
+                      << "  --motion <model>           motion of the synthetic targets: constant_velocity, random_walk, coordinated_turn, mixed (default)\n"
+                      << "  --pan <px>                 horizontal camera pan of the synthetic scene, in pixels per frame (default: 0)\n"
+                      << "  --density <n>              objects per 1080p view before the synthetic scene grows (default: 200)\n"
+                      << "  --frame-heights <h,...>    16:9 frame heights of the GMC benchmarks (default: 360,720,1080)" << std::endl;
+            return arg == "--help" || arg == "-h" ? 0 : -1;
+        }
+    }
+
+    BenchmarkRunner runner(options.runner);
+    bench_matching(runner, options);
+    bench_kalman_filter<bot_kalman::KalmanFilter>(runner, options, "bot_kalman");
+    bench_kalman_filter<acc_kalman::KalmanFilter>(runner, options, "acc_kalman");
+    bench_gmc(runner, options);
+    bench_tracker(runner, options);
+    return 0;
+}
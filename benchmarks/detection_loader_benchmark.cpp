@@ -0,0 +1,95 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "DataType.h"
+#include "DetectionLoader.h"
+
+
+/**
+ * @brief Line-by-line istringstream / std::stof parser of the tracking example, the reference the loader is compared against
+ */
+std::vector<std::vector<Detection>> read_mot_istringstream(const std::string &filepath) {
+    std::vector<std::vector<Detection>> detections_per_frame;
+    std::ifstream file(filepath);
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream iss(line);
+        std::vector<float> values;
+
+        while (std::getline(iss, line, ',')) {
+            values.push_back(std::stof(line));
+        }
+
+        Detection det;
+        int frame_id = static_cast<int>(values[0]);
+        det.class_id = 0;
+        det.bbox_tlwh = cv::Rect_(values[2], values[3], values[4], values[5]);
+        det.confidence = values[6] == 0 ? 1.0F : values[6];
+
+        while (detections_per_frame.size() < frame_id) {
+            detections_per_frame.emplace_back();
+        }
+        detections_per_frame[frame_id - 1].push_back(det);
+    }
+    return detections_per_frame;
+}
+
+
+int main(int argc, char **argv) {
+    const std::string filepath = argc > 1 ? argv[1] : "../examples/data/det/det.txt";
+    const int iterations = argc > 2 ? std::stoi(argv[2]) : 20;
+    const double megabytes = static_cast<double>(std::filesystem::file_size(filepath)) / (1024.0 * 1024.0);
+
+    auto time_ms = [iterations](auto &&fn) {
+        fn();// Warm up, brings the file into the page cache
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            fn();
+        }
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+        return elapsed.count() / iterations;
+    };
+
+    std::vector<std::vector<Detection>> reference;
+    double reference_time = time_ms([&]() { reference = read_mot_istringstream(filepath); });
+
+    size_t num_frames = 0, num_detections = 0;
+    double loader_time = time_ms([&]() {
+        DetectionLoader loader(DetectionFormat::MOT, filepath);
+        num_frames = loader.num_frames();
+        num_detections = loader.num_detections();
+    });
+
+    // Both parsers must produce the same detections
+    DetectionLoader loader(DetectionFormat::MOT, filepath);
+    size_t mismatches = reference.size() == loader.num_frames() ? 0 : 1;
+    for (size_t frame = 0; frame < reference.size() && frame < loader.num_frames(); frame++) {
+        DetectionSpan span = loader.frame(frame);
+        if (span.size() != reference[frame].size()) {
+            mismatches++;
+            continue;
+        }
+        for (size_t i = 0; i < span.size(); i++) {
+            if (span[i].bbox_tlwh != reference[frame][i].bbox_tlwh || span[i].confidence != reference[frame][i].confidence) {
+                mismatches++;
+            }
+        }
+    }
+
+    std::cout << "Detection loader benchmark, " << filepath << " (" << std::fixed << std::setprecision(2) << megabytes << " MB, "
+              << num_frames << " frames, " << num_detections << " detections)" << std::endl;
+    std::cout << "| Parser | Time (ms) | Throughput (MB/s) |" << std::endl;
+    std::cout << "| --- | --- | --- |" << std::endl;
+    std::cout << std::setprecision(3)
+              << "| istringstream + std::stof | " << reference_time << " | " << megabytes / (reference_time / 1000.0) << " |" << std::endl
+              << "| mmap + std::from_chars | " << loader_time << " | " << megabytes / (loader_time / 1000.0) << " |" << std::endl;
+    std::cout << "Speedup: " << reference_time / loader_time << "x, mismatches: " << mismatches << std::endl;
+
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ReIDGallery.h"
+
+
+/**
+ * @brief Generate L2-normalized embeddings around a set of identity centers, so that
+ *  the benchmark data has the cluster structure of real Re-ID embeddings
+ *
+ * @param num_embeddings Number of embeddings to generate
+ * @param centers Identity centers
+ * @param noise Standard deviation of the noise around the centers
+ * @param rng Random number generator
+ * @return FeatureMatrix Embeddings, one per row
+ */
+FeatureMatrix generate_embeddings(Eigen::Index num_embeddings, const FeatureMatrix &centers, float noise, std::mt19937 &rng) {
+    std::normal_distribution<float> normal(0.0F, noise);
+    std::uniform_int_distribution<Eigen::Index> pick_center(0, centers.rows() - 1);
+
+    FeatureMatrix embeddings(num_embeddings, centers.cols());
+    for (Eigen::Index i = 0; i < num_embeddings; i++) {
+        embeddings.row(i) = centers.row(pick_center(rng));
+        for (Eigen::Index j = 0; j < centers.cols(); j++) {
+            embeddings(i, j) += normal(rng);
+        }
+        embeddings.row(i).normalize();
+    }
+    return embeddings;
+}
+
+
+int main(int argc, char **argv) {
+    const int feature_dim = argc > 1 ? std::stoi(argv[1]) : 128;
+    const std::string precision_name = argc > 2 ? argv[2] : "fp16";
+    const std::vector<Eigen::Index> gallery_sizes = {10000, 100000, 1000000};
+    const Eigen::Index num_queries = 1000;
+    const int num_probes = 8;
+
+    std::mt19937 rng(42);
+    std::normal_distribution<float> normal(0.0F, 1.0F);
+
+    std::cout << "Gallery benchmark, feature_dim: " << feature_dim << ", precision: " << precision_name << std::endl;
+    std::cout << "| Entries | Lists | Insert (us/entry) | Query (us/query) | Batched query x16 (us/query) | Recall@1 |" << std::endl;
+    std::cout << "| --- | --- | --- | --- | --- | --- |" << std::endl;
+
+    for (Eigen::Index gallery_size: gallery_sizes) {
+        FeatureMatrix centers(gallery_size / 4, feature_dim);
+        for (Eigen::Index i = 0; i < centers.size(); i++) {
+            centers.data()[i] = normal(rng);
+        }
+        centers.rowwise().normalize();
+
+        FeatureMatrix entries = generate_embeddings(gallery_size, centers, 0.05F, rng);
+        const int num_lists = static_cast<int>(std::sqrt(static_cast<double>(gallery_size)));
+        ReIDGallery gallery(feature_dim,
+                            AppearanceStore::precision_map[precision_name],
+                            gallery_size,
+                            std::numeric_limits<uint32_t>::max(),
+                            num_lists,
+                            num_probes);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (Eigen::Index i = 0; i < gallery_size; i++) {
+            gallery.insert(static_cast<int>(i), entries.row(i), 0);
+        }
+        std::chrono::duration<double, std::micro> insert_time = std::chrono::high_resolution_clock::now() - start;
+
+        // Queries are noisy re-observations of gallery entries
+        std::uniform_int_distribution<Eigen::Index> pick_entry(0, gallery_size - 1);
+        FeatureMatrix queries(num_queries, feature_dim);
+        for (Eigen::Index q = 0; q < num_queries; q++) {
+            queries.row(q) = entries.row(pick_entry(rng));
+            for (Eigen::Index j = 0; j < feature_dim; j++) {
+                queries(q, j) += 0.01F * normal(rng);
+            }
+            queries.row(q).normalize();
+        }
+
+        // Single queries
+        std::vector<int> found(num_queries, -1);
+        start = std::chrono::high_resolution_clock::now();
+        for (Eigen::Index q = 0; q < num_queries; q++) {
+            FeatureMatrix query = queries.row(q);
+            std::vector<std::optional<ReIDGallery::Match>> match = gallery.query(query, 2.0F);
+            found[q] = match[0] ? match[0]->track_id : -1;
+        }
+        std::chrono::duration<double, std::micro> query_time = std::chrono::high_resolution_clock::now() - start;
+
+        // Batched queries, as issued by the tracker for all the new tracks of a frame
+        const Eigen::Index batch_size = 16;
+        start = std::chrono::high_resolution_clock::now();
+        for (Eigen::Index q = 0; q + batch_size <= num_queries; q += batch_size) {
+            FeatureMatrix batch = queries.middleRows(q, batch_size);
+            gallery.query(batch, 2.0F);
+        }
+        std::chrono::duration<double, std::micro> batch_time = std::chrono::high_resolution_clock::now() - start;
+
+        // Recall is measured against the exact nearest neighbour (brute force)
+        int hits = 0;
+        for (Eigen::Index q = 0; q < num_queries; q += batch_size) {
+            const Eigen::Index rows = std::min(batch_size, num_queries - q);
+            CostMatrix similarity = entries * queries.middleRows(q, rows).transpose();
+            for (Eigen::Index i = 0; i < rows; i++) {
+                Eigen::Index nearest;
+                similarity.col(i).maxCoeff(&nearest);
+                hits += found[q + i] == static_cast<int>(nearest);
+            }
+        }
+
+        std::cout << std::fixed << std::setprecision(3)
+                  << "| " << gallery_size
+                  << " | " << num_lists
+                  << " | " << insert_time.count() / gallery_size
+                  << " | " << query_time.count() / num_queries
+                  << " | " << batch_time.count() / ((num_queries / batch_size) * batch_size)
+                  << " | " << static_cast<double>(hits) / num_queries
+                  << " |" << std::endl;
+    }
+
+    return 0;
+}
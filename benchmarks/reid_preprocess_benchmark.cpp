@@ -0,0 +1,129 @@
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <opencv2/imgproc.hpp>
+
+#include "ReIDPreprocessor.h"
+
+
+/**
+ * @brief Generate pedestrian-like bounding boxes (aspect ratio around 0.4) spread over the frame
+ *
+ * @param num_boxes Number of bounding boxes to generate
+ * @param frame_size Size of the frame
+ * @param rng Random number generator
+ * @return std::vector<cv::Rect_<float>> Bounding boxes
+ */
+std::vector<cv::Rect_<float>> generate_bboxes(int num_boxes, cv::Size frame_size, std::mt19937 &rng) {
+    std::uniform_real_distribution<float> height_dist(40.0F, 400.0F);
+    std::uniform_real_distribution<float> aspect_dist(0.3F, 0.5F);
+    std::uniform_real_distribution<float> position_dist(0.0F, 1.0F);
+
+    std::vector<cv::Rect_<float>> bboxes;
+    for (int i = 0; i < num_boxes; i++) {
+        float height = height_dist(rng);
+        float width = height * aspect_dist(rng);
+        float x = position_dist(rng) * (static_cast<float>(frame_size.width) - width);
+        float y = position_dist(rng) * (static_cast<float>(frame_size.height) - height);
+        bboxes.emplace_back(x, y, width, height);
+    }
+    return bboxes;
+}
+
+
+/**
+ * @brief Per-box OpenCV preprocessing, the reference the fused kernel is compared against:
+ *  crop, letterbox resize, pad, BGR to RGB, normalize and split the channels into the NCHW tensor
+ */
+void preprocess_per_box(const cv::Mat &frame, const std::vector<cv::Rect_<float>> &bboxes, cv::Size input_size, std::vector<float> &tensor) {
+    const cv::Scalar mean(0.485, 0.456, 0.406), std(0.229, 0.224, 0.225);
+    const size_t plane = input_size.area();
+    tensor.resize(bboxes.size() * 3 * plane);
+
+    for (size_t i = 0; i < bboxes.size(); i++) {
+        cv::Rect roi = cv::Rect(bboxes[i]) & cv::Rect(0, 0, frame.cols, frame.rows);
+        cv::Mat patch = frame(roi);
+
+        float scale = std::min(static_cast<float>(input_size.width) / static_cast<float>(roi.width),
+                               static_cast<float>(input_size.height) / static_cast<float>(roi.height));
+        int resized_width = std::min(input_size.width, cvRound(roi.width * scale));
+        int resized_height = std::min(input_size.height, cvRound(roi.height * scale));
+        int pad_x = (input_size.width - resized_width) / 2, pad_y = (input_size.height - resized_height) / 2;
+
+        cv::Mat resized, letterboxed, rgb, normalized;
+        cv::resize(patch, resized, cv::Size(resized_width, resized_height), 0, 0, cv::INTER_LINEAR);
+        cv::copyMakeBorder(resized, letterboxed, pad_y, input_size.height - resized_height - pad_y,
+                           pad_x, input_size.width - resized_width - pad_x, cv::BORDER_CONSTANT,
+                           cv::Scalar(mean[2] * 255.0, mean[1] * 255.0, mean[0] * 255.0));
+        cv::cvtColor(letterboxed, rgb, cv::COLOR_BGR2RGB);
+        rgb.convertTo(normalized, CV_32FC3, 1.0 / 255.0);
+        normalized -= mean;
+        normalized /= std;
+
+        std::vector<cv::Mat> channels;
+        for (int c = 0; c < 3; c++) {
+            channels.emplace_back(input_size, CV_32FC1, tensor.data() + (i * 3 + c) * plane);
+        }
+        cv::split(normalized, channels);
+    }
+}
+
+
+int main(int argc, char **argv) {
+    const int iterations = argc > 1 ? std::stoi(argv[1]) : 20;
+    const cv::Size frame_size(1920, 1080), input_size(128, 256);
+    const std::vector<int> box_counts = {50, 100, 200, 500};
+
+    std::mt19937 rng(42);
+    cv::Mat frame(frame_size, CV_8UC3);
+    cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(255));
+
+    ReIDPreprocessor fused_fp32(input_size, false);
+    ReIDPreprocessor fused_fp16(input_size, true);
+    std::vector<float> reference_tensor;
+
+    std::cout << "ReID preprocessing benchmark, 1080p frame, input size: " << input_size.width << "x" << input_size.height
+              << ", threads: " << cv::getNumThreads() << std::endl;
+    std::cout << "| Boxes | Per-box OpenCV (ms) | Fused fp32 (ms) | Fused fp16 (ms) | Speedup fp32 | Max abs diff |" << std::endl;
+    std::cout << "| --- | --- | --- | --- | --- | --- |" << std::endl;
+
+    for (int num_boxes: box_counts) {
+        std::vector<cv::Rect_<float>> bboxes = generate_bboxes(num_boxes, frame_size, rng);
+
+        auto time_ms = [iterations](auto &&fn) {
+            fn();// Warm up, allocates the output buffers
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < iterations; i++) {
+                fn();
+            }
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+            return elapsed.count() / iterations;
+        };
+
+        double reference_time = time_ms([&]() { preprocess_per_box(frame, bboxes, input_size, reference_tensor); });
+        double fp32_time = time_ms([&]() { fused_fp32.run(frame, bboxes); });
+        double fp16_time = time_ms([&]() { fused_fp16.run(frame, bboxes); });
+
+        // Both paths sample with the same bilinear grid, the differences are rounding and the crop of fractional boxes
+        const auto *fused = static_cast<const float *>(fused_fp32.tensor());
+        float max_diff = 0.0F;
+        for (size_t i = 0; i < reference_tensor.size(); i++) {
+            max_diff = std::max(max_diff, std::abs(fused[i] - reference_tensor[i]));
+        }
+
+        std::cout << std::fixed << std::setprecision(3)
+                  << "| " << num_boxes
+                  << " | " << reference_time
+                  << " | " << fp32_time
+                  << " | " << fp16_time
+                  << " | " << reference_time / fp32_time
+                  << " | " << max_diff
+                  << " |" << std::endl;
+    }
+
+    return 0;
+}
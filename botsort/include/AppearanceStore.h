@@ -0,0 +1,156 @@
+#pragma once
+
+#include "DataType.h"
+#include "Snapshot.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+
+enum FeaturePrecision {
+    FP32 = 0,
+    FP16,
+    INT8
+};
+
+
+class AppearanceStore {
+public:
+    using Slot = int32_t;
+    static constexpr Slot INVALID_SLOT = -1;
+    static std::map<std::string, FeaturePrecision> precision_map;
+
+private:
+    int _feature_dim;
+    FeaturePrecision _precision;
+    size_t _slot_bytes;
+
+    std::vector<uint8_t> _arena;
+    std::vector<float> _scales;
+    std::vector<Slot> _free_slots;
+    size_t _num_slots = 0;
+
+    static constexpr Eigen::Index _dequantize_block_rows = 64;
+
+
+public:
+    /**
+     * @brief Construct a new Appearance Store object
+     *  All the features are stored back to back in a single contiguous arena,
+     *  in the given precision (INT8 features carry a per-vector scale)
+     *
+     * @param feature_dim Dimension of the stored features
+     * @param precision Storage precision of the features
+     * @param initial_capacity Number of features to reserve space for
+     */
+    AppearanceStore(int feature_dim, FeaturePrecision precision, size_t initial_capacity = 256);
+    ~AppearanceStore() = default;
+
+    /**
+     * @brief Allocate a slot in the arena, the arena grows if no free slot is available
+     *
+     * @return Slot Allocated slot
+     */
+    Slot allocate();
+
+    /**
+     * @brief Return the slot to the arena so that it can be reused
+     *
+     * @param slot Slot to release
+     */
+    void release(Slot slot);
+
+    /**
+     * @brief Quantize the feature vector and store it in the given slot
+     *
+     * @param slot Slot to store the feature in
+     * @param feature Feature vector with feature_dim elements
+     */
+    void store(Slot slot, const FeatureVector &feature);
+
+    /**
+     * @brief Dequantize the feature stored in the given slot
+     *
+     * @param slot Slot to load the feature from
+     * @return FeatureVector Dequantized feature vector
+     */
+    FeatureVector load(Slot slot) const;
+
+    /**
+     * @brief Write the feature stored in the given slot to a snapshot, as is in its storage precision
+     *
+     * @param slot Slot of the feature
+     * @param writer Snapshot writer
+     */
+    void save_slot(Slot slot, SnapshotWriter &writer) const;
+
+    /**
+     * @brief Read a feature written by save_slot into the given slot (same feature dimension and precision)
+     *
+     * @param slot Slot to store the feature in
+     * @param reader Snapshot reader
+     */
+    void load_slot(Slot slot, SnapshotReader &reader);
+
+    /**
+     * @brief Compute the dot product between the stored features and the query features.
+     *  The stored features are dequantized in small blocks that stay in cache,
+     *  and each block is multiplied with all the queries at once
+     *
+     * @param slots Slots of the stored features (rows of the output)
+     * @param queries Query features, one per row (columns of the output)
+     * @return CostMatrix Dot products with slots.size() rows and queries.rows() columns
+     */
+    CostMatrix dot(const std::vector<Slot> &slots, const Eigen::Ref<const FeatureMatrix> &queries) const;
+
+    /**
+     * @brief Compute the dot product between the features stored in a contiguous range of slots and the query features
+     *
+     * @param first First slot of the range
+     * @param count Number of slots in the range (rows of the output)
+     * @param queries Query features, one per row (columns of the output)
+     * @return CostMatrix Dot products, count x queries.rows()
+     */
+    CostMatrix dot(Slot first, size_t count, const Eigen::Ref<const FeatureMatrix> &queries) const;
+
+    /**
+     * @brief Get the dimension of the stored features
+     */
+    int feature_dim() const;
+
+    /**
+     * @brief Get the storage precision of the features
+     */
+    FeaturePrecision precision() const;
+
+    /**
+     * @brief Get the number of slots currently in use
+     */
+    size_t size() const;
+
+    /**
+     * @brief Get the memory footprint of the arena in bytes
+     */
+    size_t memory_bytes() const;
+
+private:
+    /**
+     * @brief Dequantize the feature stored in the given slot into a float buffer
+     *
+     * @param slot Slot to load the feature from
+     * @param out Output buffer with feature_dim elements
+     */
+    void _dequantize(Slot slot, float *out) const;
+
+    /**
+     * @brief Dequantize the stored features block by block and multiply them with the query features
+     *
+     * @param num_slots Number of stored features (rows of the output)
+     * @param slot_at Function returning the slot of the i-th stored feature
+     * @param queries Query features, one per row (columns of the output)
+     * @return CostMatrix Dot products
+     */
+    template<typename SlotAt>
+    CostMatrix _blocked_dot(Eigen::Index num_slots, SlotAt slot_at, const Eigen::Ref<const FeatureMatrix> &queries) const;
+};
@@ -1,11 +1,22 @@
 #pragma once
 
+#include "EmbeddingCache.h"
 #include "GlobalMotionCompensation.h"
+#include "InputLog.h"
 #include "ReID.h"
+#include "ReIDGallery.h"
+#include "ReIDWorker.h"
+#include "TrackerConfig.h"
+#include "TrackerStats.h"
+#include "matching.h"
 #include "track.h"
 
 
+#include <deque>
+#include <future>
+#include <optional>
 #include <string>
+#include <string_view>
 
 
 class BoTSORT {
@@ -19,13 +30,122 @@ public:
      */
     std::vector<std::shared_ptr<Track>> track(const std::vector<Detection> &detections, const cv::Mat &frame);
 
+    /**
+     * @brief Track the objects without the frame, e.g. when replaying stored detections of a static camera.
+     *  Requires the Re-ID module to be disabled and gmc_method = none, throws std::runtime_error otherwise
+     * 
+     * @param detections Detections in the frame
+     * @param image_size Size of the frame the detections come from
+     * @return std::vector<std::shared_ptr<Track>> 
+     */
+    std::vector<std::shared_ptr<Track>> track(const std::vector<Detection> &detections, const cv::Size &image_size);
+
+    /**
+     * @brief Check whether the configuration allows tracking without frames (Re-ID disabled and gmc_method = none)
+     */
+    bool can_track_without_frames() const;
+
+    /**
+     * @brief Get the usage counters of the embedding reuse cache (all zero if the cache is disabled)
+     * 
+     * @return EmbeddingCache::Stats Lookups, hits (inferences saved) and frames without any inference
+     */
+    EmbeddingCache::Stats embedding_cache_stats() const;
+
+    /**
+     * @brief Get the per-stage latency histograms and counters of track(), collected since the creation of the tracker
+     *  or the last reset_stats(). Empty unless the library is built with BOTSORT_PROFILING (see TrackerStats::enabled)
+     * 
+     * @return const TrackerStats& Statistics, updated by the next track() calls (read them on the tracking thread)
+     */
+    const TrackerStats &stats() const;
+
+    /**
+     * @brief Clear the per-stage statistics, e.g. after a warm-up or at the start of a reporting period
+     */
+    void reset_stats();
+
+    /**
+     * @brief Set the stream ID attached to the trace events of this tracker (see Tracing.h),
+     *  by default the trackers are numbered in their order of creation
+     * 
+     * @param stream_id Stream ID
+     */
+    void set_stream_id(int stream_id);
+
+    /**
+     * @brief Write the complete state of the tracker to a binary snapshot: tracked, lost and unconfirmed tracks
+     *  (Kalman filter state, features, class histories), frame counter, track ID allocator, long-term gallery
+     *  and GMC reference frame data. Features still being extracted by the asynchronous Re-ID worker are not included
+     * 
+     * @param snapshot Output buffer, cleared first (its capacity is reused from one snapshot to the next)
+     */
+    void save_state(std::string &snapshot) const;
+
+    /**
+     * @brief Restore the state of the tracker from a snapshot written by save_state, e.g. after a restart.
+     *  The tracker must have been created with the same config (Re-ID, feature storage and GMC method),
+     *  throws std::runtime_error otherwise or if the snapshot is malformed
+     * 
+     * @param snapshot Snapshot written by save_state
+     */
+    void load_state(std::string_view snapshot);
+
+    /**
+     * @brief Record the inputs of the following track() calls (detections, frame size, timestamp, homography
+     *  and Re-ID features) to a log, along with a hash of their output tracks, to replay them with replay().
+     *  Not supported with asynchronous Re-ID, whose results depend on timing (throws std::runtime_error)
+     * 
+     * @param log_path Path to the log file, truncated
+     */
+    void record_inputs(const std::string &log_path);
+
+    /**
+     * @brief Stop recording the inputs and flush the log
+     */
+    void stop_recording();
+
+    /**
+     * @brief Re-execute a recorded track() call without the frame, the recorded homography and Re-ID features
+     *  replace GMC and the Re-ID model. The tracker must have been created with the same config as the recording one
+     *  (and restored from the same snapshot if it was), throws std::runtime_error if the features do not match it
+     * 
+     * @param inputs Recorded call, read from the log with InputLogReader
+     * @return std::vector<std::shared_ptr<Track>> Output tracks, the same as the recorded ones (see RecordedFrame::output_hash)
+     */
+    std::vector<std::shared_ptr<Track>> replay(const RecordedFrame &inputs);
+
+    /**
+     * @brief Get the dimension of the Re-ID features used by the tracker, to check an input log before replaying it
+     * 
+     * @return int Feature dimension, 0 if the Re-ID module is disabled (as in InputLogReader::feature_dim)
+     */
+    int reid_feature_dim() const;
+
 private:
+    /**
+     * @brief Features of a frame being extracted by the asynchronous Re-ID worker,
+     *  along with the tracks the detections of that frame were associated with
+     */
+    struct PendingFeatures {
+        std::future<FeatureMatrix> features;
+        std::vector<std::weak_ptr<Track>> tracks;///< Track associated with each detection (empty if unassociated)
+        std::vector<bool> new_tracks;            ///< Whether the track was started by the detection
+    };
+
     std::optional<std::string> _reid_model_weights_path;
-    std::string _gmc_method_name;
-    bool _reid_enabled, _fp16_inference;
+    std::string _reid_method_name, _gmc_method_name, _feature_storage_name, _appearance_metric_name;
+    bool _reid_enabled, _reid_async, _fp16_inference, _gallery_enabled, _embedding_cache_enabled;
+    int _reid_feature_dim;
     uint8_t _track_buffer, _frame_rate, _buffer_size, _max_time_lost;
     float _track_high_thresh, _track_low_thresh, _new_track_thresh, _match_thresh, _proximity_thresh, _appearance_thresh, _lambda;
+    size_t _gallery_capacity;
+    float _gallery_ttl, _gallery_match_thresh;
+    int _gallery_num_lists, _gallery_num_probes;
+    float _embedding_cache_iou_thresh, _embedding_cache_max_size_change, _embedding_cache_occlusion_thresh;
+    uint32_t _embedding_cache_max_age;
     unsigned int _frame_id;
+    int _last_track_id = 0;
 
     std::vector<std::shared_ptr<Track>> _tracked_tracks;
     std::vector<std::shared_ptr<Track>> _lost_tracks;
@@ -33,6 +153,18 @@ private:
     std::unique_ptr<KalmanFilter> _kalman_filter;
     std::unique_ptr<GlobalMotionCompensation> _gmc_algo;
     std::unique_ptr<ReIDModel> _reid_model;
+    std::unique_ptr<ReIDWorker> _reid_worker;
+    std::deque<PendingFeatures> _pending_features;
+    static constexpr size_t _max_pending_features = 3;// Frames in flight on the Re-ID worker, further frames get no features
+    std::shared_ptr<AppearanceStore> _appearance_store;
+    std::unique_ptr<ReIDGallery> _gallery;
+    std::unique_ptr<EmbeddingCache> _embedding_cache;
+    std::unique_ptr<InputLogWriter> _input_log;
+    TrackerStats _stats;
+    int _stream_id;
+    EmbeddingDistanceKernel _embedding_distance_kernel = nullptr;
+    GMC_Method _gmc_method;
+    AppearanceMetric _appearance_metric = AppearanceMetric::Smooth;
 
 
 public:
@@ -40,19 +172,66 @@ public:
      * @brief Construct a new BoTSORT object
      * 
      * @param config_path Path to the config directory. If not provided, default path is used (../../config)
+     * @param gmc_method (Optional) GMC method overriding gmc_method of the config (e.g. "none" for static cameras)
+     */
+    explicit BoTSORT(const std::string &config_path = "../../config", const std::optional<std::string> &gmc_method = std::nullopt);
+
+    /**
+     * @brief Construct a new BoTSORT object from parameters held in memory, e.g. a config loaded once
+     *  with TrackerConfig::load and modified with TrackerConfig::set
+     * 
+     * @param config Contents of tracker.ini and gmc.ini
+     * @param gmc_method (Optional) GMC method overriding gmc_method of the config (e.g. "none" for static cameras)
      */
-    explicit BoTSORT(const std::string &config_path = "../../config");
+    explicit BoTSORT(const TrackerConfig &config, const std::optional<std::string> &gmc_method = std::nullopt);
     ~BoTSORT() = default;
 
 private:
     /**
-     * @brief Extract visual features from the given frame and bounding box
+     * @brief Track the objects in the frame
+     * 
+     * @param detections Detections in the frame
+     * @param frame Frame, may be empty if neither Re-ID nor GMC need it
+     * @param image_size Size of the frame, used to clip the detections
+     * @param replayed (Optional) Recorded call providing the homography and Re-ID features, when replaying a log
+     * @return std::vector<std::shared_ptr<Track>> 
+     */
+    std::vector<std::shared_ptr<Track>> _track(const std::vector<Detection> &detections, const cv::Mat &frame, const cv::Size &image_size,
+                                               const RecordedFrame *replayed = nullptr);
+
+    /**
+     * @brief Allocate the ID of a new track
+     * 
+     * @return int Track ID
+     */
+    int _next_track_id();
+
+    /**
+     * @brief Extract visual features from the given frame for all the bounding boxes.
+     *  If the embedding cache is enabled, cached embeddings are reused and the model only runs on the misses
      * 
      * @param frame Input frame
-     * @param bbox_tlwh Bounding box (top, left, width, height)
-     * @return FeatureVector Extracted visual features
+     * @param bboxes Bounding boxes (top, left, width, height)
+     * @param feat_frame_ids Output frame-id at which each feature was extracted by the model
+     * @return FeatureMatrix Extracted visual features, one row per bounding box
+     */
+    FeatureMatrix _extract_features(const cv::Mat &frame, const std::vector<cv::Rect_<float>> &bboxes, std::vector<uint32_t> &feat_frame_ids);
+
+    /**
+     * @brief Apply the features extracted by the asynchronous Re-ID worker to the associated tracks,
+     *  for all the frames whose extraction has completed (in frame order, never blocks)
+     */
+    void _apply_pending_features();
+
+    /**
+     * @brief Re-activate lost tracks with the tracks started while their appearance was not yet available.
+     *  An unconfirmed new track (its ID not output yet) matching a lost track in appearance (and gated by motion)
+     *  is merged back into the lost track, the remaining ones are looked up in the long-term gallery.
+     *  New tracks already confirmed keep their ID
+     * 
+     * @param new_tracks Tracks started by detections whose features just became available
      */
-    FeatureVector _extract_features(const cv::Mat &frame, const cv::Rect_<float> &bbox_tlwh);
+    void _reactivate_lost_tracks(const std::vector<std::shared_ptr<Track>> &new_tracks);
 
     /**
      * @brief Merge the given track lists
@@ -89,9 +268,9 @@ private:
             std::vector<std::shared_ptr<Track>> &tracks_list_b);
 
     /**
-     * @brief Load tracker parameters from the given config file
+     * @brief Load tracker parameters from the given config
      * 
-     * @param config_path Path to the config directory
+     * @param tracker_config Contents of tracker.ini
      */
-    void _load_params_from_config(const std::string &config_path);
+    void _load_params_from_config(const INIReader &tracker_config);
 };
\ No newline at end of file
@@ -11,7 +11,7 @@
 
 
 constexpr uint8_t DET_ELEMENTS = 4;
-constexpr uint8_t FEATURE_DIM = 128;
+constexpr uint16_t FEATURE_DIM = 128;
 constexpr uint8_t KALMAN_STATE_SPACE_DIM = 8;
 constexpr uint8_t KALMAN_MEASUREMENT_SPACE_DIM = 4;
 
@@ -33,16 +33,39 @@ struct Detection {
     float confidence;
 };
 
+/**
+ * @brief Struct representing a ground truth object of a frame
+ *
+ * int id: Identity of the object, constant over the sequence
+ * cv::Rect_<float> bbox_tlwh: Bounding box of the object in the format (top left x, top left y, width, height)
+ * float visibility: Visible fraction of the object in [0, 1] (occlusions, truncation by the frame border)
+ */
+struct GroundTruthObject {
+    int id;
+    cv::Rect_<float> bbox_tlwh;
+    float visibility;
+};
+
 
 // Re-ID Features
 /**
- * @brief Re-ID feature vector with FEATURE_DIM elements.
+ * @brief Re-ID feature vector with Dim elements (Eigen::Dynamic for runtime sized embeddings).
+ */
+template<int Dim>
+using FeatureVectorT = Eigen::Matrix<float, 1, Dim>;
+/**
+ * @brief Re-ID feature matrix with dynamic rows and Dim columns, stored row-major so every feature is contiguous.
+ */
+template<int Dim>
+using FeatureMatrixT = Eigen::Matrix<float, Eigen::Dynamic, Dim, Eigen::RowMajor>;
+/**
+ * @brief Re-ID feature vector, sized at runtime by the output dimension of the Re-ID model.
  */
-using FeatureVector = Eigen::Matrix<float, 1, FEATURE_DIM>;
+using FeatureVector = FeatureVectorT<Eigen::Dynamic>;
 /**
- * @brief Re-ID feature matrix with dynamic rows and FEATURE_DIM columns.
+ * @brief Re-ID feature matrix with dynamic rows and columns.
  */
-using FeatureMatrix = Eigen::Matrix<float, Eigen::Dynamic, FEATURE_DIM>;
+using FeatureMatrix = FeatureMatrixT<Eigen::Dynamic>;
 
 
 // Kalman Filter
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "DataType.h"
+
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+enum DetectionFormat {
+    MOT = 0,
+    YOLO
+};
+
+
+/**
+ * @brief Non-owning view of the detections of a frame, stored contiguously in a DetectionLoader
+ */
+struct DetectionSpan {
+    const Detection *first = nullptr;
+    size_t count = 0;
+
+    const Detection *begin() const { return first; }
+    const Detection *end() const { return first + count; }
+    const Detection &operator[](size_t i) const { return first[i]; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+};
+
+
+class DetectionLoader {
+public:
+    static std::map<std::string, DetectionFormat> format_map;
+    static constexpr uint32_t MAX_FRAME_ID = 10000000;// Over 90 hours at 30 FPS, bounds the per-frame index
+
+private:
+    std::vector<Detection> _detections;
+    std::vector<size_t> _frame_offsets;   // Frame i holds _detections[_frame_offsets[i], _frame_offsets[i + 1])
+    std::vector<std::string> _frame_names;// YOLO only, label file name (without extension) of each frame
+    size_t _bytes_parsed = 0;
+
+
+public:
+    /**
+     * @brief Construct a new Detection Loader object
+     *  Loads all the detections of a sequence at once: the files are memory-mapped, parsed with std::from_chars
+     *  and the detections of all the frames are stored back to back, indexed by frame
+     *
+     * @param format DetectionFormat enum member for the input format
+     * @param path MOT: detection / ground truth file (frame,id,left,top,width,height,score,...).
+     *  YOLO: directory with one label file per frame (class cx cy w h score, normalized), sorted by name
+     * @param frame_width Image width (YOLO only, used to convert normalized bounding boxes to absolute coordinates)
+     * @param frame_height Image height (YOLO only, used to convert normalized bounding boxes to absolute coordinates)
+     * @param class_id (Optional) YOLO only, keep only the detections of this class
+     */
+    DetectionLoader(DetectionFormat format,
+                    const std::string &path,
+                    int frame_width = 0,
+                    int frame_height = 0,
+                    std::optional<int> class_id = std::nullopt);
+    ~DetectionLoader() = default;
+
+    /**
+     * @brief Get the detections of a frame
+     *
+     * @param frame_index 0-based frame index (MOT frame-id - 1, or position of the YOLO label file)
+     * @return DetectionSpan Detections of the frame, empty if the index is out of range
+     */
+    DetectionSpan frame(size_t frame_index) const;
+
+    /**
+     * @brief Get the index of the frame of a YOLO label file
+     *
+     * @param name Label file name without extension
+     * @return std::optional<size_t> Frame index (nullopt if there is no such label file)
+     */
+    std::optional<size_t> frame_index(const std::string &name) const;
+
+    /**
+     * @brief Get the number of frames (MOT: highest frame-id)
+     */
+    size_t num_frames() const;
+
+    /**
+     * @brief Get the total number of detections
+     */
+    size_t num_detections() const;
+
+    /**
+     * @brief Get the number of bytes parsed
+     */
+    size_t bytes_parsed() const;
+
+    /**
+     * @brief Convert the first column of a MOTChallenge line to a frame-id, throws std::runtime_error
+     *  if it is not an integer in [1, MAX_FRAME_ID]
+     *
+     * @param value Parsed value of the column
+     * @param path File being parsed, for the error message
+     * @param line_number 1-based line number, for the error message
+     * @return uint32_t Frame-id
+     */
+    static uint32_t mot_frame_id(float value, const std::string &path, size_t line_number);
+
+private:
+    /**
+     * @brief Parse a MOTChallenge file, frames are indexed in a single pass (unless the file is not sorted by frame)
+     */
+    void _load_mot(const std::string &filepath);
+
+    /**
+     * @brief Parse the YOLO label files of a directory, one frame per file
+     */
+    void _load_yolo(const std::string &dirpath, int frame_width, int frame_height, std::optional<int> class_id);
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "track.h"
+
+#include <memory>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+
+class EmbeddingCache {
+public:
+    /**
+     * @brief Cache usage counters
+     */
+    struct Stats {
+        uint64_t lookups = 0;        ///< Detections looked up in the cache
+        uint64_t hits = 0;           ///< Detections whose embedding was reused, i.e. model inferences saved
+        uint64_t skipped_batches = 0;///< Frames on which the model did not run at all
+
+        /**
+         * @brief Get the fraction of the lookups that were hits
+         */
+        double hit_rate() const;
+    };
+
+private:
+    float _iou_thresh, _max_size_change, _occlusion_thresh;
+    uint32_t _max_age;
+    Stats _stats;
+
+
+public:
+    /**
+     * @brief Construct a new Embedding Cache object
+     *  A detection reuses the embedding of the track it overlaps almost exactly, as long as
+     *  that embedding was extracted recently and the detection is not occluded by another one
+     *
+     * @param iou_thresh Minimum IoU between the detection and the latest detection box of the track
+     * @param max_age Maximum number of frames since the model extracted the embedding of the track
+     * @param max_size_change Maximum relative change of the width or height of the box
+     * @param occlusion_thresh Maximum fraction of the detection covered by any other detection
+     */
+    EmbeddingCache(float iou_thresh = 0.9F, uint32_t max_age = 5, float max_size_change = 0.05F, float occlusion_thresh = 0.1F);
+    ~EmbeddingCache() = default;
+
+    /**
+     * @brief Find, for every detection, the track whose embedding can be reused
+     *
+     * @param bboxes Detection bounding boxes (top left x, top left y, width, height)
+     * @param tracks Currently tracked tracks
+     * @param frame_id Current frame-id
+     * @return std::vector<std::shared_ptr<Track>> Track to reuse the embedding (curr_feat) of, nullptr on a miss
+     */
+    std::vector<std::shared_ptr<Track>> lookup(const std::vector<cv::Rect_<float>> &bboxes,
+                                               const std::vector<std::shared_ptr<Track>> &tracks,
+                                               uint32_t frame_id);
+
+    /**
+     * @brief Get the cache usage counters
+     */
+    const Stats &stats() const;
+
+    /**
+     * @brief Reset the cache usage counters
+     */
+    void reset_stats();
+
+private:
+    /**
+     * @brief Flag the detections which are covered by another detection by more than occlusion_thresh
+     */
+    std::vector<bool> _find_occluded(const std::vector<cv::Rect_<float>> &bboxes) const;
+};
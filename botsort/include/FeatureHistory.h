@@ -0,0 +1,89 @@
+#pragma once
+
+#include "AppearanceStore.h"
+#include "DataType.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+
+enum AppearanceMetric {
+    Smooth = 0,
+    HistoryMin,
+    HistoryMean
+};
+
+
+class FeatureHistory {
+public:
+    static std::map<std::string, AppearanceMetric> metric_map;
+
+private:
+    AppearanceStore _features;
+    size_t _capacity;
+    size_t _size = 0;
+    size_t _oldest = 0;
+
+
+public:
+    /**
+     * @brief Construct a new Feature History object
+     *  Fixed-capacity ring buffer of the latest features of a track. The features are stored back to back
+     *  in a single block owned by the track, which grows up to the capacity and is then overwritten in place.
+     *  The i-th slot of the block holds the i-th feature of the ring
+     *
+     * @param feature_dim Dimension of the features
+     * @param precision Storage precision of the features
+     * @param capacity Maximum number of features kept
+     */
+    FeatureHistory(int feature_dim, FeaturePrecision precision, size_t capacity);
+    ~FeatureHistory() = default;
+
+    /**
+     * @brief Add a feature to the history, replacing the oldest one if the history is full
+     *
+     * @param feature L2-normalized feature vector
+     */
+    void push(const FeatureVector &feature);
+
+    /**
+     * @brief Get the minimum cosine distance between the features in the history and each query
+     *
+     * @param queries L2-normalized query features, one per row
+     * @return Eigen::RowVectorXf Distance for each query
+     */
+    Eigen::RowVectorXf min_distance(const Eigen::Ref<const FeatureMatrix> &queries) const;
+
+    /**
+     * @brief Get the mean cosine distance between the features in the history and each query
+     *
+     * @param queries L2-normalized query features, one per row
+     * @return Eigen::RowVectorXf Distance for each query
+     */
+    Eigen::RowVectorXf mean_distance(const Eigen::Ref<const FeatureMatrix> &queries) const;
+
+    /**
+     * @brief Write the features of the history to a snapshot, oldest first
+     *
+     * @param writer Snapshot writer
+     */
+    void save_state(SnapshotWriter &writer) const;
+
+    /**
+     * @brief Replace the features of the history with the ones of a snapshot written by save_state
+     *
+     * @param reader Snapshot reader
+     */
+    void load_state(SnapshotReader &reader);
+
+    /**
+     * @brief Get the number of features in the history
+     */
+    size_t size() const;
+
+    /**
+     * @brief Get the maximum number of features in the history
+     */
+    size_t capacity() const;
+};
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "DataType.h"
+#include "INIReader.h"
+#include "Snapshot.h"
 
 #include <map>
 #include <numeric>
@@ -20,7 +22,8 @@ enum GMC_Method {
     ECC,
     SparseOptFlow,
     OptFlowModified,
-    OpenCV_VideoStab
+    OpenCV_VideoStab,
+    NoGMC
 };
 
 
@@ -28,6 +31,10 @@ class GMC_Algorithm {
 public:
     virtual ~GMC_Algorithm() = default;
     virtual HomographyMatrix apply(const cv::Mat &frame_raw, const std::vector<Detection> &detections) = 0;
+
+    // Reference frame data (previous frame, keypoints, ...), nothing for the stateless algorithms
+    virtual void save_state(SnapshotWriter &writer) const {}
+    virtual void load_state(SnapshotReader &reader) {}
 };
 
 class ORB_GMC : public GMC_Algorithm {
@@ -47,11 +54,13 @@ private:
 
 
 private:
-    void _load_params_from_config(const std::string &config_dir);
+    void _load_params_from_config(const INIReader &gmc_config);
 
 public:
-    explicit ORB_GMC(const std::string &config_dir);
+    explicit ORB_GMC(const INIReader &gmc_config);
     HomographyMatrix apply(const cv::Mat &frame_raw, const std::vector<Detection> &detections) override;
+    void save_state(SnapshotWriter &writer) const override;
+    void load_state(SnapshotReader &reader) override;
 };
 
 class ECC_GMC : public GMC_Algorithm {
@@ -67,11 +76,13 @@ private:
 
 
 private:
-    void _load_params_from_config(const std::string &config_dir);
+    void _load_params_from_config(const INIReader &gmc_config);
 
 public:
-    explicit ECC_GMC(const std::string &config_dir);
+    explicit ECC_GMC(const INIReader &gmc_config);
     HomographyMatrix apply(const cv::Mat &frame_raw, const std::vector<Detection> &detections) override;
+    void save_state(SnapshotWriter &writer) const override;
+    void load_state(SnapshotReader &reader) override;
 };
 
 class SparseOptFlow_GMC : public GMC_Algorithm {
@@ -91,11 +102,13 @@ private:
 
 
 private:
-    void _load_params_from_config(const std::string &config_dir);
+    void _load_params_from_config(const INIReader &gmc_config);
 
 public:
-    explicit SparseOptFlow_GMC(const std::string &config_dir);
+    explicit SparseOptFlow_GMC(const INIReader &gmc_config);
     HomographyMatrix apply(const cv::Mat &frame_raw, const std::vector<Detection> &detections) override;
+    void save_state(SnapshotWriter &writer) const override;
+    void load_state(SnapshotReader &reader) override;
 };
 
 class OptFlowModified_GMC : public GMC_Algorithm {
@@ -105,10 +118,10 @@ private:
 
 
 private:
-    void _load_params_from_config(const std::string &config_dir);
+    void _load_params_from_config(const INIReader &gmc_config);
 
 public:
-    explicit OptFlowModified_GMC(const std::string &config_dir);
+    explicit OptFlowModified_GMC(const INIReader &gmc_config);
     HomographyMatrix apply(const cv::Mat &frame_raw, const std::vector<Detection> &detections) override;
 };
 
@@ -127,10 +140,18 @@ private:
 
 
 private:
-    void _load_params_from_config(const std::string &config_dir);
+    void _load_params_from_config(const INIReader &gmc_config);
+
+public:
+    explicit OpenCV_VideoStab_GMC(const INIReader &gmc_config);
+    HomographyMatrix apply(const cv::Mat &frame_raw, const std::vector<Detection> &detections) override;
+    void save_state(SnapshotWriter &writer) const override;
+    void load_state(SnapshotReader &reader) override;
+};
 
+class None_GMC : public GMC_Algorithm {
 public:
-    explicit OpenCV_VideoStab_GMC(const std::string &config_dir);
+    None_GMC() = default;
     HomographyMatrix apply(const cv::Mat &frame_raw, const std::vector<Detection> &detections) override;
 };
 
@@ -138,10 +159,16 @@ public:
 class GlobalMotionCompensation {
 public:
     static std::map<std::string, GMC_Method> GMC_method_map;
+    static std::map<GMC_Method, std::string> GMC_section_map;// Section of the parameters of each method in gmc.ini
 
 private:
     std::unique_ptr<GMC_Algorithm> _gmc_algorithm;
 
+    /**
+     * @brief Read gmc.ini, exits if it can not be read and the method needs it
+     */
+    static INIReader _load_config(GMC_Method method, const std::string &config_dir);
+
 
 public:
     /**
@@ -151,6 +178,14 @@ public:
      * @param config_dir Directory containing config files for GMC algorithm
      */
     explicit GlobalMotionCompensation(GMC_Method method, const std::string &config_dir);
+
+    /**
+     * @brief Construct a new Global Motion Compensation object from parameters held in memory
+     * 
+     * @param method GMC_Method enum member for GMC algorithm to use
+     * @param gmc_config Contents of gmc.ini (the defaults are used for the missing parameters)
+     */
+    GlobalMotionCompensation(GMC_Method method, const INIReader &gmc_config);
     ~GlobalMotionCompensation() = default;
 
     /**
@@ -161,4 +196,19 @@ public:
      * @return HomographyMatrix Predicted homography matrix
      */
     HomographyMatrix apply(const cv::Mat &frame_raw, const std::vector<Detection> &detections);
+
+    /**
+     * @brief Write the reference frame data of the GMC algorithm to a snapshot
+     * 
+     * @param writer Snapshot writer
+     */
+    void save_state(SnapshotWriter &writer) const;
+
+    /**
+     * @brief Restore the reference frame data of the GMC algorithm from a snapshot written by save_state
+     *  (with the same GMC method)
+     * 
+     * @param reader Snapshot reader
+     */
+    void load_state(SnapshotReader &reader);
 };
\ No newline at end of file
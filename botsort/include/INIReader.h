@@ -294,6 +294,7 @@ inline int ini_parse(const char *filename, ini_handler handler, void *user) {
 #define __INIREADER_H__
 
 #include <map>
+#include <optional>
 #include <set>
 #include <string>
 
@@ -347,8 +348,11 @@ public:
     // and valid false values are "false", "no", "off", "0" (not case sensitive).
     bool GetBoolean(const std::string &section, const std::string &name, bool default_value) const;
 
+    // Set a value, replacing the value read from the INI file (if any)
+    void Set(const std::string &section, const std::string &name, const std::string &value);
+
 protected:
-    int _error;
+    int _error = 0;
     std::map<std::string, std::string> _values;
     std::set<std::string> _sections;
     static std::string MakeKey(const std::string &section, const std::string &name);
@@ -431,6 +435,11 @@ inline bool INIReader::GetBoolean(const std::string &section, const std::string
         return default_value;
 }
 
+inline void INIReader::Set(const std::string &section, const std::string &name, const std::string &value) {
+    _values[MakeKey(section, name)] = value;
+    _sections.insert(section);
+}
+
 inline std::string INIReader::MakeKey(const std::string &section, const std::string &name) {
     std::string key = section + "=" + name;
     // Convert to lower case to make section/name lookups case-insensitive
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+
+class ImageSequenceReader {
+private:
+    struct Slot {
+        cv::Mat frame;
+        bool ready = false;
+    };
+
+    std::vector<std::string> _filepaths;
+    std::vector<Slot> _slots;// Frame i is decoded into _slots[i % _slots.size()]
+    size_t _next_to_decode = 0, _next_to_read = 0;
+
+    bool _stop = false;
+    std::mutex _mutex;
+    std::condition_variable _slot_free, _slot_ready;
+    std::vector<std::thread> _workers;
+
+
+public:
+    /**
+     * @brief Construct a new Image Sequence Reader object
+     *  Decodes the next images of the sequence ahead of time on a pool of threads, into a fixed set of
+     *  slots which are reused as frames are read. Frames are always returned in sequence order
+     *
+     * @param filepaths Image files, in sequence order
+     * @param prefetch_size Number of frames decoded ahead of the one being read
+     * @param num_threads Number of decoding threads (0: one per hardware thread, up to prefetch_size)
+     */
+    explicit ImageSequenceReader(std::vector<std::string> filepaths, size_t prefetch_size = 8, unsigned int num_threads = 0);
+
+    /**
+     * @brief Stop the decoding threads, frames being decoded are completed first
+     */
+    ~ImageSequenceReader();
+
+    ImageSequenceReader(const ImageSequenceReader &) = delete;
+    ImageSequenceReader &operator=(const ImageSequenceReader &) = delete;
+
+    /**
+     * @brief Get the next frame of the sequence, blocks until it is decoded
+     *
+     * @param frame Output frame (BGR), empty if the image could not be read or decoded
+     * @return true if a frame was returned, false at the end of the sequence
+     */
+    bool read(cv::Mat &frame);
+
+    /**
+     * @brief Get the number of images in the sequence
+     */
+    size_t size() const;
+
+    /**
+     * @brief Get the file of the image at the given position in the sequence
+     */
+    const std::string &filepath(size_t index) const;
+
+private:
+    /**
+     * @brief Decoding thread loop
+     */
+    void _run();
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "DataType.h"
+#include "MappedFile.h"
+#include "Snapshot.h"
+#include "track.h"
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+/**
+ * @brief Binary log of the inputs of the track() calls (native byte order, written with SnapshotWriter)
+ *
+ *  File header: magic "BTIL", uint32 version, int64 feature dimension (0 if recorded without Re-ID)
+ *  Per track() call: uint32 frame-id, int64 timestamp (ns since epoch), int64 duration of the call (ns),
+ *      int32 width, int32 height, the homography applied by GMC (3x3 matrix), the clipped detections,
+ *      the Re-ID features of the detections above track_low_thresh and the frame-id at which each was extracted,
+ *      then the number of output tracks and a hash of the output tracks (see input_log::hash_tracks)
+ */
+namespace input_log {
+constexpr char MAGIC[4] = {'B', 'T', 'I', 'L'};
+constexpr uint32_t VERSION = 1;
+
+/**
+ * @brief FNV-1a hash of the output tracks (ID, box, score and class), to check that a replay reproduces them
+ *
+ * @param tracks Output tracks of a track() call
+ * @return uint64_t Hash of the tracks, in order
+ */
+uint64_t hash_tracks(const std::vector<std::shared_ptr<Track>> &tracks);
+}// namespace input_log
+
+
+/**
+ * @brief Inputs (and a digest of the outputs) of one track() call
+ */
+struct RecordedFrame {
+    uint32_t frame_id = 0;
+    int64_t timestamp_ns = 0;
+    int64_t duration_ns = 0;
+    cv::Size image_size;
+    HomographyMatrix homography = HomographyMatrix::Identity();
+    std::vector<Detection> detections;
+    FeatureMatrix features;             ///< Empty without Re-ID
+    std::vector<uint32_t> feat_frame_ids;///< Frame-id at which each feature was extracted (embedding cache)
+    uint32_t num_output_tracks = 0;
+    uint64_t output_hash = 0;
+};
+
+
+/**
+ * @brief Appends the recorded track() calls to a log file, throws std::runtime_error if it can not be written
+ */
+class InputLogWriter {
+private:
+    std::ofstream _file;
+    std::string _buffer;
+    static constexpr size_t _flush_size = 1 << 20;
+
+
+public:
+    /**
+     * @brief Construct a new Input Log Writer object, truncates the file and writes the file header
+     *
+     * @param path Path to the log file
+     * @param feature_dim Dimension of the Re-ID features (0 if Re-ID is disabled)
+     */
+    InputLogWriter(const std::string &path, int feature_dim);
+    ~InputLogWriter();
+
+    InputLogWriter(const InputLogWriter &) = delete;
+    InputLogWriter &operator=(const InputLogWriter &) = delete;
+
+    /**
+     * @brief Append a track() call, written out in blocks of about 1 MB
+     */
+    void write(const RecordedFrame &frame);
+
+    /**
+     * @brief Write the buffered calls to the file
+     */
+    void flush();
+};
+
+
+/**
+ * @brief Reads the track() calls of a log back in order, throws std::runtime_error if it is malformed
+ */
+class InputLogReader {
+private:
+    MappedFile _file;
+    SnapshotReader _reader;
+    int _feature_dim = 0;
+
+
+public:
+    /**
+     * @brief Construct a new Input Log Reader object, maps the file and checks its header
+     *
+     * @param path Path to the log file
+     */
+    explicit InputLogReader(const std::string &path);
+
+    /**
+     * @brief Read the next track() call
+     *
+     * @param frame Output call, its buffers are reused
+     * @return true if a call was read, false at the end of the log
+     */
+    bool next(RecordedFrame &frame);
+
+    /**
+     * @brief Dimension of the recorded Re-ID features (0 if recorded without Re-ID)
+     */
+    int feature_dim() const { return _feature_dim; }
+};
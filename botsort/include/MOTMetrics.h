@@ -0,0 +1,159 @@
+#pragma once
+
+#include "DataType.h"
+#include "track.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+/**
+ * @brief Parameters of the MOT metrics evaluation
+ */
+struct MOTMetricsParams {
+    float iou_threshold = 0.5F;  ///< Minimum IoU of a match (CLEAR MOT, IDF1), 0.5 like py-motmetrics
+    float min_visibility = 0.0F; ///< Ground truth less visible than this is ignored, along with the tracks matching it
+    bool compute_hota = true;    ///< HOTA keeps the overlaps of every frame until compute()
+};
+
+
+/**
+ * @brief Accuracy of a tracker over a sequence, named like the output of mot_metrics_evaluator.py.
+ *  Ratios are in [0, 1] (MOTA can be negative), MOTP is the mean 1 - IoU of the matches like py-motmetrics
+ */
+struct MOTMetrics {
+    uint64_t num_frames = 0;
+    uint64_t num_objects = 0;       ///< Ground truth boxes (GT)
+    uint64_t num_predictions = 0;   ///< Track boxes
+    uint64_t num_matches = 0;
+    uint64_t num_false_positives = 0, num_misses = 0, num_switches = 0, num_fragmentations = 0;
+    uint64_t num_unique_objects = 0;
+    uint64_t mostly_tracked = 0, partially_tracked = 0, mostly_lost = 0;
+    double mota = 0, motp = 0, precision = 0, recall = 0;
+    double idf1 = 0, idp = 0, idr = 0;
+    double hota = 0, deta = 0, assa = 0, loca = 0;
+
+    /**
+     * @brief Markdown table of the metrics
+     */
+    std::string summary() const;
+};
+
+
+/**
+ * @brief In-process MOT metrics: CLEAR MOT (MOTA, MOTP, ID switches, fragmentations), identity metrics
+ *  (IDF1, IDP, IDR) and HOTA (DetA, AssA, LocA, averaged over the IoU thresholds 0.05 to 0.95).
+ *  Frames are accumulated one at a time, the assignments are solved with linear_assignment (lapjv) on each
+ *  connected component of the overlap graph, so that the cost of a frame grows with the crowd density only
+ */
+class MOTMetricsEvaluator {
+public:
+    static constexpr int NUM_HOTA_THRESHOLDS = 19;
+
+private:
+    struct Box {
+        int id;
+        cv::Rect_<float> tlwh;
+    };
+
+    struct Overlap {
+        int gt_index, pred_index;// Dense indices of the identities, see _gt_index and _pred_index
+        float iou;
+    };
+
+    MOTMetricsParams _params;
+    MOTMetrics _counts;// Counters accumulated by update(), the ratios are computed by compute()
+    double _distance_sum = 0;
+
+    // Identities, by order of appearance
+    std::unordered_map<int, int> _gt_index, _pred_index;
+    std::vector<uint32_t> _gt_frames, _pred_frames;   // Frames in which each identity is present
+    std::vector<uint32_t> _gt_matched_frames;         // Frames in which each ground truth object is matched (CLEAR MOT)
+    std::vector<int> _last_match;                     // Last track matched to each ground truth object, -1 if none
+    std::vector<uint8_t> _lost_since_match;           // Unmatched since its last match (fragmentation)
+    std::unordered_map<uint64_t, uint32_t> _id_overlap_frames;// Frames with IoU >= threshold of each (gt, track) pair (IDF1)
+
+    // HOTA is computed in two passes over the frames: the overlaps are kept
+    std::vector<std::vector<Overlap>> _frame_overlaps;
+
+
+public:
+    explicit MOTMetricsEvaluator(const MOTMetricsParams &params = MOTMetricsParams());
+    ~MOTMetricsEvaluator() = default;
+
+    /**
+     * @brief Accumulate a frame
+     *
+     * @param ground_truth Ground truth objects of the frame
+     * @param tracks Tracks returned by the tracker for the frame
+     */
+    void update(const std::vector<GroundTruthObject> &ground_truth, const std::vector<std::shared_ptr<Track>> &tracks);
+
+    /**
+     * @brief Accumulate a frame whose tracks were loaded from a file (see load_mot_file), the visibility is ignored
+     */
+    void update(const std::vector<GroundTruthObject> &ground_truth, const std::vector<GroundTruthObject> &tracks);
+
+    /**
+     * @brief Compute the metrics of the frames accumulated so far
+     */
+    MOTMetrics compute() const;
+
+    void reset();
+
+    /**
+     * @brief Add the frames accumulated by another evaluator, e.g. to compute the metrics over several sequences
+     *  evaluated in parallel. Their identities are kept apart, the next update() calls continue the sequence of this
+     *  evaluator. Throws std::runtime_error if the evaluators do not both compute HOTA
+     *
+     * @param other Evaluator of another sequence
+     */
+    void merge(const MOTMetricsEvaluator &other);
+
+    /**
+     * @brief Load a MOTChallenge ground truth (frame,id,left,top,width,height,mark,class,visibility)
+     *  or tracker output file (frame,id,left,top,width,height,...), throws std::runtime_error if it can not be read
+     *  or a frame-id is invalid (see DetectionLoader::mot_frame_id)
+     *
+     * @param path Path to the file
+     * @return std::vector<std::vector<GroundTruthObject>> Objects of each frame (index frame - 1),
+     *  visibility is 1 when the 9th column is absent or out of [0, 1]
+     */
+    static std::vector<std::vector<GroundTruthObject>> load_mot_file(const std::string &path);
+
+private:
+    /**
+     * @brief Accumulate a frame, the tracks matching ignored ground truth objects are removed first
+     */
+    void _update(const std::vector<Box> &ground_truth, const std::vector<Box> &ignored, std::vector<Box> &tracks);
+
+    /**
+     * @brief Pairs of ground truth and track boxes overlapping with IoU >= min_iou (sweep over the boxes sorted by left edge)
+     */
+    static std::vector<Overlap> _overlaps(const std::vector<Box> &ground_truth, const std::vector<Box> &tracks, float min_iou);
+
+    /**
+     * @brief Maximum weight matching of a sparse bipartite graph, solved with linear_assignment on each connected component
+     *
+     * @param num_rows Number of rows
+     * @param num_cols Number of columns
+     * @param edges Candidate pairs (row, column) and their weights, only pairs with a positive weight can be matched
+     * @return std::vector<std::pair<int, int>> Matched (row, column) pairs
+     */
+    static std::vector<std::pair<int, int>> _max_weight_matching(int num_rows, int num_cols,
+                                                                 const std::vector<std::pair<std::pair<int, int>, float>> &edges);
+
+    static uint64_t _pair_key(int gt_index, int pred_index) {
+        return (static_cast<uint64_t>(gt_index) << 32) | static_cast<uint32_t>(pred_index);
+    }
+
+    int _gt_identity(int id);
+    int _pred_identity(int id);
+
+    void _compute_idf1(MOTMetrics &metrics) const;
+    void _compute_hota(MOTMetrics &metrics) const;
+};
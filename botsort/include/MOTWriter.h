@@ -0,0 +1,94 @@
+#pragma once
+
+#include "track.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+class MOTWriter {
+private:
+    std::string _path;
+    std::ofstream _file;
+    size_t _block_size;
+
+    std::string _buffer;             // Block being formatted on the caller thread
+    std::deque<std::string> _blocks; // Blocks waiting to be written
+    std::vector<std::string> _spares;// Written blocks, recycled to avoid reallocations
+    bool _writing = false;
+    bool _stop = false;
+    std::atomic<bool> _failed{false};// Set by the background thread when the file can't be written
+    std::mutex _mutex;
+    std::condition_variable _block_available, _block_written;
+    std::thread _thread;
+
+    static constexpr size_t _max_pending_blocks = 4;// The caller blocks when the disk can not keep up
+    static constexpr size_t _max_line_size = 128;
+
+
+public:
+    /**
+     * @brief Construct a new MOT Writer object
+     *  Writes tracks in MOTChallenge format (frame,id,left,top,width,height,-1,-1,-1,0), with the same text as
+     *  std::ostream with its default formatting. Lines are formatted with std::to_chars into a large block,
+     *  full blocks are written by a background thread. Throws std::runtime_error if the file can not be opened
+     *
+     * @param output_file Output file, kept open until the writer is destroyed
+     * @param append Whether to append to the file instead of truncating it
+     * @param block_size Size of the blocks handed to the background thread in bytes
+     */
+    explicit MOTWriter(const std::string &output_file, bool append = false, size_t block_size = 1 << 20);
+
+    /**
+     * @brief Write the remaining lines and close the file, a write failure is reported on stderr
+     */
+    ~MOTWriter();
+
+    MOTWriter(const MOTWriter &) = delete;
+    MOTWriter &operator=(const MOTWriter &) = delete;
+
+    /**
+     * @brief Write one line per track. Throws std::runtime_error if writing a previous block failed
+     *
+     * @param tracks Tracks returned by the tracker for the current frame
+     */
+    void write(const std::vector<std::shared_ptr<Track>> &tracks);
+
+    /**
+     * @brief Write a single line. Throws std::runtime_error if writing a previous block failed
+     *
+     * @param frame_id Frame-id
+     * @param track_id Track ID
+     * @param tlwh Bounding box (top left x, top left y, width, height)
+     */
+    void write(uint32_t frame_id, int track_id, const float tlwh[4]);
+
+    /**
+     * @brief Write everything formatted so far to the file and wait for it to complete.
+     *  Throws std::runtime_error if the file could not be written (e.g. disk full)
+     */
+    void flush();
+
+private:
+    /**
+     * @brief Hand the current block to the background thread and start a new one
+     */
+    void _submit_block();
+
+    /**
+     * @brief Throw std::runtime_error if the background thread failed to write a block
+     */
+    void _check_failure() const;
+
+    /**
+     * @brief Writer thread loop
+     */
+    void _run();
+};
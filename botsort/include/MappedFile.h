@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+
+class MappedFile {
+private:
+    const char *_data = nullptr;
+    size_t _size = 0;
+
+
+public:
+    /**
+     * @brief Construct a new Mapped File object
+     *  Maps the whole file read-only into memory, throws std::runtime_error if it can not be opened
+     *
+     * @param path Path to the file
+     */
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /**
+     * @brief Get the contents of the file
+     */
+    std::string_view view() const;
+
+    /**
+     * @brief Get the size of the file in bytes
+     */
+    size_t size() const;
+};
@@ -1,13 +1,100 @@
 #pragma once
 
 #include "DataType.h"
+#include "ReIDPreprocessor.h"
+
+#include <map>
+#include <memory>
+#include <string>
 
 #include <opencv2/core.hpp>
 
+
+enum ReID_Method {
+    CNN = 0,
+    ColorHistogram
+};
+
+
+class ReID_Algorithm {
+public:
+    virtual ~ReID_Algorithm() = default;
+    virtual FeatureMatrix extract_features(const cv::Mat &frame, const std::vector<cv::Rect_<float>> &bboxes) = 0;
+    virtual int feature_dim() const = 0;
+};
+
+class CNN_ReID : public ReID_Algorithm {
+private:
+    int _feature_dim;
+    ReIDPreprocessor _preprocessor;
+
+public:
+    CNN_ReID(const std::string &model_weights, int feature_dim, bool fp16_inference);
+    FeatureMatrix extract_features(const cv::Mat &frame, const std::vector<cv::Rect_<float>> &bboxes) override;
+    int feature_dim() const override;
+};
+
+class ColorHistogram_ReID : public ReID_Algorithm {
+private:
+    // Body-part stripes, each described by marginal HSV histograms
+    static constexpr int _num_stripes = 8;
+    static constexpr int _hue_bins = 8, _saturation_bins = 4, _value_bins = 4;
+    static constexpr int _stripe_dim = _hue_bins + _saturation_bins + _value_bins;
+
+    // Every box is sampled on a fixed grid, so the cost per box does not depend on its size
+    static constexpr int _grid_width = 16, _grid_height = 64;
+
+public:
+    ColorHistogram_ReID() = default;
+    FeatureMatrix extract_features(const cv::Mat &frame, const std::vector<cv::Rect_<float>> &bboxes) override;
+    int feature_dim() const override;
+
+private:
+    /**
+     * @brief Compute the L2-normalized embedding of a single bounding box
+     *
+     * @param frame Input frame (BGR, CV_8UC3)
+     * @param bbox Bounding box (top left x, top left y, width, height)
+     * @param embedding Output embedding with feature_dim() elements
+     */
+    void _compute_embedding(const cv::Mat &frame, const cv::Rect_<float> &bbox, float *embedding) const;
+};
+
+
 class ReIDModel {
 public:
-    ReIDModel(std::string model_weights, bool fp16_inference);
+    static std::map<std::string, ReID_Method> ReID_method_map;
+
+private:
+    std::unique_ptr<ReID_Algorithm> _reid_algorithm;
+
+
+public:
+    /**
+     * @brief Construct a new Re-ID Model object
+     *
+     * @param method ReID_Method enum member for the appearance model to use
+     * @param model_weights Path to the model weights (CNN only)
+     * @param feature_dim Output size of the model (CNN only, the handcrafted models have a fixed size),
+     *  throws std::runtime_error if it is not positive
+     * @param fp16_inference Whether to use fp16 inference (CNN only)
+     */
+    ReIDModel(ReID_Method method, const std::string &model_weights, int feature_dim, bool fp16_inference);
     ~ReIDModel() = default;
 
-    FeatureVector extract_features(cv::Mat &image_patch);
-};
\ No newline at end of file
+    /**
+     * @brief Extract the embeddings of all the bounding boxes in the frame with a single batched call
+     *
+     * @param frame Input frame
+     * @param bboxes Bounding boxes (top left x, top left y, width, height)
+     * @return FeatureMatrix Embeddings, one row per bounding box
+     */
+    FeatureMatrix extract_features(const cv::Mat &frame, const std::vector<cv::Rect_<float>> &bboxes);
+
+    /**
+     * @brief Get the dimension of the embeddings produced by the model
+     *
+     * @return int Output size of the model
+     */
+    int feature_dim() const;
+};
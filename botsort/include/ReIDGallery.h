@@ -0,0 +1,149 @@
+#pragma once
+
+#include "AppearanceStore.h"
+#include "DataType.h"
+
+#include <deque>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+
+class ReIDGallery {
+public:
+    /**
+     * @brief Gallery entry matched to a query feature
+     */
+    struct Match {
+        int track_id;  ///< Track ID of the gallery entry
+        float distance;///< Cosine distance between the query and the gallery entry
+    };
+
+private:
+    struct InvertedList {
+        AppearanceStore features;
+        std::vector<int> track_ids;
+        std::vector<AppearanceStore::Slot> slots;
+    };
+
+    struct Entry {
+        int list;
+        size_t position;
+        uint32_t frame_id;
+    };
+
+    int _feature_dim;
+    FeaturePrecision _precision;
+    size_t _capacity;
+    uint32_t _ttl;
+    int _num_lists, _num_probes;
+    size_t _train_size;
+
+    FeatureMatrix _centroids;// Empty until the index is trained, all entries live in a single list until then
+    std::vector<InvertedList> _lists;
+    std::unordered_map<int, Entry> _entries;
+    std::deque<std::pair<int, uint32_t>> _insertion_order;
+
+    static constexpr int _kmeans_iterations = 10;
+    static constexpr size_t _train_samples_per_list = 32;
+
+
+public:
+    /**
+     * @brief Construct a new long-term Re-ID Gallery object
+     *  Smoothed embeddings of removed tracks are indexed with an IVF-flat index:
+     *  entries are partitioned into inverted lists around k-means centroids and
+     *  a query only scans the lists of its closest centroids
+     *
+     * @param feature_dim Dimension of the embeddings
+     * @param precision Storage precision of the embeddings
+     * @param capacity Maximum number of entries, the oldest entries are evicted first
+     * @param ttl Number of frames an entry is kept in the gallery
+     * @param num_lists Number of inverted lists (k-means centroids)
+     * @param num_probes Number of inverted lists scanned per query
+     */
+    ReIDGallery(int feature_dim,
+                FeaturePrecision precision,
+                size_t capacity,
+                uint32_t ttl,
+                int num_lists = 64,
+                int num_probes = 8);
+    ~ReIDGallery() = default;
+
+    /**
+     * @brief Insert the embedding of a removed track into the gallery
+     *
+     * @param track_id Track ID of the removed track
+     * @param feature L2-normalized (smoothed) embedding of the track
+     * @param frame_id Current frame-id
+     */
+    void insert(int track_id, const FeatureVector &feature, uint32_t frame_id);
+
+    /**
+     * @brief Remove an entry from the gallery
+     *
+     * @param track_id Track ID of the entry to remove
+     */
+    void remove(int track_id);
+
+    /**
+     * @brief Remove the entries which are older than the TTL
+     *
+     * @param frame_id Current frame-id
+     */
+    void expire(uint32_t frame_id);
+
+    /**
+     * @brief Find the closest gallery entry for each query embedding
+     *
+     * @param queries L2-normalized query embeddings, one per row
+     * @param max_distance Maximum cosine distance for a match
+     * @return std::vector<std::optional<Match>> Closest entry for each query (if closer than max_distance)
+     */
+    std::vector<std::optional<Match>> query(const FeatureMatrix &queries, float max_distance) const;
+
+    /**
+     * @brief Re-identify the query embeddings against the gallery.
+     *  Every gallery entry is assigned to at most one query (closest first), matched entries are removed
+     *
+     * @param queries L2-normalized query embeddings, one per row
+     * @param max_distance Maximum cosine distance for a match
+     * @return std::vector<std::optional<int>> Recovered track ID for each query
+     */
+    std::vector<std::optional<int>> reidentify(const FeatureMatrix &queries, float max_distance);
+
+    /**
+     * @brief Get the number of entries in the gallery
+     */
+    size_t size() const;
+
+    /**
+     * @brief Write the entries of the gallery and its index to a snapshot
+     *
+     * @param writer Snapshot writer
+     */
+    void save_state(SnapshotWriter &writer) const;
+
+    /**
+     * @brief Replace the gallery with the one of a snapshot written by save_state (same feature dimension and precision)
+     *
+     * @param reader Snapshot reader
+     */
+    void load_state(SnapshotReader &reader);
+
+private:
+    /**
+     * @brief Add the embedding to the inverted list of its closest centroid
+     */
+    void _add_to_list(int track_id, const FeatureVector &feature, uint32_t frame_id);
+
+    /**
+     * @brief Train the k-means centroids on the current entries and re-assign all entries to inverted lists
+     */
+    void _train();
+
+    /**
+     * @brief Get the indices of the num_probes inverted lists closest to each query
+     */
+    std::vector<std::vector<int>> _probe_lists(const FeatureMatrix &queries) const;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+
+class ReIDPreprocessor {
+private:
+    cv::Size _input_size;
+    bool _fp16_output;
+    float _alpha[3], _beta[3];// Per RGB channel: normalized = pixel * alpha + beta
+
+    std::vector<uint8_t> _tensor;
+    int _batch_size = 0;
+
+
+public:
+    /**
+     * @brief Construct a new ReID Preprocessor object
+     *  Crops, letterboxes, converts BGR to RGB, normalizes and transposes HWC to CHW
+     *  in a single pass per patch, writing directly into a preallocated NCHW batch tensor
+     *
+     * @param input_size Input size of the Re-ID model (width, height)
+     * @param fp16_output Write the tensor in half precision instead of float
+     * @param mean Per channel (RGB) mean, applied after scaling the pixels to [0, 1]
+     * @param std Per channel (RGB) standard deviation, applied after scaling the pixels to [0, 1]
+     */
+    explicit ReIDPreprocessor(cv::Size input_size = cv::Size(128, 256),
+                              bool fp16_output = false,
+                              const cv::Scalar &mean = cv::Scalar(0.485, 0.456, 0.406),
+                              const cv::Scalar &std = cv::Scalar(0.229, 0.224, 0.225));
+    ~ReIDPreprocessor() = default;
+
+    /**
+     * @brief Preprocess all the bounding boxes of the frame into the batch tensor.
+     *  Patches are processed in parallel, the tensor only grows when the batch does not fit
+     *
+     * @param frame Input frame (BGR, CV_8UC3)
+     * @param bboxes Bounding boxes (top left x, top left y, width, height)
+     */
+    void run(const cv::Mat &frame, const std::vector<cv::Rect_<float>> &bboxes);
+
+    /**
+     * @brief Get the batch tensor of the last run (NCHW, float or half precision)
+     */
+    const void *tensor() const;
+
+    /**
+     * @brief Get the size of the batch tensor of the last run in bytes
+     */
+    size_t tensor_bytes() const;
+
+    /**
+     * @brief Get the number of patches in the batch tensor of the last run
+     */
+    int batch_size() const;
+
+    /**
+     * @brief Get the input size of the Re-ID model (width, height)
+     */
+    cv::Size input_size() const;
+
+private:
+    /**
+     * @brief Size of a single patch in the batch tensor in bytes
+     */
+    size_t _patch_bytes() const;
+
+    /**
+     * @brief Preprocess a single bounding box into its patch of the batch tensor
+     *
+     * @param frame Input frame (BGR, CV_8UC3)
+     * @param bbox Bounding box (top left x, top left y, width, height)
+     * @param patch Output patch (CHW)
+     * @param x_offsets Scratch buffer for the horizontal sampling table
+     * @param x_weights Scratch buffer for the horizontal interpolation weights
+     * @param row Scratch buffer for the resampled source rows and one output row
+     */
+    void _process_patch(const cv::Mat &frame,
+                        const cv::Rect_<float> &bbox,
+                        uint8_t *patch,
+                        std::vector<int> &x_offsets,
+                        std::vector<float> &x_weights,
+                        std::vector<float> &row) const;
+};
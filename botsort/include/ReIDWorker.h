@@ -0,0 +1,62 @@
+#pragma once
+
+#include "ReID.h"
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+class ReIDWorker {
+private:
+    struct Job {
+        cv::Mat frame;
+        std::vector<cv::Rect_<float>> bboxes;
+        std::promise<FeatureMatrix> features;
+    };
+
+    ReIDModel &_reid_model;
+
+    std::deque<Job> _jobs;
+    std::mutex _mutex;
+    std::condition_variable _job_available;
+    bool _stop = false;
+    std::thread _thread;
+
+
+public:
+    /**
+     * @brief Construct a new ReID Worker object
+     *  Runs feature extraction on a background thread, jobs are processed in submission order.
+     *  A single thread is used since the model (and its preprocessing buffers) serve one batch at a time
+     *
+     * @param reid_model Re-ID model, must outlive the worker
+     */
+    explicit ReIDWorker(ReIDModel &reid_model);
+
+    /**
+     * @brief Stop the worker, pending jobs are completed first
+     */
+    ~ReIDWorker();
+
+    ReIDWorker(const ReIDWorker &) = delete;
+    ReIDWorker &operator=(const ReIDWorker &) = delete;
+
+    /**
+     * @brief Queue the feature extraction of the bounding boxes in the frame
+     *
+     * @param frame Input frame, copied so that the caller can reuse its buffer
+     * @param bboxes Bounding boxes (top left x, top left y, width, height)
+     * @return std::future<FeatureMatrix> Extracted features, one row per bounding box
+     */
+    std::future<FeatureMatrix> submit(const cv::Mat &frame, std::vector<cv::Rect_<float>> bboxes);
+
+private:
+    /**
+     * @brief Worker thread loop
+     */
+    void _run();
+};
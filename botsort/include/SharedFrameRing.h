@@ -0,0 +1,176 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <opencv2/core.hpp>
+
+
+/**
+ * @brief Layout of a frame ring in POSIX shared memory, shared by one producer and one consumer process
+ *
+ *  [RingHeader][SlotInfo x num_slots] ... [slot 0 pixels] [slot 1 pixels] ... (slots are page aligned)
+ *  Frame i is written to slot i % num_slots. The producer owns the slots in [read_count + num_slots, write_count)
+ *  and publishes a frame by incrementing write_count, the consumer returns it by incrementing read_count.
+ */
+namespace shared_frame_ring {
+constexpr uint32_t MAGIC = 0x474E5246;// "FRNG"
+constexpr uint32_t VERSION = 2;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared frame ring requires lock-free 64-bit atomics");
+
+struct RingHeader {
+    std::atomic<uint32_t> magic;// Set last by the producer, once the header is initialized
+    uint32_t version;
+    uint32_t num_slots;
+    int32_t width, height, type;
+    uint64_t step;      // Bytes per row
+    uint64_t slot_bytes;// Bytes per slot, multiple of the page size
+    uint64_t data_offset;
+
+    alignas(64) std::atomic<uint64_t> write_count;// Written by the producer only
+    alignas(64) std::atomic<uint64_t> read_count; // Written by the consumer only
+    alignas(64) std::atomic<uint32_t> closed;     // Set by the producer after its last frame
+    std::atomic<int32_t> producer_pid;            // Process IDs, to detect a peer that exited without closing the ring
+    std::atomic<int32_t> consumer_pid;            // (0 until a consumer attaches)
+};
+
+struct SlotInfo {
+    uint32_t frame_id;
+    double timestamp;
+};
+}// namespace shared_frame_ring
+
+
+class SharedFrameRing {
+protected:
+    std::string _name;
+    void *_mapping = nullptr;
+    size_t _mapping_bytes = 0;
+    shared_frame_ring::RingHeader *_header = nullptr;
+    shared_frame_ring::SlotInfo *_slots = nullptr;
+
+
+public:
+    SharedFrameRing(const SharedFrameRing &) = delete;
+    SharedFrameRing &operator=(const SharedFrameRing &) = delete;
+
+    /**
+     * @brief Get the size of the frames in the ring
+     */
+    cv::Size frame_size() const;
+
+    /**
+     * @brief Get the number of frame slots in the ring
+     */
+    size_t num_slots() const;
+
+protected:
+    explicit SharedFrameRing(std::string name);
+    ~SharedFrameRing();
+
+    /**
+     * @brief Map the shared memory object and point the header and slot infos into it
+     */
+    void _map(int fd, size_t bytes);
+
+    /**
+     * @brief Get a cv::Mat header over the pixels of the slot used by the given frame (no copy)
+     */
+    cv::Mat _slot_frame(uint64_t frame_index) const;
+
+    /**
+     * @brief Wait for the condition, spinning first then sleeping (the indices are polled, no lock is shared).
+     *  While sleeping, the peer process is checked periodically and std::runtime_error is thrown if it has exited
+     *  (both processes must share the PID namespace)
+     *
+     * @param condition Condition to wait for
+     * @param peer_pid Process ID of the other side of the ring, not checked while 0
+     * @return true once the condition holds, false if the producer closed the ring before
+     */
+    template<typename Condition>
+    bool _wait(Condition condition, const std::atomic<int32_t> &peer_pid) const;
+};
+
+
+class SharedFrameProducer : public SharedFrameRing {
+private:
+    uint64_t _write_count = 0;
+    bool _acquired = false;
+
+
+public:
+    /**
+     * @brief Construct a new Shared Frame Producer object
+     *  Creates the shared memory object (replacing a stale one with the same name), removed on destruction
+     *
+     * @param name Name of the shared memory object (e.g. "/botsort_frames")
+     * @param frame_size Size of the frames
+     * @param type Type of the frames (e.g. CV_8UC3 for BGR)
+     * @param num_slots Number of frame slots, the producer blocks when the consumer is num_slots frames behind
+     */
+    SharedFrameProducer(const std::string &name, cv::Size frame_size, int type = CV_8UC3, size_t num_slots = 4);
+
+    /**
+     * @brief Close the ring and remove the shared memory object, a consumer can still read the published frames
+     */
+    ~SharedFrameProducer();
+
+    /**
+     * @brief Get the slot of the next frame, blocks until the consumer has returned it.
+     *  Throws std::runtime_error if the consumer process exits meanwhile
+     *
+     * @return cv::Mat Header over the slot in shared memory, the next frame must be written into it in place
+     */
+    cv::Mat acquire();
+
+    /**
+     * @brief Make the acquired slot available to the consumer
+     *
+     * @param frame_id Frame ID
+     * @param timestamp Timestamp of the frame
+     */
+    void publish(uint32_t frame_id, double timestamp = 0.0);
+
+    /**
+     * @brief Signal the end of the stream to the consumer
+     */
+    void close();
+};
+
+
+class SharedFrameConsumer : public SharedFrameRing {
+private:
+    uint64_t _read_count = 0;
+    bool _acquired = false;
+
+
+public:
+    /**
+     * @brief Construct a new Shared Frame Consumer object
+     *  Opens the ring of a producer, waits for it to be created if needed
+     *
+     * @param name Name of the shared memory object
+     * @param timeout_ms Maximum time to wait for the producer, throws std::runtime_error after it
+     */
+    explicit SharedFrameConsumer(const std::string &name, int timeout_ms = 10000);
+    ~SharedFrameConsumer() = default;
+
+    /**
+     * @brief Get the next frame, blocks until it is published. The previous frame must have been released.
+     *  Throws std::runtime_error if the producer process exits without closing the ring
+     *
+     * @param frame Output cv::Mat header over the slot in shared memory (no copy), valid until release()
+     * @param frame_id (Optional) Output frame ID
+     * @param timestamp (Optional) Output timestamp
+     * @return true if a frame was returned, false once the producer has closed the ring and all frames were read
+     */
+    bool acquire(cv::Mat &frame, uint32_t *frame_id = nullptr, double *timestamp = nullptr);
+
+    /**
+     * @brief Return the slot of the acquired frame to the producer, the frame must not be used afterwards
+     */
+    void release();
+};
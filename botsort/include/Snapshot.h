@@ -0,0 +1,140 @@
+#pragma once
+
+#include "DataType.h"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+
+/**
+ * @brief Appends the state of the tracker components to a binary snapshot (native byte order, no padding)
+ */
+class SnapshotWriter {
+private:
+    std::string &_out;
+
+
+public:
+    /**
+     * @brief Construct a new Snapshot Writer object
+     *
+     * @param out Output buffer, appended to (clear it to reuse its capacity between snapshots)
+     */
+    explicit SnapshotWriter(std::string &out) : _out(out) {}
+
+    template<typename T>
+    void write(const T &value) {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be written as is");
+        _out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    void write_bytes(const void *data, size_t size) {
+        _out.append(static_cast<const char *>(data), size);
+    }
+
+    template<typename T>
+    void write_vector(const std::vector<T> &values) {
+        write(static_cast<uint64_t>(values.size()));
+        write_bytes(values.data(), values.size() * sizeof(T));
+    }
+
+    /**
+     * @brief Write an Eigen matrix (dimensions, then the coefficients in storage order)
+     */
+    template<typename Derived>
+    void write_matrix(const Eigen::PlainObjectBase<Derived> &matrix) {
+        write(static_cast<int64_t>(matrix.rows()));
+        write(static_cast<int64_t>(matrix.cols()));
+        write_bytes(matrix.data(), static_cast<size_t>(matrix.size()) * sizeof(typename Derived::Scalar));
+    }
+
+    /**
+     * @brief Write a cv::Mat (dimensions, type, then the pixels row by row)
+     */
+    void write_mat(const cv::Mat &mat);
+};
+
+
+/**
+ * @brief Reads back a snapshot written by SnapshotWriter, throws std::runtime_error if it is truncated or malformed
+ */
+class SnapshotReader {
+private:
+    const char *_pos, *_end;
+
+
+public:
+    explicit SnapshotReader(std::string_view snapshot) : _pos(snapshot.data()), _end(snapshot.data() + snapshot.size()) {}
+
+    template<typename T>
+    T read() {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be read as is");
+        T value;
+        read_bytes(&value, sizeof(T));
+        return value;
+    }
+
+    void read_bytes(void *data, size_t size) {
+        if (static_cast<size_t>(_end - _pos) < size) {
+            throw std::runtime_error("Truncated tracker snapshot");
+        }
+        std::memcpy(data, _pos, size);
+        _pos += size;
+    }
+
+    /**
+     * @brief Read an element count, checked against the remaining bytes before anything is allocated for it
+     *
+     * @param element_bytes Minimum number of bytes of each element in the snapshot
+     */
+    size_t read_count(size_t element_bytes) {
+        auto count = read<uint64_t>();
+        if (count > static_cast<size_t>(_end - _pos) / element_bytes) {
+            throw std::runtime_error("Truncated tracker snapshot");
+        }
+        return static_cast<size_t>(count);
+    }
+
+    template<typename T>
+    void read_vector(std::vector<T> &values) {
+        size_t size = read_count(sizeof(T));
+        values.resize(size);
+        read_bytes(values.data(), size * sizeof(T));
+    }
+
+    /**
+     * @brief Read an Eigen matrix, fixed dimensions must match the snapshot
+     */
+    template<typename Derived>
+    void read_matrix(Eigen::PlainObjectBase<Derived> &matrix) {
+        auto rows = read<int64_t>(), cols = read<int64_t>();
+        if (rows < 0 || cols < 0 ||
+            (Derived::RowsAtCompileTime != Eigen::Dynamic && rows != Derived::RowsAtCompileTime) ||
+            (Derived::ColsAtCompileTime != Eigen::Dynamic && cols != Derived::ColsAtCompileTime)) {
+            throw std::runtime_error("Malformed tracker snapshot: unexpected matrix dimensions");
+        }
+        const size_t max_elements = static_cast<size_t>(_end - _pos) / sizeof(typename Derived::Scalar);
+        if (cols > 0 && static_cast<size_t>(rows) > max_elements / static_cast<size_t>(cols)) {
+            throw std::runtime_error("Truncated tracker snapshot");
+        }
+        matrix.resize(rows, cols);
+        read_bytes(matrix.data(), static_cast<size_t>(matrix.size()) * sizeof(typename Derived::Scalar));
+    }
+
+    /**
+     * @brief Read a cv::Mat, reusing its buffer if it has the same size and type
+     */
+    void read_mat(cv::Mat &mat);
+
+    /**
+     * @brief Check whether the whole snapshot has been read
+     */
+    bool at_end() const { return _pos == _end; }
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "StreamProtocol.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+
+
+class StreamIngest {
+private:
+    int _input_fd, _output_fd;
+    int _stop_pipe[2] = {-1, -1};// Written by the destructor to stop the reader thread blocked on the input stream
+    size_t _max_queued_frames;
+
+    // Frames decoded by the reader thread, waiting to be tracked
+    std::deque<stream_protocol::FrameMessage> _frames;
+    std::vector<stream_protocol::FrameMessage> _spare_frames;
+    bool _input_done = false;
+    std::exception_ptr _input_error;
+    std::mutex _input_mutex;
+    std::condition_variable _frame_ready, _frame_free;
+
+    // Encoded track messages waiting to be written, swapped with the writer thread's buffer
+    std::string _pending_output;
+    bool _output_done = false;
+    std::exception_ptr _output_error;
+    std::mutex _output_mutex;
+    std::condition_variable _output_ready;
+
+    std::thread _reader, _writer;
+
+
+public:
+    /**
+     * @brief Construct a new Stream Ingest object
+     *  Frame messages are read and decoded on a background thread while the previous frames are being tracked,
+     *  and track messages are written on another thread, responses produced meanwhile being sent in one write
+     *
+     * @param input_fd File descriptor to read frame messages from (socket, FIFO or stdin), not closed
+     * @param output_fd File descriptor to write track messages to (can be the same socket as input_fd), not closed
+     * @param max_queued_frames Maximum number of decoded frames waiting to be tracked before reading is paused
+     */
+    StreamIngest(int input_fd, int output_fd, size_t max_queued_frames = 8);
+
+    /**
+     * @brief Write the pending track messages and stop the background threads, frames not yet received are dropped
+     */
+    ~StreamIngest();
+
+    StreamIngest(const StreamIngest &) = delete;
+    StreamIngest &operator=(const StreamIngest &) = delete;
+
+    /**
+     * @brief Get the next frame, blocks until it is received. Rethrows errors of the reader thread
+     *
+     * @param frame Output frame, its previous detection buffer is recycled
+     * @return true if a frame was received, false once the stream is closed and all frames were returned
+     */
+    bool receive(stream_protocol::FrameMessage &frame);
+
+    /**
+     * @brief Queue the track message answering a frame. Rethrows errors of the writer thread
+     *
+     * @param frame_id Frame ID
+     * @param timestamp Timestamp of the frame message, echoed back
+     * @param tracks Output tracks of the tracker for this frame
+     */
+    void send(uint32_t frame_id, double timestamp, const std::vector<std::shared_ptr<Track>> &tracks);
+
+private:
+    /**
+     * @brief Reader thread loop
+     */
+    void _read_loop();
+
+    /**
+     * @brief Writer thread loop
+     */
+    void _write_loop();
+};
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "DataType.h"
+#include "track.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+/**
+ * @brief Binary streaming protocol between a detector process and the tracker (little-endian, packed)
+ *
+ *  Every message is a uint32 payload size followed by the payload.
+ *  Frame message (detector -> tracker): FrameHeader, then num_detections x PackedDetection
+ *  Track message (tracker -> detector): TrackHeader, then num_tracks x PackedTrack
+ *  The timestamp of a frame is echoed back in its track message (e.g. to measure the latency)
+ */
+namespace stream_protocol {
+constexpr uint32_t MAX_MESSAGE_BYTES = 64 << 20;
+
+#pragma pack(push, 1)
+struct FrameHeader {
+    uint32_t frame_id;
+    uint32_t num_detections;
+    uint32_t image_width;
+    uint32_t image_height;
+    double timestamp;
+};
+
+struct PackedDetection {
+    float x, y, width, height;
+    float confidence;
+    int32_t class_id;
+};
+
+struct TrackHeader {
+    uint32_t frame_id;
+    uint32_t num_tracks;
+    double timestamp;
+};
+
+struct PackedTrack {
+    int32_t track_id;
+    float x, y, width, height;
+    float score;
+    uint8_t class_id;
+    uint8_t state;
+    uint8_t reserved[2];
+};
+#pragma pack(pop)
+
+
+/**
+ * @brief Frame of detections received from the detector
+ */
+struct FrameMessage {
+    uint32_t frame_id = 0;
+    double timestamp = 0.0;
+    cv::Size image_size;
+    std::vector<Detection> detections;
+};
+
+
+/**
+ * @brief Append a frame message to the output buffer
+ */
+void encode_frame(std::string &out, uint32_t frame_id, double timestamp, cv::Size image_size, const Detection *detections, size_t num_detections);
+
+/**
+ * @brief Decode the payload of a frame message, throws std::runtime_error if it is malformed
+ */
+void decode_frame(std::string_view payload, FrameMessage &message);
+
+/**
+ * @brief Append a track message to the output buffer
+ */
+void encode_tracks(std::string &out, uint32_t frame_id, double timestamp, const std::vector<std::shared_ptr<Track>> &tracks);
+
+/**
+ * @brief Decode the payload of a track message, throws std::runtime_error if it is malformed
+ *
+ * @param payload Payload of the message
+ * @param header Output header
+ * @return const char* num_tracks PackedTrack of the message, pointing into the payload (unaligned, read with memcpy)
+ */
+const char *decode_tracks(std::string_view payload, TrackHeader &header);
+
+/**
+ * @brief Write the whole buffer to the file descriptor, throws std::runtime_error on failure.
+ *  Sockets are written without raising SIGPIPE, a peer that has disconnected is reported as an error
+ */
+void write_all(int fd, const char *data, size_t size);
+
+/**
+ * @brief Create a Unix-domain socket at the given path and wait for a client to connect
+ *
+ * @return int File descriptor of the connection
+ */
+int accept_unix_socket(const std::string &path);
+
+/**
+ * @brief Connect to a Unix-domain socket
+ *
+ * @return int File descriptor of the connection
+ */
+int connect_unix_socket(const std::string &path);
+
+
+class MessageReader {
+private:
+    int _fd, _stop_fd;
+    std::vector<char> _buffer;
+    size_t _begin = 0, _end = 0;
+    bool _eof = false;
+
+
+public:
+    /**
+     * @brief Construct a new Message Reader object
+     *  Reads the stream in large chunks and splits it into messages, several messages are parsed per read
+     *
+     * @param fd File descriptor to read from (socket, FIFO or stdin), not closed by the reader
+     * @param chunk_size Size of the reads in bytes
+     * @param stop_fd (Optional) File descriptor that becomes readable to stop a blocked read, e.g. the read end of a pipe.
+     *  The stream then ends as if it had been closed, a partially received message is dropped
+     */
+    explicit MessageReader(int fd, size_t chunk_size = 1 << 16, int stop_fd = -1);
+
+    /**
+     * @brief Get the next message, blocks until it is completely received
+     *
+     * @param payload Output payload of the message, valid until the next call
+     * @return true if a message was received, false at the end of the stream
+     */
+    bool next(std::string_view &payload);
+
+private:
+    /**
+     * @brief Read the next chunk, keeping the unparsed bytes
+     *
+     * @return false at the end of the stream or once stop_fd is readable
+     */
+    bool _fill();
+};
+}// namespace stream_protocol
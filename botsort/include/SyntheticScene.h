@@ -0,0 +1,145 @@
+#pragma once
+
+#include "DataType.h"
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+
+enum MotionModel {
+    ConstantVelocity = 0,
+    RandomWalk,
+    CoordinatedTurn,
+    MixedMotion
+};
+
+
+/**
+ * @brief Parameters of a synthetic crowd scene, speeds and sizes in pixels (per frame)
+ */
+struct SyntheticSceneParams {
+    int num_targets = 100;                       ///< Targets alive at any time (each death is replaced by a birth)
+    cv::Size frame_size = cv::Size(1920, 1080);
+    uint32_t seed = 42;
+
+    MotionModel motion_model = MixedMotion;      ///< MixedMotion draws one of the other models per target
+    float speed = 2.0F;                          ///< Mean target speed
+    float max_turn_rate = 0.03F;                 ///< CoordinatedTurn, in rad / frame
+    float mean_lifetime = 300.0F;                ///< Mean lifetime in frames (exponential), 0 for targets leaving the view only
+    float min_height = 40.0F, max_height = 300.0F;
+    float min_aspect_ratio = 0.3F, max_aspect_ratio = 0.5F;
+
+    float position_noise = 0.03F;                ///< Standard deviation of the box position noise, relative to the box size
+    float size_noise = 0.03F;                    ///< Standard deviation of the box size noise, relative to the box size
+    float miss_rate = 0.05F;                     ///< Probability to miss a visible target
+    float min_visibility = 0.3F;                 ///< Targets less visible than this (occluded / truncated) are never detected
+    float false_positives_per_target = 0.02F;    ///< Mean number of false positives per frame, relative to num_targets
+
+    float pan_x = 0.0F, pan_y = 0.0F;            ///< Camera pan velocity
+    float pan_jitter = 0.0F;                     ///< Standard deviation of the camera shake
+};
+
+
+/**
+ * @brief Ground truth of a frame and the output of a simulated detector
+ */
+struct SyntheticFrame {
+    uint32_t frame_id = 0;                       ///< 1-based, like BoTSORT frame ids
+    std::vector<Detection> detections;           ///< Noisy detections, misses and false positives, in random order
+    std::vector<GroundTruthObject> ground_truth; ///< Every target overlapping the frame, occluded ones included
+    HomographyMatrix camera_motion;              ///< Maps the previous frame to this one (translation of the pan)
+};
+
+
+/**
+ * @brief Deterministic synthetic crowd scene, to measure the tracker with any number of objects.
+ *  Targets move in world coordinates with their motion model, a camera pans over the world, targets are occluded
+ *  by the targets in front of them (lower bottom edge), and a detector is simulated from the visible targets.
+ *  Random numbers come from std::mt19937 with distributions implemented here, so a seed yields the same scene
+ *  with every compiler and standard library
+ */
+class SyntheticScene {
+public:
+    static std::map<std::string, MotionModel> motion_model_map;
+
+private:
+    struct Target {
+        int id;
+        MotionModel motion_model;
+        float x, y;  // Bottom center, world coordinates
+        float vx, vy;
+        float width, height;
+        float turn_rate;
+        int frames_left;
+    };
+
+    SyntheticSceneParams _params;
+    std::mt19937 _rng;
+    std::vector<Target> _targets;
+    float _camera_x = 0.0F, _camera_y = 0.0F;
+    uint32_t _frame_id = 0;
+    int _next_target_id = 1;
+    uint64_t _num_births = 0;
+
+
+public:
+    /**
+     * @brief Construct a new Synthetic Scene object, with num_targets targets spread over the first frame
+     *  Throws std::runtime_error if the parameters are out of range
+     *
+     * @param params Scene parameters
+     */
+    explicit SyntheticScene(const SyntheticSceneParams &params);
+    ~SyntheticScene() = default;
+
+    /**
+     * @brief Advance the scene by one frame
+     *
+     * @return SyntheticFrame Ground truth and detections of the new frame
+     */
+    SyntheticFrame next();
+
+    /**
+     * @brief Generate the next frames of the scene
+     *
+     * @param num_frames Number of frames
+     * @param keep_ground_truth Whether to keep the ground truth (the detections are enough for benchmarks)
+     * @return std::vector<SyntheticFrame> Frames
+     */
+    std::vector<SyntheticFrame> generate(int num_frames, bool keep_ground_truth = true);
+
+    /**
+     * @brief Get the number of targets born so far, initial targets included
+     */
+    uint64_t num_births() const { return _num_births; }
+
+private:
+    /**
+     * @brief Create a target at a random position of the current view
+     */
+    Target _spawn_target();
+
+    /**
+     * @brief Move a target by one frame according to its motion model
+     */
+    void _move_target(Target &target);
+
+    /**
+     * @brief Bounding box of a target in image coordinates
+     */
+    cv::Rect_<float> _image_box(const Target &target) const;
+
+    /**
+     * @brief Visible fraction of each box: the part inside the frame, minus the parts covered by the boxes in front
+     *  of it (overlaps between occluders are counted twice, so heavy occlusion is slightly overestimated)
+     */
+    std::vector<float> _visibility(const std::vector<cv::Rect_<float>> &boxes) const;
+
+    float _uniform();
+    float _uniform(float low, float high) { return low + (high - low) * _uniform(); }
+    float _normal();
+    int _poisson(float mean);
+};
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+/**
+ * @brief Execution tracing of the tracker: the stages of BoTSORT::track, the sub-steps of the GMC algorithms and the
+ *  lapjv calls are recorded as complete events (begin + duration) with the stream and frame IDs of the call, into
+ *  a buffer per thread (single writer, no locks), then exported as Chrome trace-event JSON (chrome://tracing, Perfetto).
+ *  Tracing is off by default, a disabled trace point costs a relaxed atomic load
+ */
+namespace tracing {
+namespace detail {
+extern std::atomic<bool> enabled;
+
+void record(const char *name, const char *category, int64_t begin_ns, int64_t end_ns);
+}// namespace detail
+
+/**
+ * @brief Start recording, discards the events of the previous recording
+ *
+ * @param events_per_thread Capacity of the buffer of each thread, further events are dropped (and counted)
+ */
+void start(size_t events_per_thread = size_t(1) << 18);
+
+/**
+ * @brief Stop recording, the recorded events are kept until the next start()
+ */
+void stop();
+
+inline bool enabled() { return detail::enabled.load(std::memory_order_relaxed); }
+
+/**
+ * @brief Write the recorded events as Chrome trace-event JSON, may be called while recording
+ *  (events recorded during the export may be missing), throws std::runtime_error if the file can not be written
+ *
+ * @param path Path to the JSON file
+ * @return size_t Number of events written
+ */
+size_t write_chrome_trace(const std::string &path);
+
+/**
+ * @brief Number of events dropped because a thread buffer was full
+ */
+uint64_t dropped_events();
+
+inline int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+/**
+ * @brief Sets the stream and frame IDs attached to the events of the calling thread, restores the previous ones
+ *  when it goes out of scope
+ */
+class FrameContext {
+private:
+    int32_t _prev_stream_id;
+    uint32_t _prev_frame_id;
+
+
+public:
+    FrameContext(int32_t stream_id, uint32_t frame_id);
+    ~FrameContext();
+
+    FrameContext(const FrameContext &) = delete;
+    FrameContext &operator=(const FrameContext &) = delete;
+};
+
+
+/**
+ * @brief Records an event covering its lifetime
+ *
+ * @param name Name of the event, must outlive the recording (string literal)
+ * @param category Category of the event (string literal)
+ */
+class Scope {
+private:
+    const char *_name, *_category;
+    int64_t _begin_ns = 0;
+
+
+public:
+    Scope(const char *name, const char *category) : _name(name), _category(category) {
+        if (enabled()) {
+            _begin_ns = now_ns();
+        }
+    }
+    ~Scope() {
+        if (_begin_ns != 0) {
+            detail::record(_name, _category, _begin_ns, now_ns());
+        }
+    }
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+};
+
+
+/**
+ * @brief Records consecutive steps of a function: each lap is an event from the previous lap (or the creation of
+ *  the object) to now, for code whose steps are not scopes
+ *
+ * @param category Category of the events (string literal)
+ */
+class Laps {
+private:
+    const char *_category;
+    int64_t _last_ns = 0;
+
+
+public:
+    explicit Laps(const char *category) : _category(category) {
+        if (enabled()) {
+            _last_ns = now_ns();
+        }
+    }
+
+    /**
+     * @brief Record the step that just ended
+     *
+     * @param name Name of the step (string literal)
+     */
+    void lap(const char *name) {
+        if (_last_ns != 0) {
+            int64_t now = now_ns();
+            detail::record(name, _category, _last_ns, now);
+            _last_ns = now;
+        }
+    }
+};
+}// namespace tracing
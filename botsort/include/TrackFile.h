@@ -0,0 +1,164 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "track.h"
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+/**
+ * @brief Binary columnar track file layout (little-endian)
+ *
+ *  File header (16 bytes): magic "BTRK", uint16 version, uint16 flags, uint32 keyframe interval, uint32 reserved
+ *  Per frame:
+ *      Frame header (16 bytes): uint32 frame-id, uint32 number of tracks, uint32 payload size, uint32 flags
+ *      Raw payload: int32 track_id[n], float32 x[n], y[n], w[n], h[n], score[n], uint8 class_id[n], uint8 state[n],
+ *          zero padded to a multiple of 4 bytes so that the columns can be used in place
+ *      Delta payload: zigzag varints of the track-id deltas (to the previous id of the frame), zigzag varints of the
+ *          x, y, w, h deltas in 1/100 px to the same track in the previous frame (to 0 on keyframes and for new tracks),
+ *          then float32 score[n], uint8 class_id[n], uint8 state[n] and the zero padding
+ */
+namespace track_file {
+constexpr char MAGIC[4] = {'B', 'T', 'R', 'K'};
+constexpr uint16_t VERSION = 1;
+constexpr uint16_t FILE_FLAG_DELTA = 1;
+constexpr uint32_t FRAME_FLAG_KEYFRAME = 1;
+constexpr float COORDINATE_SCALE = 100.0F;
+
+struct FileHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t flags;
+    uint32_t keyframe_interval;
+    uint32_t reserved;
+};
+
+struct FrameHeader {
+    uint32_t frame_id;
+    uint32_t num_tracks;
+    uint32_t payload_bytes;
+    uint32_t flags;
+};
+}// namespace track_file
+
+
+/**
+ * @brief Columns of the tracks of one frame, valid until the next call to the reader
+ */
+struct TrackFrame {
+    uint32_t frame_id = 0;
+    size_t num_tracks = 0;
+    const int32_t *track_ids = nullptr;
+    const float *x = nullptr, *y = nullptr, *width = nullptr, *height = nullptr;
+    const float *score = nullptr;
+    const uint8_t *class_id = nullptr, *state = nullptr;
+};
+
+
+class TrackFileWriter {
+private:
+    std::string _path;
+    std::ofstream _file;
+    bool _delta_encoding;
+    uint32_t _keyframe_interval;
+    uint64_t _num_frames = 0;
+
+    std::vector<uint8_t> _payload;
+    std::unordered_map<int32_t, std::array<int32_t, 4>> _previous_boxes, _current_boxes;
+
+
+public:
+    /**
+     * @brief Construct a new Track File Writer object
+     *  Throws std::runtime_error if the file can not be opened or the header can not be written
+     *
+     * @param output_file Output file
+     * @param delta_encoding Whether to delta encode the ids and the boxes (quantized to 1/100 px) as zigzag varints
+     * @param keyframe_interval Number of frames between two keyframes (delta encoding only), the reader seeks to keyframes
+     */
+    explicit TrackFileWriter(const std::string &output_file, bool delta_encoding = false, uint32_t keyframe_interval = 30);
+
+    /**
+     * @brief Close the file, a failure is reported on stderr since destructors can't throw
+     */
+    ~TrackFileWriter();
+
+    /**
+     * @brief Write the tracks of a frame
+     *  Throws std::runtime_error if the frame can not be written (e.g. disk full)
+     *
+     * @param frame_id Frame-id
+     * @param tracks Tracks returned by the tracker for the frame
+     */
+    void write(uint32_t frame_id, const std::vector<std::shared_ptr<Track>> &tracks);
+
+    /**
+     * @brief Flush the written frames to the file
+     *  Throws std::runtime_error if the frames can not be written
+     */
+    void flush();
+
+
+private:
+    /**
+     * @brief Throw std::runtime_error if the file stream is in a failed state
+     */
+    void _check_stream() const;
+};
+
+
+class TrackFileReader {
+private:
+    MappedFile _file;
+    track_file::FileHeader _header{};
+    std::vector<size_t> _frame_offsets;// Offset of the header of each frame
+
+    // Decoded columns of delta encoded files
+    std::vector<int32_t> _track_ids;
+    std::vector<float> _columns, _scores;
+    std::vector<uint8_t> _class_ids, _states;
+    std::unordered_map<int32_t, std::array<int32_t, 4>> _previous_boxes, _current_boxes;
+    size_t _decoded_frame = SIZE_MAX;
+
+
+public:
+    /**
+     * @brief Construct a new Track File Reader object
+     *  Memory-maps the file and indexes its frames, throws std::runtime_error if it is not a valid track file
+     *
+     * @param input_file Track file written by TrackFileWriter
+     */
+    explicit TrackFileReader(const std::string &input_file);
+    ~TrackFileReader() = default;
+
+    /**
+     * @brief Get the number of frames in the file
+     */
+    size_t num_frames() const;
+
+    /**
+     * @brief Whether the file is delta encoded
+     */
+    bool delta_encoded() const;
+
+    /**
+     * @brief Get the tracks of a frame. Raw files are read in place, delta encoded files are decoded from the
+     *  closest keyframe (sequential reads decode a single frame)
+     *
+     * @param index Position of the frame in the file
+     * @return TrackFrame Columns of the tracks of the frame
+     */
+    TrackFrame frame(size_t index);
+
+private:
+    /**
+     * @brief Decode a delta encoded frame on top of the previously decoded one
+     */
+    void _decode_frame(size_t index);
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "INIReader.h"
+
+#include <string>
+
+
+/**
+ * @brief Parameters of a tracker: the contents of tracker.ini and gmc.ini, loaded from a config directory
+ *  or set in memory (e.g. to sweep the parameters without writing config files)
+ */
+struct TrackerConfig {
+    INIReader tracker;     ///< tracker.ini: [BoTSORT], [ReIDGallery] and [EmbeddingCache]
+    INIReader gmc;         ///< gmc.ini: one section per GMC algorithm
+    std::string config_dir;///< Directory the config was loaded from, empty if it was built in memory
+
+    /**
+     * @brief Load tracker.ini and gmc.ini from a config directory, exits if tracker.ini can not be read
+     *  (gmc.ini is only required by the GMC methods other than none)
+     *
+     * @param config_dir Path to the config directory
+     * @return TrackerConfig
+     */
+    static TrackerConfig load(const std::string &config_dir);
+
+    /**
+     * @brief Set a parameter, routed to gmc.ini for the sections of the GMC algorithms and to tracker.ini otherwise
+     *
+     * @param section Section, e.g. "BoTSORT" or "orb"
+     * @param name Parameter name, e.g. "match_thresh"
+     * @param value Value, parsed like the INI file values
+     */
+    void set(const std::string &section, const std::string &name, const std::string &value);
+
+    /**
+     * @brief Whether the section belongs to gmc.ini (see GlobalMotionCompensation::GMC_section_map)
+     */
+    static bool is_gmc_section(const std::string &section);
+
+    /**
+     * @brief Compare two section names the way INIReader does, i.e. case-insensitively
+     */
+    static bool same_section(const std::string &a, const std::string &b);
+};
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/**
+ * @brief Latency histogram with HDR-style log-linear buckets: 32 linear sub-buckets per power of two,
+ *  i.e. values are recorded with a relative error below 3.2% from 1 ns to hours, in constant time and memory.
+ *  The buckets (15 KB) are allocated by the first record(), so that unused histograms cost nothing
+ */
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr uint64_t SUB_BUCKET_COUNT = uint64_t(1) << SUB_BUCKET_BITS;
+    static constexpr size_t NUM_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+private:
+    std::vector<uint64_t> _counts;
+    uint64_t _count = 0, _sum = 0, _min = UINT64_MAX, _max = 0;
+
+
+public:
+    /**
+     * @brief Record a value
+     *
+     * @param value_ns Latency in nanoseconds
+     */
+    void record(uint64_t value_ns) {
+        if (_counts.empty()) {
+            _counts.assign(NUM_BUCKETS, 0);
+        }
+        _counts[_bucket_index(value_ns)]++;
+        _count++;
+        _sum += value_ns;
+        _min = value_ns < _min ? value_ns : _min;
+        _max = value_ns > _max ? value_ns : _max;
+    }
+
+    /**
+     * @brief Get the value at the given percentile (highest value of its bucket, never above the maximum)
+     *
+     * @param percentile Percentile in [0, 100]
+     * @return uint64_t Latency in nanoseconds (0 if nothing was recorded)
+     */
+    uint64_t percentile(double percentile) const;
+
+    uint64_t count() const { return _count; }
+    uint64_t min() const { return _count ? _min : 0; }
+    uint64_t max() const { return _max; }
+    double mean() const { return _count ? static_cast<double>(_sum) / static_cast<double>(_count) : 0.0; }
+
+    void reset();
+
+private:
+    static size_t _bucket_index(uint64_t value) {
+        if (value < SUB_BUCKET_COUNT) {
+            return static_cast<size_t>(value);
+        }
+        const int msb = 63 - __builtin_clzll(value);
+        const int shift = msb - SUB_BUCKET_BITS;
+        return static_cast<size_t>(shift + 1) * SUB_BUCKET_COUNT + static_cast<size_t>((value >> shift) - SUB_BUCKET_COUNT);
+    }
+
+    static uint64_t _bucket_highest_value(size_t index);
+};
+
+
+/**
+ * @brief Stages of BoTSORT::track, in execution order (Total covers the whole call)
+ */
+enum class TrackerStage : uint8_t {
+    DetectionIntake = 0,
+    Predict,
+    GMC,
+    FirstAssociation,
+    SecondAssociation,
+    Unconfirmed,
+    NewTracks,
+    Lifecycle,
+    Cleanup,
+    Total
+};
+constexpr size_t NUM_TRACKER_STAGES = static_cast<size_t>(TrackerStage::Total) + 1;
+
+
+/**
+ * @brief Latency and counters of a stage, the counters are summed over the calls:
+ *  tracks and detections in the stage (rows and columns of the cost matrix for the associations),
+ *  matches of the associations, tracks started (NewTracks) or removed (Lifecycle)
+ */
+struct StageStats {
+    LatencyHistogram latency;
+    uint64_t tracks = 0, detections = 0, matches = 0;
+};
+
+
+/**
+ * @brief Per-stage timing of BoTSORT::track. Only collected when the library is built with BOTSORT_PROFILING
+ *  (cmake -DBOTSORT_PROFILING=ON), the instrumentation is compiled out otherwise and the statistics stay empty
+ *  (a few hundred bytes per tracker, the histograms never allocate their buckets)
+ */
+class TrackerStats {
+public:
+#ifdef BOTSORT_PROFILING
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+    static const std::array<const char *, NUM_TRACKER_STAGES> stage_names;
+
+    /**
+     * @brief Times the stages of one track() call: each lap is attributed to a stage, the whole call to Total
+     */
+    class FrameTimer {
+    private:
+        TrackerStats &_stats;
+        std::chrono::steady_clock::time_point _start, _last;
+
+
+    public:
+        explicit FrameTimer(TrackerStats &stats) : _stats(stats), _start(std::chrono::steady_clock::now()), _last(_start) {}
+        ~FrameTimer() {
+            _stats.stage(TrackerStage::Total).latency.record(_elapsed_ns(_start, std::chrono::steady_clock::now()));
+        }
+
+        FrameTimer(const FrameTimer &) = delete;
+        FrameTimer &operator=(const FrameTimer &) = delete;
+
+        /**
+         * @brief Attribute the time since the previous lap (or the start of the call) to the stage
+         */
+        void lap(TrackerStage stage) {
+            auto now = std::chrono::steady_clock::now();
+            _stats.stage(stage).latency.record(_elapsed_ns(_last, now));
+            _last = now;
+        }
+
+        void count(TrackerStage stage, size_t tracks, size_t detections, size_t matches) {
+            StageStats &stats = _stats.stage(stage);
+            stats.tracks += tracks;
+            stats.detections += detections;
+            stats.matches += matches;
+        }
+
+    private:
+        static uint64_t _elapsed_ns(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count());
+        }
+    };
+
+private:
+    std::array<StageStats, NUM_TRACKER_STAGES> _stages;
+
+
+public:
+    StageStats &stage(TrackerStage stage) { return _stages[static_cast<size_t>(stage)]; }
+    const StageStats &stage(TrackerStage stage) const { return _stages[static_cast<size_t>(stage)]; }
+
+    /**
+     * @brief Number of track() calls recorded
+     */
+    uint64_t frames() const { return stage(TrackerStage::Total).latency.count(); }
+
+    void reset();
+
+    /**
+     * @brief Markdown table of the latency percentiles (us) and the average counters per frame of every stage
+     */
+    std::string summary() const;
+};
+
+
+// Instrumentation of BoTSORT::track, compiled out (arguments not evaluated) without BOTSORT_PROFILING
+#ifdef BOTSORT_PROFILING
+#define BOTSORT_PROFILE_FRAME(stats) TrackerStats::FrameTimer _profile_frame_timer(stats)
+#define BOTSORT_PROFILE_STAGE(stage) _profile_frame_timer.lap(TrackerStage::stage)
+#define BOTSORT_PROFILE_COUNT(stage, tracks, detections, matches) \
+    _profile_frame_timer.count(TrackerStage::stage, tracks, detections, matches)
+#else
+#define BOTSORT_PROFILE_FRAME(stats) (void) 0
+#define BOTSORT_PROFILE_STAGE(stage) (void) 0
+#define BOTSORT_PROFILE_COUNT(stage, tracks, detections, matches) (void) 0
+#endif
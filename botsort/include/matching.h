@@ -1,6 +1,7 @@
 #pragma once
 
 #include "DataType.h"
+#include "FeatureHistory.h"
 #include "track.h"
 #include <tuple>
 
@@ -28,6 +29,22 @@ CostMatrix iou_distance(const std::vector<std::shared_ptr<Track>> &tracks,
                         const std::vector<std::shared_ptr<Track>> &detections);
 
 
+/**
+ * @brief Kernel computing the cosine distance matrix between track and detection embeddings
+ */
+using EmbeddingDistanceKernel = CostMatrix (*)(const std::vector<std::shared_ptr<Track>> &tracks,
+                                               const std::vector<std::shared_ptr<Track>> &detections);
+
+/**
+ * @brief Select the embedding distance kernel instantiated for the given feature dimension.
+ *  Fixed-size kernels exist for 128, 256, 512, 1024 and 2048 dimensional embeddings,
+ *  any other dimension falls back to the dynamic kernel
+ * 
+ * @param feature_dim Embedding dimension (output size of the Re-ID model)
+ * @return EmbeddingDistanceKernel Embedding distance kernel
+ */
+EmbeddingDistanceKernel select_embedding_distance_kernel(int feature_dim);
+
 /**
  * @brief Calculate the embedding distance between tracks and detections and create a mask for the cost matrix
  *  when the embedding distance is greater than the threshold
@@ -35,11 +52,16 @@ CostMatrix iou_distance(const std::vector<std::shared_ptr<Track>> &tracks,
  * @param tracks Tracks used to create the cost matrix
  * @param detections Tracks created from detections used to create the cost matrix
  * @param max_embedding_distance Threshold for embedding distance
+ * @param kernel (Optional) Embedding distance kernel, selected from the feature dimension if not provided
+ * @param metric (Optional) Track appearance to compare against: the smoothed feature (default), or the
+ *  minimum / mean distance over the feature history for the tracks which have one
  * @return std::tuple<CostMatrix, CostMatrix> Tuple of embedding distance cost matrix and embedding distance mask
  */
 std::tuple<CostMatrix, CostMatrix> embedding_distance(const std::vector<std::shared_ptr<Track>> &tracks,
                                                       const std::vector<std::shared_ptr<Track>> &detections,
-                                                      float max_embedding_distance);
+                                                      float max_embedding_distance,
+                                                      EmbeddingDistanceKernel kernel = nullptr,
+                                                      AppearanceMetric metric = AppearanceMetric::Smooth);
 
 /**
  * @brief Fuses the detection score into the cost matrix in-place
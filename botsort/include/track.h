@@ -1,8 +1,9 @@
 #pragma once
 
+#include "AppearanceStore.h"
+#include "FeatureHistory.h"
 #include "KalmanFilter.h"
 #include "KalmanFilterAccBased.h"
-#include <deque>
 #include <memory>
 
 using KalmanFilter = bot_kalman::KalmanFilter;
@@ -22,8 +23,9 @@ public:
     int state;
 
     uint32_t frame_id, tracklet_len, start_frame;
+    uint32_t feat_frame_id = 0;// Frame-id at which the model extracted curr_feat
 
-    std::vector<float> det_tlwh;
+    std::vector<float> det_tlwh;// Latest associated detection box
     std::shared_ptr<FeatureVector> curr_feat;
     std::unique_ptr<FeatureVector> smooth_feat;
     KFStateSpaceVec mean;
@@ -37,7 +39,9 @@ private:
     static constexpr float _alpha = 0.9;
 
     int _feat_history_size;
-    std::deque<std::shared_ptr<FeatureVector>> _feat_history;
+    std::unique_ptr<FeatureHistory> _feat_history;
+    std::shared_ptr<AppearanceStore> _appearance_store;
+    AppearanceStore::Slot _smooth_feat_slot = AppearanceStore::INVALID_SLOT;
 
 
 public:
@@ -48,16 +52,45 @@ public:
      * @param score Detection score
      * @param class_id Detection class ID
      * @param feat (Optional) Detection feature vector
+     * @param appearance_store (Optional) Store holding the feature history and the features of lost tracks
      * @param feat_history_size Size of the feature history (default: 50)
      */
-    Track(std::vector<float> tlwh, float score, uint8_t class_id, std::optional<FeatureVector> feat = std::nullopt, int feat_history_size = 50);
+    Track(std::vector<float> tlwh,
+          float score,
+          uint8_t class_id,
+          std::optional<FeatureVector> feat = std::nullopt,
+          std::shared_ptr<AppearanceStore> appearance_store = nullptr,
+          int feat_history_size = 50);
+    ~Track();
 
     /**
-     * @brief Get the next track ID
+     * @brief Get the slot of the smoothed feature in the appearance store.
+     *  Valid only while the smoothed feature is compacted (i.e. the track is lost), smooth_feat is null then
      * 
-     * @return int Next track ID
+     * @return AppearanceStore::Slot Slot of the compacted smoothed feature
      */
-    static int next_id();
+    AppearanceStore::Slot smooth_feat_slot() const;
+
+    /**
+     * @brief Get the smoothed feature of the track, restored from the appearance store if it was compacted
+     * 
+     * @return std::optional<FeatureVector> Smoothed feature (nullopt if the track has no feature)
+     */
+    std::optional<FeatureVector> get_smooth_feat() const;
+
+    /**
+     * @brief Get the appearance store of the track
+     * 
+     * @return const std::shared_ptr<AppearanceStore>& Appearance store (nullptr if not attached)
+     */
+    const std::shared_ptr<AppearanceStore> &appearance_store() const;
+
+    /**
+     * @brief Get the history of the latest features of the track
+     * 
+     * @return const FeatureHistory* Feature history (nullptr if the track has no feature or no appearance store)
+     */
+    const FeatureHistory *feature_history() const;
 
     /**
      * @brief Get end frame-id of the track
@@ -68,6 +101,7 @@ public:
 
     /**
      * @brief Upates the track state to Lost
+     *  The smoothed feature is moved into the appearance store (if attached) until the track is found again
      * 
      */
     void mark_lost();
@@ -96,13 +130,21 @@ public:
      */
     float get_score() const;
 
+    /**
+     * @brief Get the class ID of the track
+     * 
+     * @return uint8_t Class ID with the highest accumulated detection score
+     */
+    uint8_t get_class_id() const;
+
     /**
      * @brief Activates the track
      * 
      * @param kalman_filter Kalman filter object for the track
      * @param frame_id Current frame-id
+     * @param track_id Track ID, allocated by the tracker (or re-used, e.g. re-identified from the gallery)
      */
-    void activate(KalmanFilter &kalman_filter, uint32_t frame_id);
+    void activate(KalmanFilter &kalman_filter, uint32_t frame_id, int track_id);
 
     /**
      * @brief Re-activates the track
@@ -110,9 +152,9 @@ public:
      * @param kalman_filter Kalman filter object
      * @param new_track New track object
      * @param frame_id Current frame-id
-     * @param new_id Whether to assign a new ID to the track (default: false)
+     * @param new_track_id (Optional) New ID to assign to the track, the track keeps its ID if not provided
      */
-    void re_activate(KalmanFilter &kalman_filter, Track &new_track, uint32_t frame_id, bool new_id = false);
+    void re_activate(KalmanFilter &kalman_filter, Track &new_track, uint32_t frame_id, std::optional<int> new_track_id = std::nullopt);
 
     /**
      * @brief Predict the next state of the track using the Kalman filter
@@ -152,6 +194,33 @@ public:
      */
     void update(KalmanFilter &kalman_filter, Track &new_track, uint32_t frame_id);
 
+    /**
+     * @brief Update the appearance of the track with a feature extracted after the association
+     *  (e.g. by the asynchronous Re-ID worker). The feature of a lost track stays compacted
+     * 
+     * @param feat Feature vector of the detection associated with the track
+     */
+    void update_features(const FeatureVector &feat);
+
+    /**
+     * @brief Write the complete state of the track to a snapshot (Kalman filter state, features, class history)
+     * 
+     * @param writer Snapshot writer
+     */
+    void save_state(SnapshotWriter &writer) const;
+
+    /**
+     * @brief Create a track from a snapshot written by save_state
+     * 
+     * @param reader Snapshot reader
+     * @param appearance_store (Optional) Store holding the feature history and the features of lost tracks
+     * @param feat_history_size Size of the feature history (default: 50)
+     * @return std::shared_ptr<Track> Restored track
+     */
+    static std::shared_ptr<Track> load_state(SnapshotReader &reader,
+                                             std::shared_ptr<AppearanceStore> appearance_store = nullptr,
+                                             int feat_history_size = 50);
+
 private:
     /**
      * @brief Updates visual feature vector and feature history
@@ -161,6 +230,23 @@ private:
      */
     void _update_features(const std::shared_ptr<FeatureVector> &feat);
 
+    /**
+     * @brief Add the current feature to the feature history, creating the history on first use
+     */
+    void _push_feature_history();
+
+    /**
+     * @brief Move the smoothed feature into the appearance store in its storage precision
+     * 
+     */
+    void _compact_features();
+
+    /**
+     * @brief Restore the smoothed feature from the appearance store
+     * 
+     */
+    void _restore_features();
+
     /**
      * @brief Populate a DetVec bbox object (xywh) from the detection bounding box (tlwh)
      * 
@@ -37,4 +37,23 @@ double lapjv(CostMatrix &cost,
              std::vector<int> &colsol,
              bool extend_cost = false,
              float cost_limit = std::numeric_limits<float>::max(),
-             bool return_cost = true);
\ No newline at end of file
+             bool return_cost = true);
+
+
+/**
+ * @brief Convert floats to IEEE 754 half precision floats (stored as uint16_t)
+ * 
+ * @param in Input floats
+ * @param out Output half precision floats
+ * @param n Number of elements
+ */
+void floats_to_halfs(const float *in, uint16_t *out, int n);
+
+/**
+ * @brief Convert IEEE 754 half precision floats (stored as uint16_t) to floats
+ * 
+ * @param in Input half precision floats
+ * @param out Output floats
+ * @param n Number of elements
+ */
+void halfs_to_floats(const uint16_t *in, float *out, int n);
\ No newline at end of file
@@ -0,0 +1,164 @@
+#include "AppearanceStore.h"
+#include "utils.h"
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+std::map<std::string, FeaturePrecision> AppearanceStore::precision_map = {
+        {"fp32", FeaturePrecision::FP32},
+        {"fp16", FeaturePrecision::FP16},
+        {"int8", FeaturePrecision::INT8},
+};
+
+
+namespace {
+size_t bytes_per_element(FeaturePrecision precision) {
+    switch (precision) {
+        case FeaturePrecision::FP32:
+            return sizeof(float);
+        case FeaturePrecision::FP16:
+            return sizeof(uint16_t);
+        case FeaturePrecision::INT8:
+            return sizeof(int8_t);
+    }
+    throw std::runtime_error("Unknown feature precision: " + std::to_string(precision));
+}
+}// namespace
+
+
+AppearanceStore::AppearanceStore(int feature_dim, FeaturePrecision precision, size_t initial_capacity)
+    : _feature_dim(feature_dim),
+      _precision(precision) {
+    // Pad every slot to a multiple of 64 bytes (cache line) so that no feature straddles more lines than needed
+    _slot_bytes = ((static_cast<size_t>(_feature_dim) * bytes_per_element(_precision) + 63) / 64) * 64;
+
+    _arena.reserve(initial_capacity * _slot_bytes);
+    _scales.reserve(initial_capacity);
+}
+
+AppearanceStore::Slot AppearanceStore::allocate() {
+    if (!_free_slots.empty()) {
+        Slot slot = _free_slots.back();
+        _free_slots.pop_back();
+        return slot;
+    }
+
+    auto slot = static_cast<Slot>(_num_slots++);
+    _arena.resize(_num_slots * _slot_bytes);
+    _scales.resize(_num_slots, 1.0F);
+    return slot;
+}
+
+void AppearanceStore::release(Slot slot) {
+    if (slot != INVALID_SLOT) {
+        _free_slots.push_back(slot);
+    }
+}
+
+void AppearanceStore::store(Slot slot, const FeatureVector &feature) {
+    uint8_t *data = _arena.data() + static_cast<size_t>(slot) * _slot_bytes;
+
+    switch (_precision) {
+        case FeaturePrecision::FP32:
+            std::memcpy(data, feature.data(), _feature_dim * sizeof(float));
+            break;
+        case FeaturePrecision::FP16:
+            floats_to_halfs(feature.data(), reinterpret_cast<uint16_t *>(data), _feature_dim);
+            break;
+        case FeaturePrecision::INT8: {
+            // Symmetric quantization with a per-vector scale
+            const float max_abs = feature.cwiseAbs().maxCoeff();
+            const float scale = max_abs > 0.0F ? max_abs / 127.0F : 1.0F;
+            Eigen::Map<Eigen::Matrix<int8_t, 1, Eigen::Dynamic>> quantized(reinterpret_cast<int8_t *>(data), _feature_dim);
+            quantized = (feature.array() / scale).round().cast<int8_t>();
+            _scales[slot] = scale;
+            break;
+        }
+    }
+}
+
+FeatureVector AppearanceStore::load(Slot slot) const {
+    FeatureVector feature(_feature_dim);
+    _dequantize(slot, feature.data());
+    return feature;
+}
+
+void AppearanceStore::_dequantize(Slot slot, float *out) const {
+    const uint8_t *data = _arena.data() + static_cast<size_t>(slot) * _slot_bytes;
+
+    switch (_precision) {
+        case FeaturePrecision::FP32:
+            std::memcpy(out, data, _feature_dim * sizeof(float));
+            break;
+        case FeaturePrecision::FP16:
+            halfs_to_floats(reinterpret_cast<const uint16_t *>(data), out, _feature_dim);
+            break;
+        case FeaturePrecision::INT8: {
+            Eigen::Map<const Eigen::Matrix<int8_t, 1, Eigen::Dynamic>> quantized(reinterpret_cast<const int8_t *>(data), _feature_dim);
+            Eigen::Map<FeatureVector>(out, _feature_dim) = quantized.cast<float>() * _scales[slot];
+            break;
+        }
+    }
+}
+
+void AppearanceStore::save_slot(Slot slot, SnapshotWriter &writer) const {
+    writer.write_bytes(_arena.data() + static_cast<size_t>(slot) * _slot_bytes, _feature_dim * bytes_per_element(_precision));
+    if (_precision == FeaturePrecision::INT8) {
+        writer.write(_scales[slot]);
+    }
+}
+
+void AppearanceStore::load_slot(Slot slot, SnapshotReader &reader) {
+    reader.read_bytes(_arena.data() + static_cast<size_t>(slot) * _slot_bytes, _feature_dim * bytes_per_element(_precision));
+    if (_precision == FeaturePrecision::INT8) {
+        _scales[slot] = reader.read<float>();
+    }
+}
+
+template<typename SlotAt>
+CostMatrix AppearanceStore::_blocked_dot(Eigen::Index num_slots, SlotAt slot_at,
+                                         const Eigen::Ref<const FeatureMatrix> &queries) const {
+    CostMatrix products(num_slots, queries.rows());
+    if (num_slots == 0 || queries.rows() == 0) {
+        return products;
+    }
+
+    FeatureMatrix block(std::min(_dequantize_block_rows, num_slots), _feature_dim);
+    for (Eigen::Index start = 0; start < num_slots; start += _dequantize_block_rows) {
+        const Eigen::Index rows = std::min(_dequantize_block_rows, num_slots - start);
+        for (Eigen::Index i = 0; i < rows; i++) {
+            _dequantize(slot_at(start + i), block.row(i).data());
+        }
+        products.middleRows(start, rows).noalias() = block.topRows(rows) * queries.transpose();
+    }
+
+    return products;
+}
+
+CostMatrix AppearanceStore::dot(const std::vector<Slot> &slots, const Eigen::Ref<const FeatureMatrix> &queries) const {
+    return _blocked_dot(
+            static_cast<Eigen::Index>(slots.size()), [&slots](Eigen::Index i) { return slots[i]; }, queries);
+}
+
+CostMatrix AppearanceStore::dot(Slot first, size_t count, const Eigen::Ref<const FeatureMatrix> &queries) const {
+    return _blocked_dot(
+            static_cast<Eigen::Index>(count), [first](Eigen::Index i) { return static_cast<Slot>(first + i); },
+            queries);
+}
+
+int AppearanceStore::feature_dim() const {
+    return _feature_dim;
+}
+
+FeaturePrecision AppearanceStore::precision() const {
+    return _precision;
+}
+
+size_t AppearanceStore::size() const {
+    return _num_slots - _free_slots.size();
+}
+
+size_t AppearanceStore::memory_bytes() const {
+    return _arena.capacity() + _scales.capacity() * sizeof(float);
+}
@@ -1,15 +1,47 @@
 #include "BoTSORT.h"
 #include "DataType.h"
 #include "INIReader.h"
+#include "Tracing.h"
 #include "matching.h"
 #include <opencv2/imgproc.hpp>
+#include <atomic>
+#include <chrono>
+#include <cmath>
 #include <optional>
+#include <stdexcept>
+#include <unordered_map>
 #include <unordered_set>
 
-BoTSORT::BoTSORT(const std::string &config_dir) {
-    _load_params_from_config(config_dir);
+
+namespace {
+/**
+ * @brief Look up the value of an enumerated config parameter without inserting it in the map,
+ *  throws std::runtime_error naming the parameter if the value is unknown
+ */
+template<typename Map>
+typename Map::mapped_type config_choice(const Map &choices, const std::string &parameter, const std::string &value) {
+    auto it = choices.find(value);
+    if (it == choices.end()) {
+        throw std::runtime_error("Unknown " + parameter + ": \"" + value + "\"");
+    }
+    return it->second;
+}
+}// namespace
+
+
+BoTSORT::BoTSORT(const std::string &config_dir, const std::optional<std::string> &gmc_method)
+    : BoTSORT(TrackerConfig::load(config_dir), gmc_method) {}
+
+
+BoTSORT::BoTSORT(const TrackerConfig &config, const std::optional<std::string> &gmc_method) {
+    _load_params_from_config(config.tracker);
+    if (gmc_method) {
+        _gmc_method_name = gmc_method.value();
+    }
 
     // Tracker module
+    static std::atomic<int> num_trackers{0};
+    _stream_id = num_trackers++;
     _frame_id = 0;
     _buffer_size = static_cast<uint8_t>(_frame_rate / 30.0 * _track_buffer);
     _max_time_lost = _buffer_size;
@@ -17,21 +49,100 @@ BoTSORT::BoTSORT(const std::string &config_dir) {
 
 
     // Re-ID module, load visual feature extractor here
-    if (_reid_model_weights_path) {
-        _reid_model = std::make_unique<ReIDModel>(_reid_model_weights_path.value(), _fp16_inference);
+    // The CNN needs model weights, handcrafted appearance models do not
+    ReID_Method reid_method = config_choice(ReIDModel::ReID_method_map, "reid_method", _reid_method_name);
+    FeaturePrecision feature_storage = FeaturePrecision::FP16;
+    if (_reid_model_weights_path || reid_method != ReID_Method::CNN) {
+        feature_storage = config_choice(AppearanceStore::precision_map, "feature_storage", _feature_storage_name);
+        _reid_model = std::make_unique<ReIDModel>(reid_method, _reid_model_weights_path.value_or(""), _reid_feature_dim, _fp16_inference);
+        _embedding_distance_kernel = select_embedding_distance_kernel(_reid_model->feature_dim());
+        _appearance_metric = config_choice(FeatureHistory::metric_map, "appearance_metric", _appearance_metric_name);
+        _appearance_store = std::make_shared<AppearanceStore>(_reid_model->feature_dim(), feature_storage);
         _reid_enabled = true;
+
+        if (_reid_async) {
+            _reid_worker = std::make_unique<ReIDWorker>(*_reid_model);
+        }
     } else {
         std::cout << "Re-ID module disabled" << std::endl;
         _reid_enabled = false;
+        _reid_async = false;
+    }
+
+    // Long-term Re-ID gallery, keeps the identities of removed tracks
+    if (_reid_enabled && _gallery_enabled) {
+        _gallery = std::make_unique<ReIDGallery>(_reid_model->feature_dim(),
+                                                 feature_storage,
+                                                 _gallery_capacity,
+                                                 static_cast<uint32_t>(_gallery_ttl * _frame_rate),
+                                                 _gallery_num_lists,
+                                                 _gallery_num_probes);
+    }
+
+
+    // Embedding reuse cache, skips the model for detections of (almost) static tracks
+    if (_reid_enabled && !_reid_async && _embedding_cache_enabled) {
+        _embedding_cache = std::make_unique<EmbeddingCache>(_embedding_cache_iou_thresh,
+                                                            _embedding_cache_max_age,
+                                                            _embedding_cache_max_size_change,
+                                                            _embedding_cache_occlusion_thresh);
     }
 
 
     // Global motion compensation module
-    _gmc_algo = std::make_unique<GlobalMotionCompensation>(GlobalMotionCompensation::GMC_method_map[_gmc_method_name], config_dir);
+    _gmc_method = config_choice(GlobalMotionCompensation::GMC_method_map, "gmc_method", _gmc_method_name);
+    if (_gmc_method != GMC_Method::NoGMC && !config.config_dir.empty() && config.gmc.ParseError() < 0) {
+        std::cout << "Can't load " << config.config_dir << "/gmc.ini" << std::endl;
+        exit(1);
+    }
+    _gmc_algo = std::make_unique<GlobalMotionCompensation>(_gmc_method, config.gmc);
 }
 
 
 std::vector<std::shared_ptr<Track>> BoTSORT::track(const std::vector<Detection> &detections, const cv::Mat &frame) {
+    return _track(detections, frame, frame.size());
+}
+
+std::vector<std::shared_ptr<Track>> BoTSORT::track(const std::vector<Detection> &detections, const cv::Size &image_size) {
+    if (!can_track_without_frames()) {
+        throw std::runtime_error("Tracking without frames requires the Re-ID module disabled and gmc_method = none");
+    }
+    return _track(detections, cv::Mat(), image_size);
+}
+
+bool BoTSORT::can_track_without_frames() const {
+    return !_reid_enabled && _gmc_method == GMC_Method::NoGMC;
+}
+
+std::vector<std::shared_ptr<Track>> BoTSORT::replay(const RecordedFrame &inputs) {
+    if (_reid_async) {
+        throw std::runtime_error("Replaying the recorded inputs is not supported with asynchronous Re-ID");
+    }
+    return _track(inputs.detections, cv::Mat(), inputs.image_size, &inputs);
+}
+
+int BoTSORT::reid_feature_dim() const {
+    return _appearance_store ? _appearance_store->feature_dim() : 0;
+}
+
+std::vector<std::shared_ptr<Track>> BoTSORT::_track(const std::vector<Detection> &detections, const cv::Mat &frame, const cv::Size &image_size,
+                                                    const RecordedFrame *replayed) {
+    BOTSORT_PROFILE_FRAME(_stats);
+    tracing::FrameContext trace_context(_stream_id, _frame_id + 1);
+    tracing::Scope trace_frame("track", "tracker");
+    tracing::Laps trace_stages("tracker");
+
+    // Inputs of the call, for the input log
+    std::optional<RecordedFrame> recorded;
+    std::chrono::steady_clock::time_point call_start;
+    if (_input_log) {
+        call_start = std::chrono::steady_clock::now();
+        recorded.emplace();
+        recorded->timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::system_clock::now().time_since_epoch())
+                                         .count();
+    }
+
     ////////////////// CREATE TRACK OBJECT FOR ALL THE DETECTIONS //////////////////
     // For all detections, extract features, create tracks and classify on the segregate of confidence
     _frame_id++;
@@ -39,33 +150,80 @@ std::vector<std::shared_ptr<Track>> BoTSORT::track(const std::vector<Detection>
     std::vector<std::shared_ptr<Track>> detections_high_conf, detections_low_conf;
     detections_low_conf.reserve(detections.size()), detections_high_conf.reserve(detections.size());
 
+    // With asynchronous Re-ID, the features of this frame are extracted while it is associated with IoU and motion only
+    const bool appearance_available = _reid_enabled && !_reid_async;
+    std::vector<std::shared_ptr<Track>> detection_tracklets;
+    PendingFeatures pending_features;
+
     if (!detections.empty()) {
+        std::vector<const Detection *> valid_detections;
+        std::vector<cv::Rect_<float>> valid_bboxes;
+        valid_detections.reserve(detections.size()), valid_bboxes.reserve(detections.size());
+
         for (Detection &detection: const_cast<std::vector<Detection> &>(detections)) {
             detection.bbox_tlwh.x = std::max(0.0f, detection.bbox_tlwh.x);
             detection.bbox_tlwh.y = std::max(0.0f, detection.bbox_tlwh.y);
-            detection.bbox_tlwh.width = std::min(static_cast<float>(frame.cols - 1), detection.bbox_tlwh.width);
-            detection.bbox_tlwh.height = std::min(static_cast<float>(frame.rows - 1), detection.bbox_tlwh.height);
+            detection.bbox_tlwh.width = std::min(static_cast<float>(image_size.width - 1), detection.bbox_tlwh.width);
+            detection.bbox_tlwh.height = std::min(static_cast<float>(image_size.height - 1), detection.bbox_tlwh.height);
+
+            if (detection.confidence > _track_low_thresh) {
+                valid_detections.push_back(&detection);
+                valid_bboxes.push_back(detection.bbox_tlwh);
+            }
+        }
+
+        // Extract the features of all the detections at once
+        FeatureMatrix embeddings;
+        std::vector<uint32_t> feat_frame_ids;
+        if (appearance_available && replayed) {
+            if (static_cast<size_t>(replayed->features.rows()) != valid_bboxes.size() || replayed->feat_frame_ids.size() != valid_bboxes.size()) {
+                throw std::runtime_error("The recorded Re-ID features do not match the detections, was the log recorded with the same config?");
+            }
+            if (replayed->features.rows() > 0 && replayed->features.cols() != _appearance_store->feature_dim()) {
+                throw std::runtime_error("The recorded Re-ID features have dimension " + std::to_string(replayed->features.cols()) +
+                                         ", the tracker uses " + std::to_string(_appearance_store->feature_dim()));
+            }
+            embeddings = replayed->features;
+            feat_frame_ids = replayed->feat_frame_ids;
+        } else if (appearance_available) {
+            embeddings = _extract_features(frame, valid_bboxes, feat_frame_ids);
+        } else if (_reid_async && !valid_bboxes.empty() && _pending_features.size() < _max_pending_features) {
+            pending_features.features = _reid_worker->submit(frame, valid_bboxes);
+        }
+        if (recorded && appearance_available) {
+            recorded->features = embeddings;
+            recorded->feat_frame_ids = feat_frame_ids;
+        }
 
+        for (size_t i = 0; i < valid_detections.size(); i++) {
+            const Detection &detection = *valid_detections[i];
             std::shared_ptr<Track> tracklet;
             std::vector<float> tlwh = {detection.bbox_tlwh.x, detection.bbox_tlwh.y, detection.bbox_tlwh.width, detection.bbox_tlwh.height};
 
-            if (detection.confidence > _track_low_thresh) {
-                if (_reid_enabled) {
-                    FeatureVector embedding = _extract_features(frame, detection.bbox_tlwh);
-                    tracklet = std::make_shared<Track>(tlwh, detection.confidence, detection.class_id, embedding);
-                } else {
-                    tracklet = std::make_shared<Track>(tlwh, detection.confidence, detection.class_id);
-                }
+            if (appearance_available) {
+                FeatureVector embedding = embeddings.row(static_cast<Eigen::Index>(i));
+                tracklet = std::make_shared<Track>(tlwh, detection.confidence, detection.class_id, embedding, _appearance_store);
+                tracklet->feat_frame_id = feat_frame_ids[i];
+            } else if (_reid_async) {
+                tracklet = std::make_shared<Track>(tlwh, detection.confidence, detection.class_id, std::nullopt, _appearance_store);
+            } else {
+                tracklet = std::make_shared<Track>(tlwh, detection.confidence, detection.class_id);
+            }
 
-                if (detection.confidence >= _track_high_thresh) {
-                    detections_high_conf.push_back(tracklet);
-                } else {
-                    detections_low_conf.push_back(tracklet);
-                }
+            if (detection.confidence >= _track_high_thresh) {
+                detections_high_conf.push_back(tracklet);
+            } else {
+                detections_low_conf.push_back(tracklet);
             }
+            detection_tracklets.push_back(tracklet);
         }
     }
 
+    // Features of the previous frames update the tracks they were associated with
+    if (_reid_async) {
+        _apply_pending_features();
+    }
+
     // Segregate tracks in unconfirmed and tracked tracks
     std::vector<std::shared_ptr<Track>> unconfirmed_tracks, tracked_tracks;
     for (const std::shared_ptr<Track> &track: _tracked_tracks) {
@@ -75,6 +233,9 @@ std::vector<std::shared_ptr<Track>> BoTSORT::track(const std::vector<Detection>
             tracked_tracks.push_back(track);
         }
     }
+    BOTSORT_PROFILE_COUNT(DetectionIntake, 0, detections.size(), 0);
+    BOTSORT_PROFILE_STAGE(DetectionIntake);
+    trace_stages.lap("detection_intake");
     ////////////////// CREATE TRACK OBJECT FOR ALL THE DETECTIONS //////////////////
 
 
@@ -85,11 +246,16 @@ std::vector<std::shared_ptr<Track>> BoTSORT::track(const std::vector<Detection>
 
     // Predict the location of the tracks with KF (even for lost tracks)
     Track::multi_predict(tracks_pool, *_kalman_filter);
+    BOTSORT_PROFILE_COUNT(Predict, tracks_pool.size(), 0, 0);
+    BOTSORT_PROFILE_STAGE(Predict);
+    trace_stages.lap("predict");
 
     // Estimate camera motion and apply camera motion compensation
-    HomographyMatrix H = _gmc_algo->apply(frame, detections);
+    HomographyMatrix H = replayed ? replayed->homography : _gmc_algo->apply(frame, detections);
     Track::multi_gmc(tracks_pool, H);
     Track::multi_gmc(unconfirmed_tracks, H);
+    BOTSORT_PROFILE_STAGE(GMC);
+    trace_stages.lap("gmc");
     ////////////////// Apply KF predict and GMC before running association algorithm //////////////////
 
 
@@ -103,11 +269,13 @@ std::vector<std::shared_ptr<Track>> BoTSORT::track(const std::vector<Detection>
                                                                        _proximity_thresh);
     fuse_score(iou_dists, detections_high_conf);// Fuse the score with IoU distance
 
-    if (_reid_enabled) {
+    if (appearance_available) {
         // If re-ID is enabled, find the embedding distance between all tracked tracks and high confidence detections
         std::tie(raw_emd_dist, emd_dist_mask_1st_association) = embedding_distance(tracks_pool,
                                                                                    detections_high_conf,
-                                                                                   _appearance_thresh);
+                                                                                   _appearance_thresh,
+                                                                                   _embedding_distance_kernel,
+                                                                                   _appearance_metric);
         fuse_motion(*_kalman_filter,
                     raw_emd_dist,
                     tracks_pool,
@@ -136,10 +304,13 @@ std::vector<std::shared_ptr<Track>> BoTSORT::track(const std::vector<Detection>
         } else {
             // If track was not being actively tracked, we re-activate the track with the new associated detection
             // NOTE: There should be a minimum number of frames before a track is re-activated
-            track->re_activate(*_kalman_filter, *detection, _frame_id, false);
+            track->re_activate(*_kalman_filter, *detection, _frame_id);
             refind_tracks.push_back(track);
         }
     }
+    BOTSORT_PROFILE_COUNT(FirstAssociation, tracks_pool.size(), detections_high_conf.size(), first_associations.matches.size());
+    BOTSORT_PROFILE_STAGE(FirstAssociation);
+    trace_stages.lap("first_association");
     ////////////////// First association, with high score detection boxes //////////////////
 
 
@@ -172,7 +343,7 @@ std::vector<std::shared_ptr<Track>> BoTSORT::track(const std::vector<Detection>
         } else {
             // If track was not being actively tracked, we re-activate the track with the new associated detection
             // NOTE: There should be a minimum number of frames before a track is re-activated
-            track->re_activate(*_kalman_filter, *detection, _frame_id, false);
+            track->re_activate(*_kalman_filter, *detection, _frame_id);
             refind_tracks.push_back(track);
         }
     }
@@ -186,6 +357,9 @@ std::vector<std::shared_ptr<Track>> BoTSORT::track(const std::vector<Detection>
             lost_tracks.push_back(track);
         }
     }
+    BOTSORT_PROFILE_COUNT(SecondAssociation, unmatched_tracks_after_1st_association.size(), detections_low_conf.size(), second_associations.matches.size());
+    BOTSORT_PROFILE_STAGE(SecondAssociation);
+    trace_stages.lap("second_association");
     ////////////////// Second association, with low score detection boxes //////////////////
 
 
@@ -204,11 +378,13 @@ std::vector<std::shared_ptr<Track>> BoTSORT::track(const std::vector<Detection>
                                                                                _proximity_thresh);
     fuse_score(iou_dists_unconfirmed, unmatched_detections_after_1st_association);
 
-    if (_reid_enabled) {
+    if (appearance_available) {
         // Find embedding distance between unconfirmed tracks and high confidence detections left after the first association
         std::tie(raw_emd_dist_unconfirmed, emd_dist_mask_unconfirmed) = embedding_distance(unconfirmed_tracks,
                                                                                            unmatched_detections_after_1st_association,
-                                                                                           _appearance_thresh);
+                                                                                           _appearance_thresh,
+                                                                                           _embedding_distance_kernel,
+                                                                                           _appearance_metric);
         fuse_motion(*_kalman_filter,
                     raw_emd_dist_unconfirmed,
                     unconfirmed_tracks,
@@ -242,6 +418,9 @@ std::vector<std::shared_ptr<Track>> BoTSORT::track(const std::vector<Detection>
         track->mark_removed();
         removed_tracks.push_back(track);
     }
+    BOTSORT_PROFILE_COUNT(Unconfirmed, unconfirmed_tracks.size(), unmatched_detections_after_1st_association.size(), unconfirmed_associations.matches.size());
+    BOTSORT_PROFILE_STAGE(Unconfirmed);
+    trace_stages.lap("unconfirmed");
     ////////////////// Deal with unconfirmed tracks //////////////////
 
 
@@ -253,22 +432,85 @@ std::vector<std::shared_ptr<Track>> BoTSORT::track(const std::vector<Detection>
     }
 
     // Initialize new tracks for the high confidence detections left after all the associations
+    std::vector<std::shared_ptr<Track>> new_tracks;
     for (const std::shared_ptr<Track> &detection: unmatched_high_conf_detections) {
         if (detection->get_score() >= _new_track_thresh) {
-            detection->activate(*_kalman_filter, _frame_id);
-            activated_tracks.push_back(detection);
+            new_tracks.push_back(detection);
         }
     }
+
+    // Before assigning new IDs, query the long-term gallery so that re-entering objects get their old ID back
+    std::vector<std::optional<int>> recovered_track_ids(new_tracks.size());
+    // With asynchronous Re-ID, the new tracks are looked up once their features are available
+    if (_gallery && appearance_available && !new_tracks.empty()) {
+        _gallery->expire(_frame_id);
+
+        FeatureMatrix new_track_features(static_cast<Eigen::Index>(new_tracks.size()), _reid_model->feature_dim());
+        for (size_t i = 0; i < new_tracks.size(); i++) {
+            new_track_features.row(static_cast<Eigen::Index>(i)) = *new_tracks[i]->smooth_feat;
+        }
+        recovered_track_ids = _gallery->reidentify(new_track_features, _gallery_match_thresh);
+    }
+
+    for (size_t i = 0; i < new_tracks.size(); i++) {
+        int track_id = recovered_track_ids[i] ? recovered_track_ids[i].value() : _next_track_id();
+        new_tracks[i]->activate(*_kalman_filter, _frame_id, track_id);
+        activated_tracks.push_back(new_tracks[i]);
+    }
     ////////////////// Initialize new tracks //////////////////
 
 
+    ////////////////// Queue the asynchronous features //////////////////
+    // Remember which track every detection ended up in, the features are applied to these tracks once extracted
+    if (pending_features.features.valid()) {
+        std::unordered_map<const Track *, std::shared_ptr<Track>> associated_tracks;
+        for (const std::pair<int, int> &match: first_associations.matches) {
+            associated_tracks[detections_high_conf[match.second].get()] = tracks_pool[match.first];
+        }
+        for (const std::pair<int, int> &match: second_associations.matches) {
+            associated_tracks[detections_low_conf[match.second].get()] = unmatched_tracks_after_1st_association[match.first];
+        }
+        for (const std::pair<int, int> &match: unconfirmed_associations.matches) {
+            associated_tracks[unmatched_detections_after_1st_association[match.second].get()] = unconfirmed_tracks[match.first];
+        }
+        for (const std::shared_ptr<Track> &track: new_tracks) {
+            associated_tracks[track.get()] = track;
+        }
+
+        pending_features.tracks.resize(detection_tracklets.size());
+        pending_features.new_tracks.resize(detection_tracklets.size(), false);
+        for (size_t i = 0; i < detection_tracklets.size(); i++) {
+            auto associated_track = associated_tracks.find(detection_tracklets[i].get());
+            if (associated_track != associated_tracks.end()) {
+                pending_features.tracks[i] = associated_track->second;
+                pending_features.new_tracks[i] = associated_track->second == detection_tracklets[i];
+            }
+        }
+        _pending_features.push_back(std::move(pending_features));
+    }
+    BOTSORT_PROFILE_COUNT(NewTracks, 0, unmatched_high_conf_detections.size(), new_tracks.size());
+    BOTSORT_PROFILE_STAGE(NewTracks);
+    trace_stages.lap("new_tracks");
+    ////////////////// Queue the asynchronous features //////////////////
+
+
     ////////////////// Update lost tracks state //////////////////
     for (const std::shared_ptr<Track> &track: _lost_tracks) {
         if (_frame_id - track->end_frame() > _max_time_lost) {
             track->mark_removed();
             removed_tracks.push_back(track);
+
+            if (_gallery) {
+                std::optional<FeatureVector> smooth_feat = track->get_smooth_feat();
+                if (smooth_feat) {
+                    _gallery->insert(track->track_id, smooth_feat.value(), _frame_id);
+                }
+            }
         }
     }
+    BOTSORT_PROFILE_COUNT(Lifecycle, _lost_tracks.size(), 0, removed_tracks.size());
+    BOTSORT_PROFILE_STAGE(Lifecycle);
+    trace_stages.lap("lifecycle");
     ////////////////// Update lost tracks state //////////////////
 
 
@@ -299,15 +541,275 @@ std::vector<std::shared_ptr<Track>> BoTSORT::track(const std::vector<Detection>
             output_tracks.push_back(track);
         }
     }
+    BOTSORT_PROFILE_COUNT(Cleanup, output_tracks.size(), 0, 0);
+    BOTSORT_PROFILE_STAGE(Cleanup);
+    trace_stages.lap("cleanup");
     ////////////////// Update output tracks //////////////////
 
+
+    ////////////////// Record the inputs of the call //////////////////
+    if (recorded) {
+        recorded->frame_id = _frame_id;
+        recorded->image_size = image_size;
+        recorded->homography = H;
+        recorded->detections = detections;// Clipped, clipping again on replay leaves them unchanged
+        recorded->num_output_tracks = static_cast<uint32_t>(output_tracks.size());
+        recorded->output_hash = input_log::hash_tracks(output_tracks);
+        recorded->duration_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - call_start).count();
+        _input_log->write(recorded.value());
+    }
+    ////////////////// Record the inputs of the call //////////////////
+
     return output_tracks;
 }
 
-FeatureVector BoTSORT::_extract_features(const cv::Mat &frame, const cv::Rect_<float> &bbox_tlwh) {
-    cv::Mat patch = frame(bbox_tlwh);
-    cv::Mat patch_resized;
-    return _reid_model->extract_features(patch_resized);
+FeatureMatrix BoTSORT::_extract_features(const cv::Mat &frame, const std::vector<cv::Rect_<float>> &bboxes, std::vector<uint32_t> &feat_frame_ids) {
+    feat_frame_ids.assign(bboxes.size(), _frame_id);
+    if (bboxes.empty()) {
+        return FeatureMatrix(0, _reid_model->feature_dim());
+    }
+    if (!_embedding_cache) {
+        return _reid_model->extract_features(frame, bboxes);
+    }
+
+    std::vector<std::shared_ptr<Track>> cached_tracks = _embedding_cache->lookup(bboxes, _tracked_tracks, _frame_id);
+
+    std::vector<cv::Rect_<float>> uncached_bboxes;
+    std::vector<Eigen::Index> uncached_indices;
+    FeatureMatrix embeddings(static_cast<Eigen::Index>(bboxes.size()), _reid_model->feature_dim());
+    for (size_t i = 0; i < bboxes.size(); i++) {
+        if (cached_tracks[i]) {
+            embeddings.row(static_cast<Eigen::Index>(i)) = *cached_tracks[i]->curr_feat;
+            feat_frame_ids[i] = cached_tracks[i]->feat_frame_id;
+        } else {
+            uncached_bboxes.push_back(bboxes[i]);
+            uncached_indices.push_back(static_cast<Eigen::Index>(i));
+        }
+    }
+
+    if (!uncached_bboxes.empty()) {
+        FeatureMatrix extracted = _reid_model->extract_features(frame, uncached_bboxes);
+        for (size_t k = 0; k < uncached_indices.size(); k++) {
+            embeddings.row(uncached_indices[k]) = extracted.row(static_cast<Eigen::Index>(k));
+        }
+    }
+
+    return embeddings;
+}
+
+EmbeddingCache::Stats BoTSORT::embedding_cache_stats() const {
+    return _embedding_cache ? _embedding_cache->stats() : EmbeddingCache::Stats();
+}
+
+const TrackerStats &BoTSORT::stats() const {
+    return _stats;
+}
+
+void BoTSORT::reset_stats() {
+    _stats.reset();
+}
+
+void BoTSORT::set_stream_id(int stream_id) {
+    _stream_id = stream_id;
+}
+
+namespace {
+constexpr uint32_t SNAPSHOT_MAGIC = 0x534E5342;// "BSNS"
+constexpr uint32_t SNAPSHOT_VERSION = 1;
+}// namespace
+
+void BoTSORT::save_state(std::string &snapshot) const {
+    snapshot.clear();
+    SnapshotWriter writer(snapshot);
+
+    // Setup of the tracker, checked on restore
+    writer.write(SNAPSHOT_MAGIC);
+    writer.write(SNAPSHOT_VERSION);
+    writer.write(static_cast<uint8_t>(_reid_enabled));
+    writer.write(static_cast<int32_t>(_appearance_store ? _appearance_store->feature_dim() : 0));
+    writer.write(static_cast<int32_t>(_appearance_store ? _appearance_store->precision() : 0));
+    writer.write(static_cast<uint8_t>(_gallery != nullptr));
+    writer.write(static_cast<int32_t>(_gmc_method));
+
+    writer.write(static_cast<uint32_t>(_frame_id));
+    writer.write(static_cast<int32_t>(_last_track_id));
+
+    for (const std::vector<std::shared_ptr<Track>> *tracks: {&_tracked_tracks, &_lost_tracks}) {
+        writer.write(static_cast<uint64_t>(tracks->size()));
+        for (const std::shared_ptr<Track> &track: *tracks) {
+            track->save_state(writer);
+        }
+    }
+
+    if (_gallery) {
+        _gallery->save_state(writer);
+    }
+    _gmc_algo->save_state(writer);
+}
+
+void BoTSORT::load_state(std::string_view snapshot) {
+    SnapshotReader reader(snapshot);
+
+    if (reader.read<uint32_t>() != SNAPSHOT_MAGIC || reader.read<uint32_t>() != SNAPSHOT_VERSION) {
+        throw std::runtime_error("Not a tracker snapshot, or written by an incompatible version");
+    }
+    bool reid_enabled = reader.read<uint8_t>() != 0;
+    int feature_dim = reader.read<int32_t>();
+    int precision = reader.read<int32_t>();
+    bool gallery_enabled = reader.read<uint8_t>() != 0;
+    int gmc_method = reader.read<int32_t>();
+    if (reid_enabled != _reid_enabled ||
+        feature_dim != (_appearance_store ? _appearance_store->feature_dim() : 0) ||
+        precision != (_appearance_store ? _appearance_store->precision() : 0) ||
+        gallery_enabled != (_gallery != nullptr) ||
+        gmc_method != _gmc_method) {
+        throw std::runtime_error("Tracker snapshot written with a different Re-ID, gallery or GMC setup");
+    }
+
+    unsigned int frame_id = reader.read<uint32_t>();
+    int last_track_id = reader.read<int32_t>();
+
+    std::vector<std::shared_ptr<Track>> tracked_tracks, lost_tracks;
+    for (std::vector<std::shared_ptr<Track>> *tracks: {&tracked_tracks, &lost_tracks}) {
+        auto num_tracks = reader.read<uint64_t>();
+        for (uint64_t i = 0; i < num_tracks; i++) {
+            tracks->push_back(Track::load_state(reader, _appearance_store));
+        }
+    }
+
+    if (_gallery) {
+        _gallery->load_state(reader);
+    }
+    _gmc_algo->load_state(reader);
+    if (!reader.at_end()) {
+        throw std::runtime_error("Malformed tracker snapshot: unexpected trailing data");
+    }
+
+    // Features in flight belong to the replaced tracks
+    _pending_features.clear();
+    _frame_id = frame_id;
+    _last_track_id = last_track_id;
+    _tracked_tracks = std::move(tracked_tracks);
+    _lost_tracks = std::move(lost_tracks);
+}
+
+void BoTSORT::record_inputs(const std::string &log_path) {
+    if (_reid_async) {
+        throw std::runtime_error("Recording the inputs is not supported with asynchronous Re-ID");
+    }
+    _input_log = std::make_unique<InputLogWriter>(log_path, _reid_enabled ? _reid_model->feature_dim() : 0);
+}
+
+void BoTSORT::stop_recording() {
+    _input_log.reset();
+}
+
+int BoTSORT::_next_track_id() {
+    return ++_last_track_id;
+}
+
+void BoTSORT::_apply_pending_features() {
+    std::vector<std::shared_ptr<Track>> new_tracks;
+
+    while (!_pending_features.empty() &&
+           _pending_features.front().features.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        PendingFeatures pending_features = std::move(_pending_features.front());
+        _pending_features.pop_front();
+
+        FeatureMatrix features = pending_features.features.get();
+        for (size_t i = 0; i < pending_features.tracks.size(); i++) {
+            std::shared_ptr<Track> track = pending_features.tracks[i].lock();
+            if (!track || track->state == TrackState::Removed) {
+                continue;
+            }
+
+            track->update_features(features.row(static_cast<Eigen::Index>(i)));
+            if (pending_features.new_tracks[i]) {
+                new_tracks.push_back(track);
+            }
+        }
+    }
+
+    if (!new_tracks.empty()) {
+        _reactivate_lost_tracks(new_tracks);
+    }
+}
+
+void BoTSORT::_reactivate_lost_tracks(const std::vector<std::shared_ptr<Track>> &new_tracks) {
+    // Only the new tracks whose ID has not been output yet can be merged, a confirmed track keeps its ID
+    std::vector<std::shared_ptr<Track>> candidate_tracks, lost_tracks;
+    for (const std::shared_ptr<Track> &track: new_tracks) {
+        if (track->state == TrackState::Tracked && !track->is_activated) {
+            candidate_tracks.push_back(track);
+        }
+    }
+    for (const std::shared_ptr<Track> &track: _lost_tracks) {
+        if (track->smooth_feat || track->smooth_feat_slot() != AppearanceStore::INVALID_SLOT) {
+            lost_tracks.push_back(track);
+        }
+    }
+
+    std::vector<std::shared_ptr<Track>> reactivated_tracks, merged_tracks;
+    if (!candidate_tracks.empty() && !lost_tracks.empty()) {
+        CostMatrix emb_dists, emb_dists_mask;
+        std::tie(emb_dists, emb_dists_mask) = embedding_distance(lost_tracks,
+                                                                 candidate_tracks,
+                                                                 _appearance_thresh,
+                                                                 _embedding_distance_kernel,
+                                                                 _appearance_metric);
+
+        // Motion is only used as a gate, pairs outside the gating region are rejected
+        CostMatrix motion_gated_dists = emb_dists;
+        fuse_motion(*_kalman_filter, motion_gated_dists, lost_tracks, candidate_tracks, _lambda);
+        for (Eigen::Index i = 0; i < emb_dists.rows(); i++) {
+            for (Eigen::Index j = 0; j < emb_dists.cols(); j++) {
+                if (emb_dists_mask(i, j) > 0 || !std::isfinite(motion_gated_dists(i, j))) {
+                    emb_dists(i, j) = 1.0F;
+                }
+            }
+        }
+
+        AssociationData reactivations = linear_assignment(emb_dists, _appearance_thresh);
+        for (const std::pair<int, int> &match: reactivations.matches) {
+            const std::shared_ptr<Track> &track = lost_tracks[match.first];
+            const std::shared_ptr<Track> &new_track = candidate_tracks[match.second];
+
+            track->re_activate(*_kalman_filter, *new_track, new_track->frame_id);
+            new_track->mark_removed();
+            reactivated_tracks.push_back(track);
+            merged_tracks.push_back(new_track);
+        }
+
+        _tracked_tracks = _remove_from_list(_tracked_tracks, merged_tracks);
+        _lost_tracks = _remove_from_list(_lost_tracks, reactivated_tracks);
+        _tracked_tracks = _merge_track_lists(_tracked_tracks, reactivated_tracks);
+    }
+
+    // The new tracks left can still take the ID of a gallery entry
+    if (_gallery) {
+        std::vector<std::shared_ptr<Track>> unconfirmed_tracks;
+        for (const std::shared_ptr<Track> &track: candidate_tracks) {
+            if (track->state == TrackState::Tracked) {
+                unconfirmed_tracks.push_back(track);
+            }
+        }
+        if (unconfirmed_tracks.empty()) {
+            return;
+        }
+
+        _gallery->expire(_frame_id);
+        FeatureMatrix features(static_cast<Eigen::Index>(unconfirmed_tracks.size()), _reid_model->feature_dim());
+        for (size_t i = 0; i < unconfirmed_tracks.size(); i++) {
+            features.row(static_cast<Eigen::Index>(i)) = *unconfirmed_tracks[i]->smooth_feat;
+        }
+
+        std::vector<std::optional<int>> recovered_track_ids = _gallery->reidentify(features, _gallery_match_thresh);
+        for (size_t i = 0; i < unconfirmed_tracks.size(); i++) {
+            if (recovered_track_ids[i]) {
+                unconfirmed_tracks[i]->track_id = recovered_track_ids[i].value();
+            }
+        }
+    }
 }
 
 std::vector<std::shared_ptr<Track>> BoTSORT::_merge_track_lists(std::vector<std::shared_ptr<Track>> &tracks_list_a, std::vector<std::shared_ptr<Track>> &tracks_list_b) {
@@ -386,17 +888,16 @@ void BoTSORT::_remove_duplicate_tracks(
 }
 
 
-void BoTSORT::_load_params_from_config(const std::string &config_dir) {
+void BoTSORT::_load_params_from_config(const INIReader &tracker_config) {
     const std::string tracker_name = "BoTSORT";
 
-    INIReader tracker_config(config_dir + "/tracker.ini");
-    if (tracker_config.ParseError() < 0) {
-        std::cout << "Can't load " << config_dir << "/tracker.ini" << std::endl;
-        exit(1);
-    }
-
     _reid_model_weights_path = tracker_config.Get(tracker_name, "model_path");
+    _reid_method_name = tracker_config.Get(tracker_name, "reid_method", "cnn");
+    _reid_feature_dim = static_cast<int>(tracker_config.GetInteger(tracker_name, "feature_dim", FEATURE_DIM));
     _fp16_inference = tracker_config.GetBoolean(tracker_name, "fp16_inference", false);
+    _reid_async = tracker_config.GetBoolean(tracker_name, "reid_async", false);
+    _feature_storage_name = tracker_config.Get(tracker_name, "feature_storage", "fp16");
+    _appearance_metric_name = tracker_config.Get(tracker_name, "appearance_metric", "smooth");
 
     _track_high_thresh = tracker_config.GetFloat(tracker_name, "track_high_thresh", 0.6F);
     _track_low_thresh = tracker_config.GetFloat(tracker_name, "track_low_thresh", 0.1F);
@@ -412,4 +913,23 @@ void BoTSORT::_load_params_from_config(const std::string &config_dir) {
 
     _frame_rate = tracker_config.GetInteger(tracker_name, "frame_rate", 30);
     _lambda = tracker_config.GetFloat(tracker_name, "lambda", 0.985F);
+
+    const std::string gallery_name = "ReIDGallery";
+    _gallery_enabled = tracker_config.GetBoolean(tracker_name, "reid_gallery", false);
+    const long gallery_capacity = tracker_config.GetInteger(gallery_name, "capacity", 10000);
+    if (gallery_capacity < 1) {
+        throw std::runtime_error("Invalid ReIDGallery capacity: " + std::to_string(gallery_capacity) + ", expected at least 1");
+    }
+    _gallery_capacity = static_cast<size_t>(gallery_capacity);
+    _gallery_ttl = tracker_config.GetFloat(gallery_name, "ttl", 600.0F);
+    _gallery_match_thresh = tracker_config.GetFloat(gallery_name, "match_thresh", 0.2F);
+    _gallery_num_lists = tracker_config.GetInteger(gallery_name, "num_lists", 64);
+    _gallery_num_probes = tracker_config.GetInteger(gallery_name, "num_probes", 8);
+
+    const std::string embedding_cache_name = "EmbeddingCache";
+    _embedding_cache_enabled = tracker_config.GetBoolean(tracker_name, "embedding_cache", false);
+    _embedding_cache_iou_thresh = tracker_config.GetFloat(embedding_cache_name, "iou_thresh", 0.9F);
+    _embedding_cache_max_age = tracker_config.GetInteger(embedding_cache_name, "max_age", 5);
+    _embedding_cache_max_size_change = tracker_config.GetFloat(embedding_cache_name, "max_size_change", 0.05F);
+    _embedding_cache_occlusion_thresh = tracker_config.GetFloat(embedding_cache_name, "occlusion_thresh", 0.1F);
 }
\ No newline at end of file
@@ -0,0 +1,226 @@
+#include "DetectionLoader.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <filesystem>
+#include <numeric>
+#include <stdexcept>
+
+std::map<std::string, DetectionFormat> DetectionLoader::format_map = {
+        {"mot", DetectionFormat::MOT},
+        {"yolo", DetectionFormat::YOLO},
+};
+
+
+namespace {
+inline bool is_separator(char c) {
+    return c == ',' || c == ' ' || c == '\t' || c == '\r';
+}
+
+/**
+ * @brief Parse the numbers of one line, separated by commas and/or whitespace
+ *
+ * @param p Start of the line
+ * @param end End of the buffer
+ * @param values Output values, at most max_values are stored (the remaining numbers of the line are skipped)
+ * @param max_values Capacity of values
+ * @param num_values Number of values parsed, 0 if the line is malformed
+ * @return const char* Start of the next line
+ */
+const char *parse_line(const char *p, const char *end, float *values, int max_values, int &num_values) {
+    num_values = 0;
+    bool malformed = false;
+
+    while (p < end && *p != '\n') {
+        if (is_separator(*p)) {
+            p++;
+            continue;
+        }
+
+        if (num_values < max_values && !malformed) {
+            auto [next, ec] = std::from_chars(p, end, values[num_values]);
+            if (ec == std::errc() && (next == end || is_separator(*next) || *next == '\n')) {
+                num_values++;
+                p = next;
+                continue;
+            }
+            malformed = true;
+        }
+
+        while (p < end && !is_separator(*p) && *p != '\n') {
+            p++;
+        }
+    }
+
+    if (malformed) {
+        num_values = 0;
+    }
+    return p < end ? p + 1 : end;
+}
+}// namespace
+
+
+DetectionLoader::DetectionLoader(DetectionFormat format,
+                                 const std::string &path,
+                                 int frame_width,
+                                 int frame_height,
+                                 std::optional<int> class_id) {
+    switch (format) {
+        case DetectionFormat::MOT:
+            _load_mot(path);
+            break;
+        case DetectionFormat::YOLO:
+            _load_yolo(path, frame_width, frame_height, class_id);
+            break;
+        default:
+            throw std::runtime_error("Unknown detection format: " + std::to_string(format));
+    }
+}
+
+DetectionSpan DetectionLoader::frame(size_t frame_index) const {
+    if (frame_index >= num_frames()) {
+        return {};
+    }
+    return {_detections.data() + _frame_offsets[frame_index],
+            _frame_offsets[frame_index + 1] - _frame_offsets[frame_index]};
+}
+
+std::optional<size_t> DetectionLoader::frame_index(const std::string &name) const {
+    auto it = std::lower_bound(_frame_names.begin(), _frame_names.end(), name);
+    if (it == _frame_names.end() || *it != name) {
+        return std::nullopt;
+    }
+    return static_cast<size_t>(it - _frame_names.begin());
+}
+
+size_t DetectionLoader::num_frames() const {
+    return _frame_offsets.empty() ? 0 : _frame_offsets.size() - 1;
+}
+
+size_t DetectionLoader::num_detections() const {
+    return _detections.size();
+}
+
+size_t DetectionLoader::bytes_parsed() const {
+    return _bytes_parsed;
+}
+
+uint32_t DetectionLoader::mot_frame_id(float value, const std::string &path, size_t line_number) {
+    // Also rejects NaN, a bad line must not size the frame index
+    if (!(value >= 1.0F && value <= static_cast<float>(MAX_FRAME_ID)) || std::floor(value) != value) {
+        throw std::runtime_error("Invalid frame-id " + std::to_string(value) + " in " + path + " line " + std::to_string(line_number) +
+                                 ", expected an integer in [1, " + std::to_string(MAX_FRAME_ID) + "]");
+    }
+    return static_cast<uint32_t>(value);
+}
+
+void DetectionLoader::_load_mot(const std::string &filepath) {
+    // BB format is: frame_no,object_id,bb_left,bb_top,bb_width,bb_height,score,X,Y,Z
+    MappedFile file(filepath);
+    std::string_view text = file.view();
+    _bytes_parsed = text.size();
+
+    // Rough estimate of the number of lines, to parse without reallocations
+    _detections.reserve(text.size() / 24);
+    std::vector<uint32_t> frame_ids;
+    frame_ids.reserve(text.size() / 24);
+
+    constexpr int max_values = 7;
+    float values[max_values];
+    int num_values = 0;
+    bool sorted = true;
+
+    const char *p = text.data(), *end = text.data() + text.size();
+    size_t line_number = 0;
+    while (p < end) {
+        p = parse_line(p, end, values, max_values, num_values);
+        line_number++;
+        if (num_values < 6) {
+            continue;
+        }
+
+        Detection det;
+        det.class_id = 0;// class_id is not provided in MOTChallenge format, so set it to 0 to indicate person
+        det.bbox_tlwh = cv::Rect_<float>(values[2], values[3], values[4], values[5]);
+        det.confidence = (num_values < 7 || values[6] == 0) ? 1.0F : values[6];
+
+        uint32_t frame_id = mot_frame_id(values[0], filepath, line_number);
+        sorted = sorted && (frame_ids.empty() || frame_ids.back() <= frame_id);
+        frame_ids.push_back(frame_id);
+        _detections.push_back(det);
+    }
+
+    // Files are normally sorted by frame already, otherwise group the detections by frame keeping the file order
+    if (!sorted) {
+        std::vector<size_t> order(_detections.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&frame_ids](size_t a, size_t b) { return frame_ids[a] < frame_ids[b]; });
+
+        std::vector<Detection> sorted_detections(_detections.size());
+        std::vector<uint32_t> sorted_frame_ids(frame_ids.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            sorted_detections[i] = _detections[order[i]];
+            sorted_frame_ids[i] = frame_ids[order[i]];
+        }
+        _detections = std::move(sorted_detections);
+        frame_ids = std::move(sorted_frame_ids);
+    }
+
+    // Frame-ids start at 1, frames without detections get an empty range
+    const uint32_t num_frames = frame_ids.empty() ? 0 : frame_ids.back();
+    _frame_offsets.assign(num_frames + 1, 0);
+    size_t i = 0;
+    for (uint32_t frame = 1; frame <= num_frames; frame++) {
+        while (i < frame_ids.size() && frame_ids[i] == frame) {
+            i++;
+        }
+        _frame_offsets[frame] = i;
+    }
+}
+
+void DetectionLoader::_load_yolo(const std::string &dirpath, int frame_width, int frame_height, std::optional<int> class_id) {
+    std::vector<std::filesystem::path> label_files;
+    for (const auto &entry: std::filesystem::directory_iterator(dirpath)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".txt") {
+            label_files.push_back(entry.path());
+        }
+    }
+    std::sort(label_files.begin(), label_files.end());
+
+    _frame_offsets.reserve(label_files.size() + 1);
+    _frame_offsets.push_back(0);
+    _frame_names.reserve(label_files.size());
+
+    constexpr int max_values = 6;
+    float values[max_values];
+    int num_values = 0;
+
+    for (const std::filesystem::path &label_file: label_files) {
+        MappedFile file(label_file.string());
+        std::string_view text = file.view();
+        _bytes_parsed += text.size();
+
+        const char *p = text.data(), *end = text.data() + text.size();
+        while (p < end) {
+            p = parse_line(p, end, values, max_values, num_values);
+            if (num_values < 5 || (class_id && static_cast<int>(values[0]) != class_id.value())) {
+                continue;
+            }
+
+            // Bounding box is normalized (center x, center y, width, height), so convert to absolute coordinates
+            Detection det;
+            det.class_id = static_cast<int>(values[0]);
+            det.bbox_tlwh = cv::Rect_<float>((values[1] - values[3] / 2) * frame_width,
+                                             (values[2] - values[4] / 2) * frame_height,
+                                             values[3] * frame_width,
+                                             values[4] * frame_height);
+            det.confidence = num_values < 6 ? 1.0F : values[5];
+            _detections.push_back(det);
+        }
+
+        _frame_offsets.push_back(_detections.size());
+        _frame_names.push_back(label_file.stem().string());
+    }
+}
@@ -0,0 +1,117 @@
+#include "EmbeddingCache.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+
+double EmbeddingCache::Stats::hit_rate() const {
+    return lookups > 0 ? static_cast<double>(hits) / static_cast<double>(lookups) : 0.0;
+}
+
+
+EmbeddingCache::EmbeddingCache(float iou_thresh, uint32_t max_age, float max_size_change, float occlusion_thresh)
+    : _iou_thresh(iou_thresh),
+      _max_size_change(max_size_change),
+      _occlusion_thresh(occlusion_thresh),
+      _max_age(max_age) {
+}
+
+std::vector<std::shared_ptr<Track>> EmbeddingCache::lookup(const std::vector<cv::Rect_<float>> &bboxes,
+                                                           const std::vector<std::shared_ptr<Track>> &tracks,
+                                                           uint32_t frame_id) {
+    std::vector<std::shared_ptr<Track>> cached_tracks(bboxes.size());
+
+    // Only tracks associated on the previous frame, with an embedding extracted by the model recently
+    std::vector<std::shared_ptr<Track>> candidate_tracks;
+    for (const std::shared_ptr<Track> &track: tracks) {
+        if (track->state == TrackState::Tracked && track->curr_feat &&
+            track->frame_id + 1 == frame_id && frame_id - track->feat_frame_id <= _max_age) {
+            candidate_tracks.push_back(track);
+        }
+    }
+
+    std::vector<bool> occluded = _find_occluded(bboxes);
+    std::vector<bool> used(candidate_tracks.size(), false);
+    size_t hits = 0;
+
+    for (size_t i = 0; i < bboxes.size() && !candidate_tracks.empty(); i++) {
+        if (occluded[i]) {
+            continue;
+        }
+
+        const cv::Rect_<float> &bbox = bboxes[i];
+        const std::vector<float> tlwh = {bbox.x, bbox.y, bbox.width, bbox.height};
+
+        int best_track = -1;
+        float best_iou = _iou_thresh;
+        for (size_t j = 0; j < candidate_tracks.size(); j++) {
+            const std::vector<float> &track_tlwh = candidate_tracks[j]->det_tlwh;
+            if (used[j] ||
+                std::abs(bbox.width - track_tlwh[2]) > _max_size_change * track_tlwh[2] ||
+                std::abs(bbox.height - track_tlwh[3]) > _max_size_change * track_tlwh[3]) {
+                continue;
+            }
+
+            float overlap = iou(tlwh, track_tlwh);
+            if (overlap > best_iou) {
+                best_iou = overlap;
+                best_track = static_cast<int>(j);
+            }
+        }
+
+        if (best_track >= 0) {
+            used[best_track] = true;
+            cached_tracks[i] = candidate_tracks[best_track];
+            hits++;
+        }
+    }
+
+    _stats.lookups += bboxes.size();
+    _stats.hits += hits;
+    if (!bboxes.empty() && hits == bboxes.size()) {
+        _stats.skipped_batches++;
+    }
+
+    return cached_tracks;
+}
+
+const EmbeddingCache::Stats &EmbeddingCache::stats() const {
+    return _stats;
+}
+
+void EmbeddingCache::reset_stats() {
+    _stats = Stats();
+}
+
+std::vector<bool> EmbeddingCache::_find_occluded(const std::vector<cv::Rect_<float>> &bboxes) const {
+    std::vector<bool> occluded(bboxes.size(), false);
+
+    // Sweep over the boxes sorted by their left edge, only horizontally overlapping pairs are compared
+    std::vector<size_t> order(bboxes.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&bboxes](size_t a, size_t b) { return bboxes[a].x < bboxes[b].x; });
+
+    for (size_t k = 0; k < order.size(); k++) {
+        const cv::Rect_<float> &a = bboxes[order[k]];
+        for (size_t l = k + 1; l < order.size() && bboxes[order[l]].x < a.x + a.width; l++) {
+            const cv::Rect_<float> &b = bboxes[order[l]];
+            float intersection_width = std::min(a.x + a.width, b.x + b.width) - b.x;
+            float intersection_height = std::min(a.y + a.height, b.y + b.height) - std::max(a.y, b.y);
+            if (intersection_height <= 0.0F) {
+                continue;
+            }
+
+            float intersection = intersection_width * intersection_height;
+            if (intersection > _occlusion_thresh * a.area()) {
+                occluded[order[k]] = true;
+            }
+            if (intersection > _occlusion_thresh * b.area()) {
+                occluded[order[l]] = true;
+            }
+        }
+    }
+
+    return occluded;
+}
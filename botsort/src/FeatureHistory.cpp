@@ -0,0 +1,80 @@
+#include "FeatureHistory.h"
+
+#include <stdexcept>
+
+std::map<std::string, AppearanceMetric> FeatureHistory::metric_map = {
+        {"smooth", AppearanceMetric::Smooth},
+        {"min", AppearanceMetric::HistoryMin},
+        {"mean", AppearanceMetric::HistoryMean},
+};
+
+
+FeatureHistory::FeatureHistory(int feature_dim, FeaturePrecision precision, size_t capacity)
+    : _features(feature_dim, precision, 1),
+      _capacity(capacity) {}
+
+void FeatureHistory::push(const FeatureVector &feature) {
+    if (_capacity == 0) {
+        return;
+    }
+
+    // Slots are allocated in order and never released, so slot i is the i-th feature of the block
+    if (_size < _capacity) {
+        AppearanceStore::Slot slot = _features.allocate();
+        _features.store(slot, feature);
+        _size++;
+    } else {
+        _features.store(static_cast<AppearanceStore::Slot>(_oldest), feature);
+        _oldest = (_oldest + 1) % _capacity;
+    }
+}
+
+Eigen::RowVectorXf FeatureHistory::min_distance(const Eigen::Ref<const FeatureMatrix> &queries) const {
+    if (_size == 0) {
+        return Eigen::RowVectorXf::Ones(queries.rows());
+    }
+
+    CostMatrix similarity = _features.dot(0, _size, queries);
+    return (1.0F - similarity.colwise().maxCoeff().array()).max(0.0F);
+}
+
+Eigen::RowVectorXf FeatureHistory::mean_distance(const Eigen::Ref<const FeatureMatrix> &queries) const {
+    if (_size == 0) {
+        return Eigen::RowVectorXf::Ones(queries.rows());
+    }
+
+    CostMatrix similarity = _features.dot(0, _size, queries);
+    return (1.0F - similarity.colwise().mean().array()).max(0.0F);
+}
+
+void FeatureHistory::save_state(SnapshotWriter &writer) const {
+    writer.write(static_cast<uint64_t>(_size));
+    for (size_t i = 0; i < _size; i++) {
+        _features.save_slot(static_cast<AppearanceStore::Slot>((_oldest + i) % _size), writer);
+    }
+}
+
+void FeatureHistory::load_state(SnapshotReader &reader) {
+    auto size = reader.read<uint64_t>();
+    if (size > _capacity) {
+        throw std::runtime_error("Malformed tracker snapshot: feature history larger than its capacity");
+    }
+
+    // Restored oldest first, so the ring starts at slot 0. Slots allocated by a longer history are kept for reuse
+    while (_features.size() < size) {
+        _features.allocate();
+    }
+    for (uint64_t i = 0; i < size; i++) {
+        _features.load_slot(static_cast<AppearanceStore::Slot>(i), reader);
+    }
+    _size = size;
+    _oldest = 0;
+}
+
+size_t FeatureHistory::size() const {
+    return _size;
+}
+
+size_t FeatureHistory::capacity() const {
+    return _capacity;
+}
@@ -1,59 +1,107 @@
 #include "GlobalMotionCompensation.h"
 #include "INIReader.h"
+#include "Tracing.h"
 #include <opencv2/videostab/global_motion.hpp>
 #include <opencv2/videostab/motion_core.hpp>
 
+namespace {
+template<typename Point>
+void write_points(SnapshotWriter &writer, const std::vector<Point> &points) {
+    writer.write(static_cast<uint64_t>(points.size()));
+    for (const Point &point: points) {
+        writer.write(point.x);
+        writer.write(point.y);
+    }
+}
+
+template<typename Point>
+void read_points(SnapshotReader &reader, std::vector<Point> &points) {
+    points.resize(reader.read_count(2 * sizeof(float)));
+    for (Point &point: points) {
+        point.x = reader.read<float>();
+        point.y = reader.read<float>();
+    }
+}
+}// namespace
+
+
 std::map<std::string, GMC_Method> GlobalMotionCompensation::GMC_method_map = {
         {"orb", GMC_Method::ORB},
         {"ecc", GMC_Method::ECC},
         {"sparseOptFlow", GMC_Method::SparseOptFlow},
         {"optFlowModified", GMC_Method::OptFlowModified},
         {"OpenCV_VideoStab", GMC_Method::OpenCV_VideoStab},
+        {"none", GMC_Method::NoGMC},
 };
 
+std::map<GMC_Method, std::string> GlobalMotionCompensation::GMC_section_map = {
+        {GMC_Method::ORB, "orb"},
+        {GMC_Method::ECC, "ecc"},
+        {GMC_Method::SparseOptFlow, "sparseOptFlow"},
+        {GMC_Method::OptFlowModified, "OptFlowModified"},
+        {GMC_Method::OpenCV_VideoStab, "OpenCV_VideoStab"},
+};
+
+
+GlobalMotionCompensation::GlobalMotionCompensation(GMC_Method method, const std::string &config_dir)
+    : GlobalMotionCompensation(method, _load_config(method, config_dir)) {}
 
-GlobalMotionCompensation::GlobalMotionCompensation(GMC_Method method, const std::string &config_dir) {
+GlobalMotionCompensation::GlobalMotionCompensation(GMC_Method method, const INIReader &gmc_config) {
     if (method == GMC_Method::ORB) {
         std::cout << "Using ORB for GMC" << std::endl;
-        _gmc_algorithm = std::make_unique<ORB_GMC>(config_dir);
+        _gmc_algorithm = std::make_unique<ORB_GMC>(gmc_config);
     } else if (method == GMC_Method::ECC) {
         std::cout << "Using ECC for GMC" << std::endl;
-        _gmc_algorithm = std::make_unique<ECC_GMC>(config_dir);
+        _gmc_algorithm = std::make_unique<ECC_GMC>(gmc_config);
     } else if (method == GMC_Method::SparseOptFlow) {
         std::cout << "Using SparseOptFlow for GMC" << std::endl;
-        _gmc_algorithm = std::make_unique<SparseOptFlow_GMC>(config_dir);
+        _gmc_algorithm = std::make_unique<SparseOptFlow_GMC>(gmc_config);
     } else if (method == GMC_Method::OptFlowModified) {
         std::cout << "Using OptFlowModified for GMC" << std::endl;
-        _gmc_algorithm = std::make_unique<OptFlowModified_GMC>(config_dir);
+        _gmc_algorithm = std::make_unique<OptFlowModified_GMC>(gmc_config);
     } else if (method == GMC_Method::OpenCV_VideoStab) {
         std::cout << "Using OpenCV_VideoStab for GMC" << std::endl;
-        _gmc_algorithm = std::make_unique<OpenCV_VideoStab_GMC>(config_dir);
+        _gmc_algorithm = std::make_unique<OpenCV_VideoStab_GMC>(gmc_config);
+    } else if (method == GMC_Method::NoGMC) {
+        std::cout << "Global motion compensation disabled" << std::endl;
+        _gmc_algorithm = std::make_unique<None_GMC>();
     } else {
         throw std::runtime_error("Unknown global motion compensation method: " + std::to_string(method));
     }
 }
 
+INIReader GlobalMotionCompensation::_load_config(GMC_Method method, const std::string &config_dir) {
+    INIReader gmc_config(config_dir + "/gmc.ini");
+    if (method != GMC_Method::NoGMC && gmc_config.ParseError() < 0) {
+        std::cout << "Can't load " << config_dir << "/gmc.ini" << std::endl;
+        exit(1);
+    }
+    return gmc_config;
+}
+
 HomographyMatrix GlobalMotionCompensation::apply(const cv::Mat &frame, const std::vector<Detection> &detections) {
     return _gmc_algorithm->apply(frame, detections);
 }
 
+void GlobalMotionCompensation::save_state(SnapshotWriter &writer) const {
+    _gmc_algorithm->save_state(writer);
+}
+
+void GlobalMotionCompensation::load_state(SnapshotReader &reader) {
+    _gmc_algorithm->load_state(reader);
+}
+
 
 // ORB
-ORB_GMC::ORB_GMC(const std::string &config_dir) {
-    _load_params_from_config(config_dir);
+ORB_GMC::ORB_GMC(const INIReader &gmc_config) {
+    _load_params_from_config(gmc_config);
 
     _detector = cv::FastFeatureDetector::create();
     _extractor = cv::ORB::create();
     _matcher = cv::BFMatcher::create(cv::NORM_HAMMING);// Brute Force Matcher
 }
 
-void ORB_GMC::_load_params_from_config(const std::string &config_dir) {
-    INIReader gmc_config(config_dir + "/gmc.ini");
-    if (gmc_config.ParseError() < 0) {
-        std::cout << "Can't load " << config_dir << "/gmc.ini" << std::endl;
-        exit(1);
-    }
-
+void ORB_GMC::_load_params_from_config(const INIReader &gmc_config) {
     _downscale = gmc_config.GetFloat(_algo_name, "downscale", 2.0);
     _inlier_ratio = gmc_config.GetFloat(_algo_name, "inlier_ratio", 0.5);
     _ransac_conf = gmc_config.GetFloat(_algo_name, "ransac_conf", 0.99);
@@ -62,6 +110,7 @@ void ORB_GMC::_load_params_from_config(const std::string &config_dir) {
 
 HomographyMatrix ORB_GMC::apply(const cv::Mat &frame_raw, const std::vector<Detection> &detections) {
     // Initialization
+    tracing::Laps trace("gmc");
     int height = frame_raw.rows;
     int width = frame_raw.cols;
 
@@ -98,14 +147,19 @@ HomographyMatrix ORB_GMC::apply(const cv::Mat &frame_raw, const std::vector<Dete
     }
 
 
+    trace.lap("orb.preprocess");
+
+
     // Detect keypoints in background
     std::vector<cv::KeyPoint> keypoints;
     _detector->detect(frame, keypoints, mask);
+    trace.lap("orb.detect");
 
 
     // Extract descriptors for the detected keypoints
     cv::Mat descriptors;
     _extractor->compute(frame, keypoints, descriptors);
+    trace.lap("orb.describe");
 
     if (!_first_frame_initialized) {
         /**
@@ -123,6 +177,7 @@ HomographyMatrix ORB_GMC::apply(const cv::Mat &frame_raw, const std::vector<Dete
     // Match descriptors between the current frame and the previous frame
     std::vector<std::vector<cv::DMatch>> knn_matches;
     _matcher->knnMatch(_prev_descriptors, descriptors, knn_matches, 2);
+    trace.lap("orb.match");
 
 
     // Filter matches on the basis of spatial distance
@@ -174,6 +229,9 @@ HomographyMatrix ORB_GMC::apply(const cv::Mat &frame_raw, const std::vector<Dete
     }
 
 
+    trace.lap("orb.filter_matches");
+
+
     // Find the rigid transformation between the previous and current frame on the basis of the good matches
     if (prev_points.size() > 4) {
         cv::Mat inliers;
@@ -190,6 +248,7 @@ HomographyMatrix ORB_GMC::apply(const cv::Mat &frame_raw, const std::vector<Dete
             std::cout << "Warning: Could not estimate affine matrix" << std::endl;
         }
     }
+    trace.lap("orb.estimate");
 
 #ifdef DEBUG
     cv::Mat matches_img;
@@ -224,21 +283,49 @@ HomographyMatrix ORB_GMC::apply(const cv::Mat &frame_raw, const std::vector<Dete
     return H;
 }
 
+void ORB_GMC::save_state(SnapshotWriter &writer) const {
+    writer.write(static_cast<uint8_t>(_first_frame_initialized));
+    writer.write_mat(_prev_frame);
+    writer.write_mat(_prev_descriptors);
+
+    writer.write(static_cast<uint64_t>(_prev_keypoints.size()));
+    for (const cv::KeyPoint &keypoint: _prev_keypoints) {
+        writer.write(keypoint.pt.x);
+        writer.write(keypoint.pt.y);
+        writer.write(keypoint.size);
+        writer.write(keypoint.angle);
+        writer.write(keypoint.response);
+        writer.write(static_cast<int32_t>(keypoint.octave));
+        writer.write(static_cast<int32_t>(keypoint.class_id));
+    }
+}
+
+void ORB_GMC::load_state(SnapshotReader &reader) {
+    _first_frame_initialized = reader.read<uint8_t>() != 0;
+    reader.read_mat(_prev_frame);
+    reader.read_mat(_prev_descriptors);
+
+    _prev_keypoints.resize(reader.read_count(5 * sizeof(float) + 2 * sizeof(int32_t)));
+    for (cv::KeyPoint &keypoint: _prev_keypoints) {
+        keypoint.pt.x = reader.read<float>();
+        keypoint.pt.y = reader.read<float>();
+        keypoint.size = reader.read<float>();
+        keypoint.angle = reader.read<float>();
+        keypoint.response = reader.read<float>();
+        keypoint.octave = reader.read<int32_t>();
+        keypoint.class_id = reader.read<int32_t>();
+    }
+}
+
 
 // ECC
-ECC_GMC::ECC_GMC(const std::string &config_dir) {
-    _load_params_from_config(config_dir);
+ECC_GMC::ECC_GMC(const INIReader &gmc_config) {
+    _load_params_from_config(gmc_config);
 
     _termination_criteria = cv::TermCriteria(cv::TermCriteria::EPS | cv::TermCriteria::COUNT, _max_iterations, _termination_eps);
 }
 
-void ECC_GMC::_load_params_from_config(const std::string &config_dir) {
-    INIReader gmc_config(config_dir + "/gmc.ini");
-    if (gmc_config.ParseError() < 0) {
-        std::cout << "Can't load " << config_dir << "/gmc.ini" << std::endl;
-        exit(1);
-    }
-
+void ECC_GMC::_load_params_from_config(const INIReader &gmc_config) {
     _downscale = gmc_config.GetFloat(_algo_name, "downscale", 5.0F);
     _max_iterations = gmc_config.GetInteger(_algo_name, "max_iterations", 100);
     _termination_eps = gmc_config.GetFloat(_algo_name, "termination_eps", 1e-6);
@@ -246,6 +333,7 @@ void ECC_GMC::_load_params_from_config(const std::string &config_dir) {
 
 HomographyMatrix ECC_GMC::apply(const cv::Mat &frame_raw, const std::vector<Detection> &detections) {
     // Initialization
+    tracing::Laps trace("gmc");
     int height = frame_raw.rows;
     int width = frame_raw.cols;
 
@@ -262,6 +350,7 @@ HomographyMatrix ECC_GMC::apply(const cv::Mat &frame_raw, const std::vector<Dete
         cv::GaussianBlur(frame, frame, _gaussian_blur_kernel_size, 1.5);
         cv::resize(frame, frame, cv::Size(width, height));
     }
+    trace.lap("ecc.preprocess");
 
     if (!_first_frame_initialized) {
         /**
@@ -285,24 +374,29 @@ HomographyMatrix ECC_GMC::apply(const cv::Mat &frame_raw, const std::vector<Dete
     } catch (const cv::Exception &e) {
         std::cout << "Warning: Could not estimate affine matrix" << std::endl;
     }
+    trace.lap("ecc.find_transform");
 
 
     return H;
 }
 
+void ECC_GMC::save_state(SnapshotWriter &writer) const {
+    writer.write(static_cast<uint8_t>(_first_frame_initialized));
+    writer.write_mat(_prev_frame);
+}
 
-// Optical Flow
-SparseOptFlow_GMC::SparseOptFlow_GMC(const std::string &config_dir) {
-    _load_params_from_config(config_dir);
+void ECC_GMC::load_state(SnapshotReader &reader) {
+    _first_frame_initialized = reader.read<uint8_t>() != 0;
+    reader.read_mat(_prev_frame);
 }
 
-void SparseOptFlow_GMC::_load_params_from_config(const std::string &config_dir) {
-    INIReader gmc_config(config_dir + "/gmc.ini");
-    if (gmc_config.ParseError() < 0) {
-        std::cout << "Can't load " << config_dir << "/gmc.ini" << std::endl;
-        exit(1);
-    }
 
+// Optical Flow
+SparseOptFlow_GMC::SparseOptFlow_GMC(const INIReader &gmc_config) {
+    _load_params_from_config(gmc_config);
+}
+
+void SparseOptFlow_GMC::_load_params_from_config(const INIReader &gmc_config) {
     _useHarrisDetector = gmc_config.GetBoolean(_algo_name, "use_harris_detector", false);
 
     _maxCorners = gmc_config.GetInteger(_algo_name, "max_corners", 1000);
@@ -321,6 +415,7 @@ void SparseOptFlow_GMC::_load_params_from_config(const std::string &config_dir)
 
 HomographyMatrix SparseOptFlow_GMC::apply(const cv::Mat &frame_raw, const std::vector<Detection> &detections) {
     // Initialization
+    tracing::Laps trace("gmc");
     int height = frame_raw.rows;
     int width = frame_raw.cols;
 
@@ -336,11 +431,13 @@ HomographyMatrix SparseOptFlow_GMC::apply(const cv::Mat &frame_raw, const std::v
         width /= _downscale, height /= _downscale;
         cv::resize(frame, frame, cv::Size(width, height));
     }
+    trace.lap("sparse_optflow.preprocess");
 
 
     // Detect keypoints
     std::vector<cv::Point2f> keypoints;
     cv::goodFeaturesToTrack(frame, keypoints, _maxCorners, _qualityLevel, _minDistance, cv::noArray(), _blockSize, _useHarrisDetector, _k);
+    trace.lap("sparse_optflow.detect");
 
     if (!_first_frame_initialized || _prev_keypoints.size() == 0) {
         /**
@@ -364,6 +461,7 @@ HomographyMatrix SparseOptFlow_GMC::apply(const cv::Mat &frame_raw, const std::v
         std::cout << "Warning: Could not find correspondences for GMC" << std::endl;
         return H;
     }
+    trace.lap("sparse_optflow.optical_flow");
 
 
     // Keep good matches
@@ -392,16 +490,29 @@ HomographyMatrix SparseOptFlow_GMC::apply(const cv::Mat &frame_raw, const std::v
             std::cout << "Warning: Could not estimate affine matrix" << std::endl;
         }
     }
+    trace.lap("sparse_optflow.estimate");
 
     _prev_frame = frame.clone();
     _prev_keypoints = keypoints;
     return H;
 }
 
+void SparseOptFlow_GMC::save_state(SnapshotWriter &writer) const {
+    writer.write(static_cast<uint8_t>(_first_frame_initialized));
+    writer.write_mat(_prev_frame);
+    write_points(writer, _prev_keypoints);
+}
+
+void SparseOptFlow_GMC::load_state(SnapshotReader &reader) {
+    _first_frame_initialized = reader.read<uint8_t>() != 0;
+    reader.read_mat(_prev_frame);
+    read_points(reader, _prev_keypoints);
+}
+
 
 // OpenCV VideoStab
-OpenCV_VideoStab_GMC::OpenCV_VideoStab_GMC(const std::string &config_dir) {
-    _load_params_from_config(config_dir);
+OpenCV_VideoStab_GMC::OpenCV_VideoStab_GMC(const INIReader &gmc_config) {
+    _load_params_from_config(gmc_config);
 
     _motion_estimator = cv::makePtr<cv::videostab::MotionEstimatorRansacL2>(cv::videostab::MM_SIMILARITY);
 
@@ -409,13 +520,7 @@ OpenCV_VideoStab_GMC::OpenCV_VideoStab_GMC(const std::string &config_dir) {
     _keypoint_motion_estimator->setDetector(cv::GFTTDetector::create(_num_features));
 }
 
-void OpenCV_VideoStab_GMC::_load_params_from_config(const std::string &config_dir) {
-    INIReader gmc_config(config_dir + "/gmc.ini");
-    if (gmc_config.ParseError() < 0) {
-        std::cout << "Can't load " << config_dir << "/gmc.ini" << std::endl;
-        exit(1);
-    }
-
+void OpenCV_VideoStab_GMC::_load_params_from_config(const INIReader &gmc_config) {
     _downscale = gmc_config.GetFloat(_algo_name, "downscale", 2.0F);
     _num_features = gmc_config.GetInteger(_algo_name, "num_features", 4000);
     _detections_masking = gmc_config.GetBoolean(_algo_name, "detections_masking", true);
@@ -424,6 +529,7 @@ void OpenCV_VideoStab_GMC::_load_params_from_config(const std::string &config_di
 
 HomographyMatrix OpenCV_VideoStab_GMC::apply(const cv::Mat &frame_raw, const std::vector<Detection> &detections) {
     // Initialization
+    tracing::Laps trace("gmc");
     int height = frame_raw.rows;
     int width = frame_raw.cols;
 
@@ -440,6 +546,7 @@ HomographyMatrix OpenCV_VideoStab_GMC::apply(const cv::Mat &frame_raw, const std
         width /= _downscale, height /= _downscale;
         cv::resize(frame_raw, frame, cv::Size(width, height));
     }
+    trace.lap("videostab.preprocess");
 
     cv::Mat homography = cv::Mat::eye(3, 3, CV_32F);
 
@@ -470,24 +577,30 @@ HomographyMatrix OpenCV_VideoStab_GMC::apply(const cv::Mat &frame_raw, const std
         }
     }
 
+    trace.lap("videostab.estimate");
+
     frame.copyTo(_prev_frame);
     homography.copyTo(_prev_homography);
     return H;
 }
 
+void OpenCV_VideoStab_GMC::save_state(SnapshotWriter &writer) const {
+    writer.write_mat(_prev_frame);
+    writer.write_mat(_prev_homography);
+}
 
-// Optical Flow Modified
-OptFlowModified_GMC::OptFlowModified_GMC(const std::string &config_dir) {
-    _load_params_from_config(config_dir);
+void OpenCV_VideoStab_GMC::load_state(SnapshotReader &reader) {
+    reader.read_mat(_prev_frame);
+    reader.read_mat(_prev_homography);
 }
 
-void OptFlowModified_GMC::_load_params_from_config(const std::string &config_dir) {
-    INIReader gmc_config(config_dir + "/gmc.ini");
-    if (gmc_config.ParseError() < 0) {
-        std::cout << "Can't load " << config_dir << "/gmc.ini" << std::endl;
-        exit(1);
-    }
 
+// Optical Flow Modified
+OptFlowModified_GMC::OptFlowModified_GMC(const INIReader &gmc_config) {
+    _load_params_from_config(gmc_config);
+}
+
+void OptFlowModified_GMC::_load_params_from_config(const INIReader &gmc_config) {
     _downscale = gmc_config.GetFloat(_algo_name, "downscale", 2.0F);
 }
 
@@ -498,3 +611,11 @@ HomographyMatrix OptFlowModified_GMC::apply(const cv::Mat &frame, const std::vec
     std::cout << "Warning: OptFlowModified_GMC not implemented, returning identity matrix" << std::endl;
     return H;
 }
+
+
+// No motion compensation (static cameras), the frame is not used
+HomographyMatrix None_GMC::apply(const cv::Mat &frame, const std::vector<Detection> &detections) {
+    HomographyMatrix H;
+    H.setIdentity();
+    return H;
+}
@@ -0,0 +1,104 @@
+#include "ImageSequenceReader.h"
+
+#include <algorithm>
+#include <fstream>
+#include <utility>
+
+#include <opencv2/imgcodecs.hpp>
+
+
+ImageSequenceReader::ImageSequenceReader(std::vector<std::string> filepaths, size_t prefetch_size, unsigned int num_threads)
+    : _filepaths(std::move(filepaths)),
+      _slots(std::max<size_t>(prefetch_size, 1)) {
+    if (num_threads == 0) {
+        num_threads = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+    num_threads = static_cast<unsigned int>(std::min<size_t>(num_threads, _slots.size()));
+
+    for (unsigned int i = 0; i < num_threads; i++) {
+        _workers.emplace_back(&ImageSequenceReader::_run, this);
+    }
+}
+
+ImageSequenceReader::~ImageSequenceReader() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _slot_free.notify_all();
+    for (std::thread &worker: _workers) {
+        worker.join();
+    }
+}
+
+bool ImageSequenceReader::read(cv::Mat &frame) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_next_to_read >= _filepaths.size()) {
+        return false;
+    }
+
+    Slot &slot = _slots[_next_to_read % _slots.size()];
+    _slot_ready.wait(lock, [&slot]() { return slot.ready; });
+
+    // The caller's previous buffer takes the place of the frame, to be decoded into again
+    std::swap(frame, slot.frame);
+    slot.ready = false;
+    _next_to_read++;
+    lock.unlock();
+
+    _slot_free.notify_one();
+    return true;
+}
+
+size_t ImageSequenceReader::size() const {
+    return _filepaths.size();
+}
+
+const std::string &ImageSequenceReader::filepath(size_t index) const {
+    return _filepaths[index];
+}
+
+void ImageSequenceReader::_run() {
+    std::vector<uchar> encoded;
+
+    while (true) {
+        size_t index;
+        {
+            // A frame is decoded only once the frame previously using its slot has been read
+            std::unique_lock<std::mutex> lock(_mutex);
+            _slot_free.wait(lock, [this]() {
+                return _stop || (_next_to_decode < _filepaths.size() && _next_to_decode < _next_to_read + _slots.size());
+            });
+            if (_stop) {
+                return;
+            }
+            index = _next_to_decode++;
+        }
+
+        // The slot is owned by this thread until it is marked ready
+        Slot &slot = _slots[index % _slots.size()];
+        // imdecode leaves its output untouched when no decoder recognizes the data, the previous frame of the
+        // slot must not be handed out again in place of an unreadable image
+        slot.frame.release();
+        std::ifstream file(_filepaths[index], std::ios::binary | std::ios::ate);
+        if (file) {
+            encoded.resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(reinterpret_cast<char *>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+        }
+        if (file && !encoded.empty()) {
+            // An exception escaping a decoding thread would terminate the process, a corrupted image is an empty frame
+            try {
+                cv::imdecode(encoded, cv::IMREAD_COLOR, &slot.frame);
+            } catch (const cv::Exception &) {
+                slot.frame.release();
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            slot.ready = true;
+        }
+        _slot_ready.notify_one();
+    }
+}
@@ -0,0 +1,108 @@
+#include "InputLog.h"
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+
+uint64_t input_log::hash_tracks(const std::vector<std::shared_ptr<Track>> &tracks) {
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](const void *data, size_t size) {
+        const auto *bytes = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
+        }
+    };
+
+    for (const std::shared_ptr<Track> &track: tracks) {
+        std::vector<float> tlwh = track->get_tlwh();
+        float score = track->get_score();
+        uint8_t class_id = track->get_class_id();
+        mix(&track->track_id, sizeof(track->track_id));
+        mix(tlwh.data(), tlwh.size() * sizeof(float));
+        mix(&score, sizeof(score));
+        mix(&class_id, sizeof(class_id));
+    }
+    return hash;
+}
+
+
+InputLogWriter::InputLogWriter(const std::string &path, int feature_dim)
+    : _file(path, std::ios::binary | std::ios::trunc) {
+    if (!_file) {
+        throw std::runtime_error("Can't open the input log " + path);
+    }
+
+    SnapshotWriter writer(_buffer);
+    writer.write_bytes(input_log::MAGIC, sizeof(input_log::MAGIC));
+    writer.write(input_log::VERSION);
+    writer.write(static_cast<int64_t>(feature_dim));
+}
+
+InputLogWriter::~InputLogWriter() {
+    try {
+        flush();
+    } catch (const std::exception &e) {
+        std::cout << e.what() << std::endl;
+    }
+}
+
+void InputLogWriter::write(const RecordedFrame &frame) {
+    SnapshotWriter writer(_buffer);
+    writer.write(frame.frame_id);
+    writer.write(frame.timestamp_ns);
+    writer.write(frame.duration_ns);
+    writer.write(static_cast<int32_t>(frame.image_size.width));
+    writer.write(static_cast<int32_t>(frame.image_size.height));
+    writer.write_matrix(frame.homography);
+    writer.write_vector(frame.detections);
+    writer.write_matrix(frame.features);
+    writer.write_vector(frame.feat_frame_ids);
+    writer.write(frame.num_output_tracks);
+    writer.write(frame.output_hash);
+
+    if (_buffer.size() >= _flush_size) {
+        flush();
+    }
+}
+
+void InputLogWriter::flush() {
+    if (_buffer.empty()) {
+        return;
+    }
+    _file.write(_buffer.data(), static_cast<std::streamsize>(_buffer.size()));
+    _file.flush();
+    _buffer.clear();
+    if (!_file) {
+        throw std::runtime_error("Can't write the input log");
+    }
+}
+
+
+InputLogReader::InputLogReader(const std::string &path) : _file(path), _reader(_file.view()) {
+    char magic[sizeof(input_log::MAGIC)];
+    _reader.read_bytes(magic, sizeof(magic));
+    if (std::memcmp(magic, input_log::MAGIC, sizeof(magic)) != 0 || _reader.read<uint32_t>() != input_log::VERSION) {
+        throw std::runtime_error(path + " is not an input log of this version");
+    }
+    _feature_dim = static_cast<int>(_reader.read<int64_t>());
+}
+
+bool InputLogReader::next(RecordedFrame &frame) {
+    if (_reader.at_end()) {
+        return false;
+    }
+
+    frame.frame_id = _reader.read<uint32_t>();
+    frame.timestamp_ns = _reader.read<int64_t>();
+    frame.duration_ns = _reader.read<int64_t>();
+    frame.image_size.width = _reader.read<int32_t>();
+    frame.image_size.height = _reader.read<int32_t>();
+    _reader.read_matrix(frame.homography);
+    _reader.read_vector(frame.detections);
+    _reader.read_matrix(frame.features);
+    _reader.read_vector(frame.feat_frame_ids);
+    frame.num_output_tracks = _reader.read<uint32_t>();
+    frame.output_hash = _reader.read<uint64_t>();
+    return true;
+}
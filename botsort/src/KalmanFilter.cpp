@@ -94,7 +94,7 @@ Eigen::Matrix<float, 1, Eigen::Dynamic> KalmanFilter::gating_distance(
     }
 
     Eigen::MatrixXf cholesky_factor = projected_covariance.llt().matrixL();
-    Eigen::MatrixXf mahalanobis_distance = cholesky_factor.triangularView<Eigen::Lower>().solve(diff).transpose();
+    Eigen::MatrixXf mahalanobis_distance = cholesky_factor.triangularView<Eigen::Lower>().solve(diff.transpose()).transpose();
 
     return mahalanobis_distance.array().square().matrix().rowwise().sum();
 }
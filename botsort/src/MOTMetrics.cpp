@@ -0,0 +1,526 @@
+#include "MOTMetrics.h"
+#include "DetectionLoader.h"
+#include "matching.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+
+namespace {
+float box_iou(const cv::Rect_<float> &a, const cv::Rect_<float> &b) {
+    float width = std::min(a.x + a.width, b.x + b.width) - std::max(a.x, b.x);
+    float height = std::min(a.y + a.height, b.y + b.height) - std::max(a.y, b.y);
+    if (width <= 0.0F || height <= 0.0F) {
+        return 0.0F;
+    }
+    float intersection = width * height;
+    return intersection / (a.width * a.height + b.width * b.height - intersection);
+}
+
+double ratio(double numerator, double denominator) {
+    return denominator > 0 ? numerator / denominator : 0.0;
+}
+}// namespace
+
+
+std::string MOTMetrics::summary() const {
+    std::ostringstream out;
+    out << "| Frames | GT | IDs | MT | PT | ML | FP | FN | IDsw | FM | MOTA (%) | MOTP (%) | IDF1 (%) | IDP (%) | IDR (%) | Rcll (%) | Prcn (%) | HOTA (%) | DetA (%) | AssA (%) | LocA (%) |\n"
+        << "| --- | --- | --- | --- | --- | --- | --- | --- | --- | --- | --- | --- | --- | --- | --- | --- | --- | --- | --- | --- | --- |\n";
+    out << "| " << num_frames << " | " << num_objects << " | " << num_unique_objects
+        << " | " << mostly_tracked << " | " << partially_tracked << " | " << mostly_lost
+        << " | " << num_false_positives << " | " << num_misses << " | " << num_switches << " | " << num_fragmentations
+        << std::fixed << std::setprecision(2);
+    for (double value: {mota, motp, idf1, idp, idr, recall, precision, hota, deta, assa, loca}) {
+        out << " | " << value * 100.0;
+    }
+    out << " |\n";
+    return out.str();
+}
+
+
+MOTMetricsEvaluator::MOTMetricsEvaluator(const MOTMetricsParams &params) : _params(params) {
+    if (_params.iou_threshold <= 0.0F || _params.iou_threshold > 1.0F) {
+        throw std::runtime_error("MOT metrics: the IoU threshold must be in (0, 1]");
+    }
+}
+
+
+void MOTMetricsEvaluator::update(const std::vector<GroundTruthObject> &ground_truth, const std::vector<std::shared_ptr<Track>> &tracks) {
+    std::vector<Box> gt_boxes, ignored, track_boxes;
+    for (const GroundTruthObject &object: ground_truth) {
+        (object.visibility < _params.min_visibility ? ignored : gt_boxes).push_back({object.id, object.bbox_tlwh});
+    }
+    track_boxes.reserve(tracks.size());
+    for (const std::shared_ptr<Track> &track: tracks) {
+        std::vector<float> tlwh = track->get_tlwh();
+        track_boxes.push_back({track->track_id, cv::Rect_<float>(tlwh[0], tlwh[1], tlwh[2], tlwh[3])});
+    }
+    _update(gt_boxes, ignored, track_boxes);
+}
+
+void MOTMetricsEvaluator::update(const std::vector<GroundTruthObject> &ground_truth, const std::vector<GroundTruthObject> &tracks) {
+    std::vector<Box> gt_boxes, ignored, track_boxes;
+    for (const GroundTruthObject &object: ground_truth) {
+        (object.visibility < _params.min_visibility ? ignored : gt_boxes).push_back({object.id, object.bbox_tlwh});
+    }
+    track_boxes.reserve(tracks.size());
+    for (const GroundTruthObject &track: tracks) {
+        track_boxes.push_back({track.id, track.bbox_tlwh});
+    }
+    _update(gt_boxes, ignored, track_boxes);
+}
+
+
+void MOTMetricsEvaluator::_update(const std::vector<Box> &ground_truth, const std::vector<Box> &ignored, std::vector<Box> &tracks) {
+    // Tracks on ignored ground truth are neither matches nor false positives
+    if (!ignored.empty() && !tracks.empty()) {
+        std::vector<std::pair<std::pair<int, int>, float>> edges;
+        for (const Overlap &overlap: _overlaps(ignored, tracks, _params.iou_threshold)) {
+            edges.push_back({{overlap.gt_index, overlap.pred_index}, overlap.iou});
+        }
+        std::vector<uint8_t> removed(tracks.size(), 0);
+        for (const auto &[row, col]: _max_weight_matching(static_cast<int>(ignored.size()), static_cast<int>(tracks.size()), edges)) {
+            removed[col] = 1;
+        }
+        size_t kept = 0;
+        for (size_t i = 0; i < tracks.size(); i++) {
+            if (!removed[i]) {
+                tracks[kept++] = tracks[i];
+            }
+        }
+        tracks.resize(kept);
+    }
+
+    const auto num_gt = static_cast<int>(ground_truth.size()), num_tracks = static_cast<int>(tracks.size());
+    _counts.num_frames++;
+    _counts.num_objects += num_gt;
+    _counts.num_predictions += num_tracks;
+
+    std::vector<int> gt_identity(num_gt), pred_identity(num_tracks);
+    for (int i = 0; i < num_gt; i++) {
+        gt_identity[i] = _gt_identity(ground_truth[i].id);
+        _gt_frames[gt_identity[i]]++;
+    }
+    for (int j = 0; j < num_tracks; j++) {
+        pred_identity[j] = _pred_identity(tracks[j].id);
+        _pred_frames[pred_identity[j]]++;
+    }
+
+    // HOTA needs every overlap, the other metrics only the pairs above the IoU threshold
+    const float min_iou = _params.compute_hota ? std::numeric_limits<float>::min() : _params.iou_threshold;
+    std::vector<Overlap> overlaps = _overlaps(ground_truth, tracks, min_iou);
+
+    // CLEAR MOT: the previous matches are kept while they are valid, the other pairs are assigned
+    // (weight 1 + IoU, as many matches as possible, then the highest IoU)
+    std::vector<int> gt_match(num_gt, -1);
+    std::vector<float> gt_match_iou(num_gt, 0.0F);
+    std::vector<uint8_t> track_matched(num_tracks, 0), new_match(num_gt, 0);
+    for (const Overlap &overlap: overlaps) {
+        if (overlap.iou >= _params.iou_threshold && gt_match[overlap.gt_index] < 0 && !track_matched[overlap.pred_index] &&
+            _last_match[gt_identity[overlap.gt_index]] == pred_identity[overlap.pred_index]) {
+            gt_match[overlap.gt_index] = overlap.pred_index;
+            gt_match_iou[overlap.gt_index] = overlap.iou;
+            track_matched[overlap.pred_index] = 1;
+        }
+    }
+
+    std::vector<std::pair<std::pair<int, int>, float>> edges;
+    for (const Overlap &overlap: overlaps) {
+        if (overlap.iou >= _params.iou_threshold) {
+            _id_overlap_frames[_pair_key(gt_identity[overlap.gt_index], pred_identity[overlap.pred_index])]++;
+            if (gt_match[overlap.gt_index] < 0 && !track_matched[overlap.pred_index]) {
+                edges.push_back({{overlap.gt_index, overlap.pred_index}, 1.0F + overlap.iou});
+            }
+        }
+    }
+    for (const auto &[row, col]: _max_weight_matching(num_gt, num_tracks, edges)) {
+        gt_match[row] = col;
+        track_matched[col] = 1;
+        new_match[row] = 1;
+    }
+    for (const auto &[pair, weight]: edges) {
+        if (gt_match[pair.first] == pair.second) {
+            gt_match_iou[pair.first] = weight - 1.0F;
+        }
+    }
+
+    for (int i = 0; i < num_gt; i++) {
+        const int identity = gt_identity[i];
+        if (gt_match[i] < 0) {
+            _lost_since_match[identity] = _last_match[identity] >= 0;
+            continue;
+        }
+
+        const int pred = pred_identity[gt_match[i]];
+        if (new_match[i] && _last_match[identity] >= 0 && _last_match[identity] != pred) {
+            _counts.num_switches++;
+        }
+        if (_lost_since_match[identity]) {
+            _counts.num_fragmentations++;
+            _lost_since_match[identity] = 0;
+        }
+        _last_match[identity] = pred;
+        _gt_matched_frames[identity]++;
+        _counts.num_matches++;
+        _distance_sum += 1.0 - gt_match_iou[i];
+    }
+    _counts.num_misses += num_gt - std::count_if(gt_match.begin(), gt_match.end(), [](int match) { return match >= 0; });
+    _counts.num_false_positives += num_tracks - std::count(track_matched.begin(), track_matched.end(), 1);
+
+    if (_params.compute_hota) {
+        for (Overlap &overlap: overlaps) {
+            overlap.gt_index = gt_identity[overlap.gt_index];
+            overlap.pred_index = pred_identity[overlap.pred_index];
+        }
+        _frame_overlaps.push_back(std::move(overlaps));
+    }
+}
+
+
+MOTMetrics MOTMetricsEvaluator::compute() const {
+    MOTMetrics metrics = _counts;
+    metrics.num_unique_objects = _gt_frames.size();
+    for (size_t i = 0; i < _gt_frames.size(); i++) {
+        double tracked = ratio(_gt_matched_frames[i], _gt_frames[i]);
+        if (tracked >= 0.8) {
+            metrics.mostly_tracked++;
+        } else if (tracked < 0.2) {
+            metrics.mostly_lost++;
+        } else {
+            metrics.partially_tracked++;
+        }
+    }
+
+    const auto num_objects = static_cast<double>(metrics.num_objects), num_predictions = static_cast<double>(metrics.num_predictions);
+    const auto num_matches = static_cast<double>(metrics.num_matches);
+    metrics.mota = num_objects > 0
+                           ? 1.0 - static_cast<double>(metrics.num_misses + metrics.num_false_positives + metrics.num_switches) / num_objects
+                           : 0.0;
+    metrics.motp = ratio(_distance_sum, num_matches);
+    metrics.precision = ratio(num_matches, num_predictions);
+    metrics.recall = ratio(num_matches, num_objects);
+
+    _compute_idf1(metrics);
+    if (_params.compute_hota) {
+        _compute_hota(metrics);
+    }
+    return metrics;
+}
+
+
+void MOTMetricsEvaluator::reset() {
+    _counts = MOTMetrics();
+    _distance_sum = 0;
+    _gt_index.clear(), _pred_index.clear();
+    _gt_frames.clear(), _pred_frames.clear(), _gt_matched_frames.clear();
+    _last_match.clear(), _lost_since_match.clear();
+    _id_overlap_frames.clear();
+    _frame_overlaps.clear();
+}
+
+
+void MOTMetricsEvaluator::merge(const MOTMetricsEvaluator &other) {
+    if (other._params.compute_hota != _params.compute_hota) {
+        throw std::runtime_error("MOT metrics: can't merge an evaluator computing HOTA with one that does not");
+    }
+
+    MOTMetrics &counts = _counts;
+    const MOTMetrics &other_counts = other._counts;
+    counts.num_frames += other_counts.num_frames;
+    counts.num_objects += other_counts.num_objects;
+    counts.num_predictions += other_counts.num_predictions;
+    counts.num_matches += other_counts.num_matches;
+    counts.num_false_positives += other_counts.num_false_positives;
+    counts.num_misses += other_counts.num_misses;
+    counts.num_switches += other_counts.num_switches;
+    counts.num_fragmentations += other_counts.num_fragmentations;
+    _distance_sum += other._distance_sum;
+
+    // The identities of the other evaluator are appended after ours
+    const auto gt_offset = static_cast<int>(_gt_frames.size()), pred_offset = static_cast<int>(_pred_frames.size());
+    _gt_frames.insert(_gt_frames.end(), other._gt_frames.begin(), other._gt_frames.end());
+    _pred_frames.insert(_pred_frames.end(), other._pred_frames.begin(), other._pred_frames.end());
+    _gt_matched_frames.insert(_gt_matched_frames.end(), other._gt_matched_frames.begin(), other._gt_matched_frames.end());
+    _lost_since_match.insert(_lost_since_match.end(), other._lost_since_match.begin(), other._lost_since_match.end());
+    for (int match: other._last_match) {
+        _last_match.push_back(match >= 0 ? match + pred_offset : -1);
+    }
+    for (const auto &[key, frames]: other._id_overlap_frames) {
+        _id_overlap_frames[_pair_key(static_cast<int>(key >> 32) + gt_offset, static_cast<int>(key & 0xFFFFFFFF) + pred_offset)] = frames;
+    }
+    for (std::vector<Overlap> overlaps: other._frame_overlaps) {
+        for (Overlap &overlap: overlaps) {
+            overlap.gt_index += gt_offset;
+            overlap.pred_index += pred_offset;
+        }
+        _frame_overlaps.push_back(std::move(overlaps));
+    }
+}
+
+
+void MOTMetricsEvaluator::_compute_idf1(MOTMetrics &metrics) const {
+    // Each ground truth trajectory is assigned to at most one track, maximizing the frames they overlap
+    std::vector<std::pair<std::pair<int, int>, float>> edges;
+    edges.reserve(_id_overlap_frames.size());
+    for (const auto &[key, frames]: _id_overlap_frames) {
+        edges.push_back({{static_cast<int>(key >> 32), static_cast<int>(key & 0xFFFFFFFF)}, static_cast<float>(frames)});
+    }
+
+    double id_true_positives = 0;
+    for (const auto &[row, col]: _max_weight_matching(static_cast<int>(_gt_frames.size()), static_cast<int>(_pred_frames.size()), edges)) {
+        id_true_positives += _id_overlap_frames.at(_pair_key(row, col));
+    }
+
+    metrics.idp = ratio(id_true_positives, static_cast<double>(metrics.num_predictions));
+    metrics.idr = ratio(id_true_positives, static_cast<double>(metrics.num_objects));
+    metrics.idf1 = ratio(2.0 * id_true_positives, static_cast<double>(metrics.num_objects + metrics.num_predictions));
+}
+
+
+void MOTMetricsEvaluator::_compute_hota(MOTMetrics &metrics) const {
+    // First pass: global alignment score of every (gt, track) pair, from the overlaps normalized within each frame
+    std::unordered_map<uint64_t, double> potential_matches;
+    std::unordered_map<int, double> gt_sums, pred_sums;
+    for (const std::vector<Overlap> &overlaps: _frame_overlaps) {
+        gt_sums.clear(), pred_sums.clear();
+        for (const Overlap &overlap: overlaps) {
+            gt_sums[overlap.gt_index] += overlap.iou;
+            pred_sums[overlap.pred_index] += overlap.iou;
+        }
+        for (const Overlap &overlap: overlaps) {
+            potential_matches[_pair_key(overlap.gt_index, overlap.pred_index)] +=
+                    overlap.iou / (gt_sums[overlap.gt_index] + pred_sums[overlap.pred_index] - overlap.iou);
+        }
+    }
+    auto global_alignment = [&](int gt, int pred) {
+        double potential = potential_matches.at(_pair_key(gt, pred));
+        return potential / (_gt_frames[gt] + _pred_frames[pred] - potential);
+    };
+
+    // Second pass: matching of each frame by alignment * IoU, the matches are counted for every IoU threshold
+    std::array<double, NUM_HOTA_THRESHOLDS> alphas{}, true_positives{}, loc_sums{};
+    std::array<std::unordered_map<uint64_t, uint32_t>, NUM_HOTA_THRESHOLDS> match_frames;
+    for (int a = 0; a < NUM_HOTA_THRESHOLDS; a++) {
+        alphas[a] = 0.05 * (a + 1);
+    }
+
+    std::unordered_map<int, int> gt_local, pred_local;
+    std::vector<int> gt_of_local, pred_of_local;
+    for (const std::vector<Overlap> &overlaps: _frame_overlaps) {
+        gt_local.clear(), pred_local.clear(), gt_of_local.clear(), pred_of_local.clear();
+        std::vector<std::pair<std::pair<int, int>, float>> edges;
+        std::unordered_map<uint64_t, float> ious;
+        for (const Overlap &overlap: overlaps) {
+            auto [gt_it, gt_new] = gt_local.emplace(overlap.gt_index, static_cast<int>(gt_of_local.size()));
+            if (gt_new) {
+                gt_of_local.push_back(overlap.gt_index);
+            }
+            auto [pred_it, pred_new] = pred_local.emplace(overlap.pred_index, static_cast<int>(pred_of_local.size()));
+            if (pred_new) {
+                pred_of_local.push_back(overlap.pred_index);
+            }
+            edges.push_back({{gt_it->second, pred_it->second},
+                             static_cast<float>(global_alignment(overlap.gt_index, overlap.pred_index) * overlap.iou)});
+            ious[_pair_key(overlap.gt_index, overlap.pred_index)] = overlap.iou;
+        }
+
+        for (const auto &[row, col]: _max_weight_matching(static_cast<int>(gt_of_local.size()), static_cast<int>(pred_of_local.size()), edges)) {
+            const uint64_t key = _pair_key(gt_of_local[row], pred_of_local[col]);
+            const float iou = ious[key];
+            for (int a = 0; a < NUM_HOTA_THRESHOLDS && iou >= alphas[a] - 1e-6; a++) {
+                true_positives[a]++;
+                loc_sums[a] += iou;
+                match_frames[a][key]++;
+            }
+        }
+    }
+
+    // DetA = TP / (TP + FN + FP), AssA = mean over the TPs of TPA / (TPA + FNA + FPA) of their pair
+    const auto num_objects = static_cast<double>(metrics.num_objects), num_predictions = static_cast<double>(metrics.num_predictions);
+    double hota = 0, deta = 0, assa = 0, loca = 0;
+    for (int a = 0; a < NUM_HOTA_THRESHOLDS; a++) {
+        double association = 0;
+        for (const auto &[key, frames]: match_frames[a]) {
+            const double gt_frames = _gt_frames[key >> 32], pred_frames = _pred_frames[key & 0xFFFFFFFF];
+            association += frames * frames / (gt_frames + pred_frames - frames);
+        }
+        const double detection_accuracy = ratio(true_positives[a], num_objects + num_predictions - true_positives[a]);
+        const double association_accuracy = ratio(association, true_positives[a]);
+        hota += std::sqrt(detection_accuracy * association_accuracy);
+        deta += detection_accuracy;
+        assa += association_accuracy;
+        loca += ratio(loc_sums[a], true_positives[a]);
+    }
+    metrics.hota = hota / NUM_HOTA_THRESHOLDS;
+    metrics.deta = deta / NUM_HOTA_THRESHOLDS;
+    metrics.assa = assa / NUM_HOTA_THRESHOLDS;
+    metrics.loca = loca / NUM_HOTA_THRESHOLDS;
+}
+
+
+std::vector<MOTMetricsEvaluator::Overlap> MOTMetricsEvaluator::_overlaps(const std::vector<Box> &ground_truth,
+                                                                         const std::vector<Box> &tracks, float min_iou) {
+    std::vector<int> order(tracks.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return tracks[a].tlwh.x < tracks[b].tlwh.x; });
+    float max_width = 0.0F;
+    for (const Box &track: tracks) {
+        max_width = std::max(max_width, track.tlwh.width);
+    }
+
+    // Only the tracks whose left edge is within [gt left - widest track, gt right] can overlap
+    std::vector<Overlap> overlaps;
+    for (size_t i = 0; i < ground_truth.size(); i++) {
+        const cv::Rect_<float> &gt = ground_truth[i].tlwh;
+        auto first = std::lower_bound(order.begin(), order.end(), gt.x - max_width,
+                                      [&](int index, float x) { return tracks[index].tlwh.x < x; });
+        for (auto it = first; it != order.end() && tracks[*it].tlwh.x <= gt.x + gt.width; ++it) {
+            float iou = box_iou(gt, tracks[*it].tlwh);
+            if (iou >= min_iou && iou > 0.0F) {
+                overlaps.push_back({static_cast<int>(i), *it, iou});
+            }
+        }
+    }
+    return overlaps;
+}
+
+
+std::vector<std::pair<int, int>> MOTMetricsEvaluator::_max_weight_matching(int num_rows, int num_cols,
+                                                                           const std::vector<std::pair<std::pair<int, int>, float>> &edges) {
+    // Connected components of the graph (rows are nodes [0, num_rows), columns [num_rows, num_rows + num_cols))
+    std::vector<int> parent(num_rows + num_cols);
+    std::iota(parent.begin(), parent.end(), 0);
+    auto find = [&parent](int node) {
+        while (parent[node] != node) {
+            node = parent[node] = parent[parent[node]];
+        }
+        return node;
+    };
+    std::vector<int> edge_order, edge_component(edges.size());
+    for (size_t e = 0; e < edges.size(); e++) {
+        if (edges[e].second > 0.0F) {
+            parent[find(edges[e].first.first)] = find(num_rows + edges[e].first.second);
+            edge_order.push_back(static_cast<int>(e));
+        }
+    }
+    for (int e: edge_order) {
+        edge_component[e] = find(edges[e].first.first);
+    }
+    std::sort(edge_order.begin(), edge_order.end(), [&](int a, int b) { return edge_component[a] < edge_component[b]; });
+
+    std::vector<std::pair<int, int>> matches;
+    std::vector<int> row_local(num_rows, -1), col_local(num_cols, -1), local_rows, local_cols;
+    for (size_t begin = 0, end; begin < edge_order.size(); begin = end) {
+        const int component = edge_component[edge_order[begin]];
+        for (end = begin + 1; end < edge_order.size() && edge_component[edge_order[end]] == component; end++) {}
+        if (end - begin == 1) {
+            matches.push_back(edges[edge_order[begin]].first);
+            continue;
+        }
+
+        // Gain of a match = weight: cost max_weight - weight against max_weight for leaving both unmatched
+        float max_weight = 0.0F;
+        for (size_t e = begin; e < end; e++) {
+            const auto &[pair, weight] = edges[edge_order[e]];
+            if (row_local[pair.first] < 0) {
+                row_local[pair.first] = static_cast<int>(local_rows.size());
+                local_rows.push_back(pair.first);
+            }
+            if (col_local[pair.second] < 0) {
+                col_local[pair.second] = static_cast<int>(local_cols.size());
+                local_cols.push_back(pair.second);
+            }
+            max_weight = std::max(max_weight, weight);
+        }
+        CostMatrix cost = CostMatrix::Constant(static_cast<Eigen::Index>(local_rows.size()), static_cast<Eigen::Index>(local_cols.size()),
+                                               2.0F * max_weight + 1.0F);
+        for (size_t e = begin; e < end; e++) {
+            const auto &[pair, weight] = edges[edge_order[e]];
+            cost(row_local[pair.first], col_local[pair.second]) = max_weight - weight;
+        }
+
+        for (const MatchData &match: linear_assignment(cost, max_weight).matches) {
+            if (cost(match.first, match.second) < max_weight) {
+                matches.emplace_back(local_rows[match.first], local_cols[match.second]);
+            }
+        }
+        for (int row: local_rows) {
+            row_local[row] = -1;
+        }
+        for (int col: local_cols) {
+            col_local[col] = -1;
+        }
+        local_rows.clear(), local_cols.clear();
+    }
+    return matches;
+}
+
+
+int MOTMetricsEvaluator::_gt_identity(int id) {
+    auto [it, inserted] = _gt_index.emplace(id, static_cast<int>(_gt_frames.size()));
+    if (inserted) {
+        _gt_frames.push_back(0);
+        _gt_matched_frames.push_back(0);
+        _last_match.push_back(-1);
+        _lost_since_match.push_back(0);
+    }
+    return it->second;
+}
+
+int MOTMetricsEvaluator::_pred_identity(int id) {
+    auto [it, inserted] = _pred_index.emplace(id, static_cast<int>(_pred_frames.size()));
+    if (inserted) {
+        _pred_frames.push_back(0);
+    }
+    return it->second;
+}
+
+
+std::vector<std::vector<GroundTruthObject>> MOTMetricsEvaluator::load_mot_file(const std::string &path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Can't read the MOT file " + path);
+    }
+
+    std::vector<std::vector<GroundTruthObject>> frames;
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        float values[9];
+        int num_values = 0;
+        const char *p = line.c_str();
+        while (num_values < 9) {
+            while (*p == ',' || *p == ' ' || *p == '\t' || *p == '\r') {
+                p++;
+            }
+            char *next = nullptr;
+            float value = std::strtof(p, &next);
+            if (next == p) {
+                break;
+            }
+            values[num_values++] = value;
+            p = next;
+        }
+        if (num_values < 6) {
+            continue;
+        }
+
+        // Validated like the detections, a bad frame-id must not size the per-frame index
+        const size_t frame_index = DetectionLoader::mot_frame_id(values[0], path, line_number) - 1;
+        if (frame_index >= frames.size()) {
+            frames.resize(frame_index + 1);
+        }
+        const float visibility = num_values >= 9 && values[8] >= 0.0F && values[8] <= 1.0F ? values[8] : 1.0F;
+        frames[frame_index].push_back({static_cast<int>(values[1]), cv::Rect_<float>(values[2], values[3], values[4], values[5]), visibility});
+    }
+    return frames;
+}
@@ -0,0 +1,145 @@
+#include "MOTWriter.h"
+
+#include <charconv>
+#include <iostream>
+#include <stdexcept>
+
+
+namespace {
+/**
+ * @brief Format a float like std::ostream does by default (%g with 6 significant digits)
+ */
+inline char *format_float(char *p, char *end, float value) {
+    return std::to_chars(p, end, value, std::chars_format::general, 6).ptr;
+}
+}// namespace
+
+
+MOTWriter::MOTWriter(const std::string &output_file, bool append, size_t block_size)
+    : _path(output_file),
+      _file(output_file, append ? std::ios::binary | std::ios::app : std::ios::binary | std::ios::trunc),
+      _block_size(block_size) {
+    if (!_file.is_open()) {
+        throw std::runtime_error("Can't open " + output_file);
+    }
+
+    _buffer.reserve(_block_size + _max_line_size);
+    _thread = std::thread(&MOTWriter::_run, this);
+}
+
+MOTWriter::~MOTWriter() {
+    // Destructors can't throw, the failure is reported instead
+    try {
+        flush();
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _block_available.notify_one();
+    _thread.join();
+
+    const bool failed_before = _failed;
+    _file.close();
+    if (!failed_before && !_file) {
+        std::cerr << "Can't close " << _path << ", the MOT results may be incomplete" << std::endl;
+    }
+}
+
+void MOTWriter::write(const std::vector<std::shared_ptr<Track>> &tracks) {
+    for (const std::shared_ptr<Track> &track: tracks) {
+        std::vector<float> bbox_tlwh = track->get_tlwh();
+        write(track->frame_id, track->track_id, bbox_tlwh.data());
+    }
+}
+
+void MOTWriter::write(uint32_t frame_id, int track_id, const float tlwh[4]) {
+    _check_failure();
+
+    char line[_max_line_size];
+    char *const line_end = line + _max_line_size;
+
+    char *p = std::to_chars(line, line_end, frame_id).ptr;
+    *p++ = ',';
+    p = std::to_chars(p, line_end, track_id).ptr;
+    for (int i = 0; i < 4; i++) {
+        *p++ = ',';
+        p = format_float(p, line_end, tlwh[i]);
+    }
+
+    static constexpr char suffix[] = ",-1,-1,-1,0\n";
+    _buffer.append(line, p - line).append(suffix, sizeof(suffix) - 1);
+
+    if (_buffer.size() >= _block_size) {
+        _submit_block();
+    }
+}
+
+void MOTWriter::flush() {
+    if (!_buffer.empty()) {
+        _submit_block();
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _block_written.wait(lock, [this]() { return _blocks.empty() && !_writing; });
+    lock.unlock();
+    _check_failure();
+}
+
+void MOTWriter::_check_failure() const {
+    if (_failed) {
+        throw std::runtime_error("Can't write the MOT results to " + _path + " (e.g. disk full), the file is incomplete");
+    }
+}
+
+void MOTWriter::_submit_block() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _block_written.wait(lock, [this]() { return _blocks.size() < _max_pending_blocks; });
+
+    _blocks.push_back(std::move(_buffer));
+    if (!_spares.empty()) {
+        _buffer = std::move(_spares.back());
+        _spares.pop_back();
+    } else {
+        _buffer = std::string();
+        _buffer.reserve(_block_size + _max_line_size);
+    }
+    lock.unlock();
+
+    _block_available.notify_one();
+}
+
+void MOTWriter::_run() {
+    while (true) {
+        std::string block;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _block_available.wait(lock, [this]() { return _stop || !_blocks.empty(); });
+            if (_blocks.empty()) {
+                return;
+            }
+            block = std::move(_blocks.front());
+            _blocks.pop_front();
+            _writing = true;
+        }
+
+        // After a failure the blocks are dropped, the error is raised on the caller thread
+        if (!_failed) {
+            _file.write(block.data(), static_cast<std::streamsize>(block.size()));
+            _file.flush();
+            if (!_file) {
+                _failed = true;
+            }
+        }
+
+        block.clear();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _spares.push_back(std::move(block));
+            _writing = false;
+        }
+        _block_written.notify_all();
+    }
+}
@@ -0,0 +1,49 @@
+#include "MappedFile.h"
+
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+MappedFile::MappedFile(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Can't open " + path);
+    }
+
+    struct stat file_stat {};
+    if (fstat(fd, &file_stat) < 0) {
+        close(fd);
+        throw std::runtime_error("Can't stat " + path);
+    }
+    _size = static_cast<size_t>(file_stat.st_size);
+
+    // mmap does not accept empty mappings, an empty file is an empty view
+    if (_size > 0) {
+        void *data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Can't map " + path);
+        }
+        madvise(data, _size, MADV_SEQUENTIAL);
+        _data = static_cast<const char *>(data);
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (_data != nullptr) {
+        munmap(const_cast<char *>(_data), _size);
+    }
+}
+
+std::string_view MappedFile::view() const {
+    return {_data, _size};
+}
+
+size_t MappedFile::size() const {
+    return _size;
+}
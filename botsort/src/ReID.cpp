@@ -1,8 +1,145 @@
 #include "ReID.h"
 
-ReIDModel::ReIDModel(std::string model_weights, bool fp16_inference) {
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+std::map<std::string, ReID_Method> ReIDModel::ReID_method_map = {
+        {"cnn", ReID_Method::CNN},
+        {"color_histogram", ReID_Method::ColorHistogram},
+};
+
+
+ReIDModel::ReIDModel(ReID_Method method, const std::string &model_weights, int feature_dim, bool fp16_inference) {
+    if (method == ReID_Method::CNN) {
+        std::cout << "Using CNN for Re-ID" << std::endl;
+        _reid_algorithm = std::make_unique<CNN_ReID>(model_weights, feature_dim, fp16_inference);
+    } else if (method == ReID_Method::ColorHistogram) {
+        std::cout << "Using ColorHistogram for Re-ID" << std::endl;
+        _reid_algorithm = std::make_unique<ColorHistogram_ReID>();
+    } else {
+        throw std::runtime_error("Unknown Re-ID method: " + std::to_string(method));
+    }
+}
+
+FeatureMatrix ReIDModel::extract_features(const cv::Mat &frame, const std::vector<cv::Rect_<float>> &bboxes) {
+    return _reid_algorithm->extract_features(frame, bboxes);
 }
 
-FeatureVector ReIDModel::extract_features(cv::Mat &image_patch) {
-    return FeatureVector();
-}
\ No newline at end of file
+int ReIDModel::feature_dim() const {
+    return _reid_algorithm->feature_dim();
+}
+
+
+// CNN
+CNN_ReID::CNN_ReID(const std::string &model_weights, int feature_dim, bool fp16_inference)
+    : _feature_dim(feature_dim),
+      _preprocessor(cv::Size(128, 256), fp16_inference) {
+    if (_feature_dim <= 0) {
+        throw std::runtime_error("Invalid Re-ID feature_dim: " + std::to_string(_feature_dim) + ", expected the output size of the model");
+    }
+}
+
+FeatureMatrix CNN_ReID::extract_features(const cv::Mat &frame, const std::vector<cv::Rect_<float>> &bboxes) {
+    // The batch is preprocessed into _preprocessor.tensor(), but no inference backend is built in:
+    // fail rather than return embeddings that would all match each other
+    _preprocessor.run(frame, bboxes);
+    throw std::runtime_error("CNN Re-ID inference is not available");
+}
+
+int CNN_ReID::feature_dim() const {
+    return _feature_dim;
+}
+
+
+// Color histogram
+FeatureMatrix ColorHistogram_ReID::extract_features(const cv::Mat &frame, const std::vector<cv::Rect_<float>> &bboxes) {
+    CV_Assert(frame.type() == CV_8UC3);
+
+    FeatureMatrix embeddings(static_cast<Eigen::Index>(bboxes.size()), feature_dim());
+    cv::parallel_for_(cv::Range(0, static_cast<int>(bboxes.size())), [&](const cv::Range &range) {
+        for (int i = range.start; i < range.end; i++) {
+            _compute_embedding(frame, bboxes[i], embeddings.row(i).data());
+        }
+    });
+
+    return embeddings;
+}
+
+int ColorHistogram_ReID::feature_dim() const {
+    return _num_stripes * _stripe_dim;
+}
+
+void ColorHistogram_ReID::_compute_embedding(const cv::Mat &frame, const cv::Rect_<float> &bbox, float *embedding) const {
+    const int dim = feature_dim();
+
+    // Clip the bounding box to the frame
+    const float x0 = std::max(0.0F, bbox.x), y0 = std::max(0.0F, bbox.y);
+    const float box_width = std::min(static_cast<float>(frame.cols), bbox.x + bbox.width) - x0;
+    const float box_height = std::min(static_cast<float>(frame.rows), bbox.y + bbox.height) - y0;
+    if (box_width < 1.0F || box_height < 1.0F) {
+        // No pixels, use a constant embedding so that it can still be normalized
+        std::fill(embedding, embedding + dim, 1.0F / std::sqrt(static_cast<float>(dim)));
+        return;
+    }
+
+    int column_offsets[_grid_width];
+    for (int x = 0; x < _grid_width; x++) {
+        const int column = static_cast<int>(x0 + (x + 0.5F) * box_width / _grid_width);
+        column_offsets[x] = 3 * std::min(column, frame.cols - 1);
+    }
+
+    // reciprocals[0] is 0, so that grey pixels get a zero hue and saturation
+    static const std::array<float, 256> reciprocals = []() {
+        std::array<float, 256> table{};
+        for (int i = 1; i < 256; i++) {
+            table[i] = 1.0F / static_cast<float>(i);
+        }
+        return table;
+    }();
+
+    // Consecutive samples go to 4 interleaved sub-histograms, so that increments of the same bin
+    // do not depend on each other, the sub-histograms are summed at the end
+    uint16_t counts[4][_num_stripes * _stripe_dim] = {};
+
+    for (int y = 0; y < _grid_height; y++) {
+        const int row = std::min(static_cast<int>(y0 + (y + 0.5F) * box_height / _grid_height), frame.rows - 1);
+        const uint8_t *pixels = frame.ptr<uint8_t>(row);
+        const int stripe_offset = (y * _num_stripes / _grid_height) * _stripe_dim;
+
+        for (int x = 0; x < _grid_width; x++) {
+            const uint8_t *pixel = pixels + column_offsets[x];
+            const int b = pixel[0], g = pixel[1], r = pixel[2];
+
+            // HSV with H in [0, 360), S and V in [0, 255], divisions are replaced by a reciprocal table
+            const int max = std::max(r, std::max(g, b));
+            const int delta = max - std::min(r, std::min(g, b));
+            const float inv_max = reciprocals[max], inv_delta = reciprocals[delta];
+            const int saturation = static_cast<int>(static_cast<float>(delta * 255) * inv_max);
+
+            const int numerator = max == r ? g - b : (max == g ? b - r : r - g);
+            const float offset = max == r ? 0.0F : (max == g ? 120.0F : 240.0F);
+            float hue = offset + 60.0F * static_cast<float>(numerator) * inv_delta;
+            hue += hue < 0.0F ? 360.0F : 0.0F;
+
+            const int hue_bin = std::min(static_cast<int>(hue * (_hue_bins / 360.0F)), _hue_bins - 1);
+            const int saturation_bin = saturation * _saturation_bins / 256;
+            const int value_bin = max * _value_bins / 256;
+
+            uint16_t *histogram = counts[x & 3] + stripe_offset;
+            histogram[hue_bin]++;
+            histogram[_hue_bins + saturation_bin]++;
+            histogram[_hue_bins + _saturation_bins + value_bin]++;
+        }
+    }
+
+    // Every stripe has the same number of samples, the square root (Hellinger kernel) makes
+    // the cosine distance between the histograms less dominated by the largest bins
+    Eigen::Map<FeatureVector> feature(embedding, dim);
+    for (int i = 0; i < dim; i++) {
+        feature(i) = std::sqrt(static_cast<float>(counts[0][i] + counts[1][i] + counts[2][i] + counts[3][i]));
+    }
+    feature.normalize();
+}
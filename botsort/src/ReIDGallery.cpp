@@ -0,0 +1,314 @@
+#include "ReIDGallery.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_set>
+
+
+ReIDGallery::ReIDGallery(int feature_dim,
+                         FeaturePrecision precision,
+                         size_t capacity,
+                         uint32_t ttl,
+                         int num_lists,
+                         int num_probes)
+    : _feature_dim(feature_dim),
+      _precision(precision),
+      _capacity(capacity),
+      _ttl(ttl),
+      _num_lists(std::max(1, num_lists)),
+      _num_probes(std::max(1, std::min(num_probes, num_lists))) {
+    _train_size = static_cast<size_t>(_num_lists) * _train_samples_per_list;
+    _lists.push_back({AppearanceStore(_feature_dim, _precision), {}, {}});
+}
+
+void ReIDGallery::insert(int track_id, const FeatureVector &feature, uint32_t frame_id) {
+    if (_capacity == 0) {
+        return;
+    }
+
+    expire(frame_id);
+    remove(track_id);
+
+    // Evict the oldest entries if the gallery is full
+    while (_entries.size() >= _capacity && !_insertion_order.empty()) {
+        auto [oldest_id, oldest_frame_id] = _insertion_order.front();
+        _insertion_order.pop_front();
+
+        auto entry = _entries.find(oldest_id);
+        if (entry != _entries.end() && entry->second.frame_id == oldest_frame_id) {
+            remove(oldest_id);
+        }
+    }
+
+    _add_to_list(track_id, feature, frame_id);
+    _insertion_order.emplace_back(track_id, frame_id);
+
+    if (_centroids.size() == 0 && _num_lists > 1 && _entries.size() >= _train_size) {
+        _train();
+    }
+}
+
+void ReIDGallery::remove(int track_id) {
+    auto entry = _entries.find(track_id);
+    if (entry == _entries.end()) {
+        return;
+    }
+
+    InvertedList &list = _lists[entry->second.list];
+    size_t position = entry->second.position;
+    list.features.release(list.slots[position]);
+
+    // Swap the last entry of the list into the removed position
+    if (position != list.slots.size() - 1) {
+        list.track_ids[position] = list.track_ids.back();
+        list.slots[position] = list.slots.back();
+        _entries[list.track_ids[position]].position = position;
+    }
+    list.track_ids.pop_back();
+    list.slots.pop_back();
+
+    _entries.erase(entry);
+}
+
+void ReIDGallery::expire(uint32_t frame_id) {
+    while (!_insertion_order.empty() && frame_id - _insertion_order.front().second > _ttl) {
+        auto [oldest_id, oldest_frame_id] = _insertion_order.front();
+        _insertion_order.pop_front();
+
+        auto entry = _entries.find(oldest_id);
+        if (entry != _entries.end() && entry->second.frame_id == oldest_frame_id) {
+            remove(oldest_id);
+        }
+    }
+}
+
+std::vector<std::optional<ReIDGallery::Match>> ReIDGallery::query(const FeatureMatrix &queries, float max_distance) const {
+    std::vector<std::optional<Match>> matches(queries.rows());
+    if (_entries.empty() || queries.rows() == 0) {
+        return matches;
+    }
+
+    // Group the queries by the inverted lists they probe, so that every list is scanned once
+    std::vector<std::vector<int>> probes = _probe_lists(queries);
+    std::vector<std::vector<Eigen::Index>> queries_per_list(_lists.size());
+    for (Eigen::Index q = 0; q < queries.rows(); q++) {
+        for (int list_idx: probes[q]) {
+            queries_per_list[list_idx].push_back(q);
+        }
+    }
+
+    std::vector<float> best_similarity(queries.rows(), -std::numeric_limits<float>::infinity());
+    std::vector<int> best_track_id(queries.rows(), -1);
+
+    FeatureMatrix list_queries;
+    for (size_t list_idx = 0; list_idx < _lists.size(); list_idx++) {
+        const InvertedList &list = _lists[list_idx];
+        const std::vector<Eigen::Index> &query_indices = queries_per_list[list_idx];
+        if (list.slots.empty() || query_indices.empty()) {
+            continue;
+        }
+
+        list_queries.resize(static_cast<Eigen::Index>(query_indices.size()), _feature_dim);
+        for (size_t i = 0; i < query_indices.size(); i++) {
+            list_queries.row(static_cast<Eigen::Index>(i)) = queries.row(query_indices[i]);
+        }
+
+        CostMatrix similarity = list.features.dot(list.slots, list_queries);
+        for (size_t i = 0; i < query_indices.size(); i++) {
+            Eigen::Index best_row;
+            float max_similarity = similarity.col(static_cast<Eigen::Index>(i)).maxCoeff(&best_row);
+
+            Eigen::Index q = query_indices[i];
+            if (max_similarity > best_similarity[q]) {
+                best_similarity[q] = max_similarity;
+                best_track_id[q] = list.track_ids[best_row];
+            }
+        }
+    }
+
+    for (Eigen::Index q = 0; q < queries.rows(); q++) {
+        float distance = 1.0F - best_similarity[q];
+        if (best_track_id[q] >= 0 && distance <= max_distance) {
+            matches[q] = Match{best_track_id[q], distance};
+        }
+    }
+
+    return matches;
+}
+
+std::vector<std::optional<int>> ReIDGallery::reidentify(const FeatureMatrix &queries, float max_distance) {
+    std::vector<std::optional<Match>> matches = query(queries, max_distance);
+
+    // Resolve conflicts greedily, the closest query gets the gallery entry
+    std::vector<size_t> order;
+    for (size_t q = 0; q < matches.size(); q++) {
+        if (matches[q]) {
+            order.push_back(q);
+        }
+    }
+    std::sort(order.begin(), order.end(), [&matches](size_t a, size_t b) {
+        return matches[a]->distance < matches[b]->distance;
+    });
+
+    std::vector<std::optional<int>> track_ids(matches.size());
+    std::unordered_set<int> assigned;
+    for (size_t q: order) {
+        int track_id = matches[q]->track_id;
+        if (assigned.insert(track_id).second) {
+            track_ids[q] = track_id;
+            remove(track_id);
+        }
+    }
+
+    return track_ids;
+}
+
+size_t ReIDGallery::size() const {
+    return _entries.size();
+}
+
+void ReIDGallery::save_state(SnapshotWriter &writer) const {
+    writer.write_matrix(_centroids);
+
+    writer.write(static_cast<uint64_t>(_lists.size()));
+    for (const InvertedList &list: _lists) {
+        writer.write(static_cast<uint64_t>(list.slots.size()));
+        for (size_t i = 0; i < list.slots.size(); i++) {
+            writer.write(static_cast<int32_t>(list.track_ids[i]));
+            writer.write(_entries.at(list.track_ids[i]).frame_id);
+            list.features.save_slot(list.slots[i], writer);
+        }
+    }
+
+    writer.write(static_cast<uint64_t>(_insertion_order.size()));
+    for (const std::pair<int, uint32_t> &insertion: _insertion_order) {
+        writer.write(static_cast<int32_t>(insertion.first));
+        writer.write(insertion.second);
+    }
+}
+
+void ReIDGallery::load_state(SnapshotReader &reader) {
+    reader.read_matrix(_centroids);
+    if (_centroids.size() > 0 && _centroids.cols() != _feature_dim) {
+        throw std::runtime_error("Malformed tracker snapshot: gallery feature dimension mismatch");
+    }
+
+    // Entries go back to the same inverted lists, the index is not retrained
+    _lists.clear();
+    _entries.clear();
+    // Each list has at least its entry count
+    _lists.resize(reader.read_count(sizeof(uint64_t)), {AppearanceStore(_feature_dim, _precision), {}, {}});
+    if (_lists.empty()) {
+        throw std::runtime_error("Malformed tracker snapshot: gallery without inverted lists");
+    }
+    for (size_t list_idx = 0; list_idx < _lists.size(); list_idx++) {
+        InvertedList &list = _lists[list_idx];
+        auto num_entries = reader.read<uint64_t>();
+        for (uint64_t i = 0; i < num_entries; i++) {
+            int track_id = reader.read<int32_t>();
+            auto frame_id = reader.read<uint32_t>();
+
+            AppearanceStore::Slot slot = list.features.allocate();
+            list.features.load_slot(slot, reader);
+            list.track_ids.push_back(track_id);
+            list.slots.push_back(slot);
+            _entries[track_id] = {static_cast<int>(list_idx), list.slots.size() - 1, frame_id};
+        }
+    }
+
+    _insertion_order.clear();
+    auto num_insertions = reader.read<uint64_t>();
+    for (uint64_t i = 0; i < num_insertions; i++) {
+        int track_id = reader.read<int32_t>();
+        _insertion_order.emplace_back(track_id, reader.read<uint32_t>());
+    }
+}
+
+void ReIDGallery::_add_to_list(int track_id, const FeatureVector &feature, uint32_t frame_id) {
+    int list_idx = 0;
+    if (_centroids.size() > 0) {
+        (_centroids * feature.transpose()).maxCoeff(&list_idx);
+    }
+
+    InvertedList &list = _lists[list_idx];
+    AppearanceStore::Slot slot = list.features.allocate();
+    list.features.store(slot, feature);
+    list.track_ids.push_back(track_id);
+    list.slots.push_back(slot);
+
+    _entries[track_id] = {list_idx, list.slots.size() - 1, frame_id};
+}
+
+void ReIDGallery::_train() {
+    // Gather all the entries
+    const auto num_samples = static_cast<Eigen::Index>(_entries.size());
+    FeatureMatrix samples(num_samples, _feature_dim);
+    std::vector<std::pair<int, uint32_t>> sample_info;
+    sample_info.reserve(num_samples);
+
+    for (const InvertedList &list: _lists) {
+        for (size_t i = 0; i < list.slots.size(); i++) {
+            samples.row(static_cast<Eigen::Index>(sample_info.size())) = list.features.load(list.slots[i]);
+            sample_info.emplace_back(list.track_ids[i], _entries[list.track_ids[i]].frame_id);
+        }
+    }
+
+    // Spherical k-means, centroids are initialized with evenly spaced samples
+    _centroids.resize(_num_lists, _feature_dim);
+    for (int k = 0; k < _num_lists; k++) {
+        _centroids.row(k) = samples.row(k * num_samples / _num_lists);
+    }
+
+    std::vector<int> assignment(num_samples, 0);
+    for (int iter = 0; iter < _kmeans_iterations; iter++) {
+        CostMatrix similarity = samples * _centroids.transpose();
+        for (Eigen::Index i = 0; i < num_samples; i++) {
+            similarity.row(i).maxCoeff(&assignment[i]);
+        }
+
+        FeatureMatrix sums = FeatureMatrix::Zero(_num_lists, _feature_dim);
+        std::vector<int> counts(_num_lists, 0);
+        for (Eigen::Index i = 0; i < num_samples; i++) {
+            sums.row(assignment[i]) += samples.row(i);
+            counts[assignment[i]]++;
+        }
+        for (int k = 0; k < _num_lists; k++) {
+            // Keep the previous centroid if the cluster is empty
+            if (counts[k] > 0) {
+                _centroids.row(k) = sums.row(k).normalized();
+            }
+        }
+    }
+
+    // Re-assign all the entries to the inverted lists
+    _lists.clear();
+    _entries.clear();
+    for (int k = 0; k < _num_lists; k++) {
+        _lists.push_back({AppearanceStore(_feature_dim, _precision), {}, {}});
+    }
+    for (Eigen::Index i = 0; i < num_samples; i++) {
+        _add_to_list(sample_info[i].first, samples.row(i), sample_info[i].second);
+    }
+}
+
+std::vector<std::vector<int>> ReIDGallery::_probe_lists(const FeatureMatrix &queries) const {
+    std::vector<std::vector<int>> probes(queries.rows());
+    if (_centroids.size() == 0) {
+        for (std::vector<int> &probe: probes) {
+            probe.push_back(0);
+        }
+        return probes;
+    }
+
+    CostMatrix similarity = queries * _centroids.transpose();
+    std::vector<int> list_indices(_num_lists);
+    for (Eigen::Index q = 0; q < queries.rows(); q++) {
+        std::iota(list_indices.begin(), list_indices.end(), 0);
+        std::partial_sort(list_indices.begin(), list_indices.begin() + _num_probes, list_indices.end(),
+                          [&similarity, q](int a, int b) { return similarity(q, a) > similarity(q, b); });
+        probes[q].assign(list_indices.begin(), list_indices.begin() + _num_probes);
+    }
+
+    return probes;
+}
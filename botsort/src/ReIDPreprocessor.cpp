@@ -0,0 +1,171 @@
+#include "ReIDPreprocessor.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+ReIDPreprocessor::ReIDPreprocessor(cv::Size input_size, bool fp16_output, const cv::Scalar &mean, const cv::Scalar &std)
+    : _input_size(input_size),
+      _fp16_output(fp16_output) {
+    for (int c = 0; c < 3; c++) {
+        _alpha[c] = static_cast<float>(1.0 / (255.0 * std[c]));
+        _beta[c] = static_cast<float>(-mean[c] / std[c]);
+    }
+}
+
+void ReIDPreprocessor::run(const cv::Mat &frame, const std::vector<cv::Rect_<float>> &bboxes) {
+    CV_Assert(frame.type() == CV_8UC3);
+
+    _batch_size = static_cast<int>(bboxes.size());
+    const size_t patch_bytes = _patch_bytes();
+    if (_tensor.size() < _batch_size * patch_bytes) {
+        _tensor.resize(_batch_size * patch_bytes);
+    }
+
+    cv::parallel_for_(cv::Range(0, _batch_size), [&](const cv::Range &range) {
+        // Scratch buffers are shared by all the patches of this range
+        std::vector<int> x_offsets;
+        std::vector<float> x_weights;
+        std::vector<float> row;
+        for (int i = range.start; i < range.end; i++) {
+            _process_patch(frame, bboxes[i], _tensor.data() + i * patch_bytes, x_offsets, x_weights, row);
+        }
+    });
+}
+
+const void *ReIDPreprocessor::tensor() const {
+    return _tensor.data();
+}
+
+size_t ReIDPreprocessor::tensor_bytes() const {
+    return _batch_size * _patch_bytes();
+}
+
+int ReIDPreprocessor::batch_size() const {
+    return _batch_size;
+}
+
+cv::Size ReIDPreprocessor::input_size() const {
+    return _input_size;
+}
+
+size_t ReIDPreprocessor::_patch_bytes() const {
+    return static_cast<size_t>(3 * _input_size.area()) * (_fp16_output ? sizeof(uint16_t) : sizeof(float));
+}
+
+void ReIDPreprocessor::_process_patch(const cv::Mat &frame,
+                                      const cv::Rect_<float> &bbox,
+                                      uint8_t *patch,
+                                      std::vector<int> &x_offsets,
+                                      std::vector<float> &x_weights,
+                                      std::vector<float> &row) const {
+    const int width = _input_size.width, height = _input_size.height;
+    const size_t element_bytes = _fp16_output ? sizeof(uint16_t) : sizeof(float);
+    const size_t row_bytes = width * element_bytes;
+    const size_t plane_bytes = height * row_bytes;
+
+    // Clip the bounding box to the frame
+    const float x0 = std::max(0.0F, bbox.x), y0 = std::max(0.0F, bbox.y);
+    const float box_width = std::min(static_cast<float>(frame.cols), bbox.x + bbox.width) - x0;
+    const float box_height = std::min(static_cast<float>(frame.rows), bbox.y + bbox.height) - y0;
+    if (box_width < 1.0F || box_height < 1.0F) {
+        // Zero is the normalized mean color, both in float and half precision
+        std::memset(patch, 0, 3 * plane_bytes);
+        return;
+    }
+
+    // Letterbox, keep the aspect ratio and center the resized box in the patch
+    const float scale = std::min(width / box_width, height / box_height);
+    const int resized_width = std::clamp(static_cast<int>(std::round(box_width * scale)), 1, width);
+    const int resized_height = std::clamp(static_cast<int>(std::round(box_height * scale)), 1, height);
+    const int pad_x = (width - resized_width) / 2, pad_y = (height - resized_height) / 2;
+    const float scale_x = box_width / static_cast<float>(resized_width);
+    const float scale_y = box_height / static_cast<float>(resized_height);
+
+    // Horizontal sampling table, byte offsets of the two neighbouring pixels and the interpolation weight
+    x_offsets.resize(2 * resized_width);
+    x_weights.resize(resized_width);
+    for (int x = 0; x < resized_width; x++) {
+        const float src_x = std::clamp(x0 + (x + 0.5F) * scale_x - 0.5F, 0.0F, static_cast<float>(frame.cols - 1));
+        const int left = static_cast<int>(src_x);
+        x_offsets[2 * x] = 3 * left;
+        x_offsets[2 * x + 1] = 3 * std::min(left + 1, frame.cols - 1);
+        x_weights[x] = src_x - static_cast<float>(left);
+    }
+
+    // Horizontally resampled and normalized source rows (RGB planes), cached as consecutive
+    // output rows mostly sample the same two source rows
+    const int cached_stride = 3 * resized_width;
+    row.resize(2 * cached_stride + 3 * width);
+    float *cached_rows[2] = {row.data(), row.data() + cached_stride};
+    int cached_y[2] = {-1, -1};
+
+    // One output row for the 3 channels, the padding columns stay zero
+    float *output_row = row.data() + 2 * cached_stride;
+    std::fill(output_row, output_row + 3 * width, 0.0F);
+
+    auto resample_row = [&](int src_y, float *dst) {
+        const uint8_t *src = frame.ptr<uint8_t>(src_y);
+        float *red = dst, *green = dst + resized_width, *blue = dst + 2 * resized_width;
+        for (int x = 0; x < resized_width; x++) {
+            const int left = x_offsets[2 * x], right = x_offsets[2 * x + 1];
+            const float weight_x = x_weights[x];
+
+            // BGR to RGB
+            const float b = src[left] + (src[right] - src[left]) * weight_x;
+            const float g = src[left + 1] + (src[right + 1] - src[left + 1]) * weight_x;
+            const float r = src[left + 2] + (src[right + 2] - src[left + 2]) * weight_x;
+            red[x] = r * _alpha[0] + _beta[0];
+            green[x] = g * _alpha[1] + _beta[1];
+            blue[x] = b * _alpha[2] + _beta[2];
+        }
+    };
+
+    for (int y = 0; y < height; y++) {
+        if (y < pad_y || y >= pad_y + resized_height) {
+            for (int c = 0; c < 3; c++) {
+                std::memset(patch + c * plane_bytes + y * row_bytes, 0, row_bytes);
+            }
+            continue;
+        }
+
+        const float src_y = std::clamp(y0 + (y - pad_y + 0.5F) * scale_y - 0.5F, 0.0F, static_cast<float>(frame.rows - 1));
+        const int top = static_cast<int>(src_y), bottom = std::min(top + 1, frame.rows - 1);
+        const float weight_y = src_y - static_cast<float>(top);
+
+        if (cached_y[0] != top) {
+            if (cached_y[1] == top) {
+                std::swap(cached_rows[0], cached_rows[1]);
+                std::swap(cached_y[0], cached_y[1]);
+            } else {
+                resample_row(top, cached_rows[0]);
+                cached_y[0] = top;
+            }
+        }
+        if (cached_y[1] != bottom) {
+            resample_row(bottom, cached_rows[1]);
+            cached_y[1] = bottom;
+        }
+
+        // Normalization is affine, so the vertical interpolation of normalized rows gives the normalized output
+        for (int c = 0; c < 3; c++) {
+            const float *upper = cached_rows[0] + c * resized_width;
+            const float *lower = cached_rows[1] + c * resized_width;
+            float *out = output_row + c * width + pad_x;
+            for (int x = 0; x < resized_width; x++) {
+                out[x] = upper[x] + (lower[x] - upper[x]) * weight_y;
+            }
+        }
+
+        for (int c = 0; c < 3; c++) {
+            uint8_t *dst = patch + c * plane_bytes + y * row_bytes;
+            if (_fp16_output) {
+                floats_to_halfs(output_row + c * width, reinterpret_cast<uint16_t *>(dst), width);
+            } else {
+                std::memcpy(dst, output_row + c * width, row_bytes);
+            }
+        }
+    }
+}
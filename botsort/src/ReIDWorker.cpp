@@ -0,0 +1,50 @@
+#include "ReIDWorker.h"
+
+
+ReIDWorker::ReIDWorker(ReIDModel &reid_model)
+    : _reid_model(reid_model),
+      _thread(&ReIDWorker::_run, this) {
+}
+
+ReIDWorker::~ReIDWorker() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _job_available.notify_one();
+    _thread.join();
+}
+
+std::future<FeatureMatrix> ReIDWorker::submit(const cv::Mat &frame, std::vector<cv::Rect_<float>> bboxes) {
+    Job job{frame.clone(), std::move(bboxes), std::promise<FeatureMatrix>()};
+    std::future<FeatureMatrix> features = job.features.get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _jobs.push_back(std::move(job));
+    }
+    _job_available.notify_one();
+
+    return features;
+}
+
+void ReIDWorker::_run() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _job_available.wait(lock, [this]() { return _stop || !_jobs.empty(); });
+            if (_jobs.empty()) {
+                return;
+            }
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+        }
+
+        try {
+            job.features.set_value(_reid_model.extract_features(job.frame, job.bboxes));
+        } catch (...) {
+            job.features.set_exception(std::current_exception());
+        }
+    }
+}
@@ -0,0 +1,267 @@
+#include "SharedFrameRing.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace {
+constexpr size_t PAGE_BYTES = 4096;
+
+inline size_t round_up(size_t bytes, size_t alignment) {
+    return (bytes + alignment - 1) / alignment * alignment;
+}
+
+inline bool process_exited(int32_t pid) {
+    return pid > 0 && kill(pid, 0) < 0 && errno == ESRCH;
+}
+
+/**
+ * @brief Whether the layout of a ring header fits in the mapped segment, the consumer trusts it to address the frames
+ */
+bool valid_layout(const shared_frame_ring::RingHeader &header, size_t mapping_bytes) {
+    if (header.num_slots == 0 || header.width <= 0 || header.height <= 0 || header.type < 0 || header.type > CV_MAT_TYPE_MASK) {
+        return false;
+    }
+    const uint64_t min_step = static_cast<uint64_t>(header.width) * CV_ELEM_SIZE(header.type);
+    const uint64_t slots_end = sizeof(shared_frame_ring::RingHeader) + uint64_t(header.num_slots) * sizeof(shared_frame_ring::SlotInfo);
+    if (header.step < min_step || header.data_offset < slots_end || header.data_offset > mapping_bytes ||
+        header.step > header.slot_bytes / static_cast<uint64_t>(header.height)) {
+        return false;
+    }
+    // Written as a division, num_slots * slot_bytes could overflow
+    return header.slot_bytes <= (mapping_bytes - header.data_offset) / header.num_slots;
+}
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+}// namespace
+
+
+SharedFrameRing::SharedFrameRing(std::string name) : _name(std::move(name)) {
+}
+
+SharedFrameRing::~SharedFrameRing() {
+    if (_mapping) {
+        munmap(_mapping, _mapping_bytes);
+    }
+}
+
+cv::Size SharedFrameRing::frame_size() const {
+    return {_header->width, _header->height};
+}
+
+size_t SharedFrameRing::num_slots() const {
+    return _header->num_slots;
+}
+
+void SharedFrameRing::_map(int fd, size_t bytes) {
+    _mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (_mapping == MAP_FAILED) {
+        _mapping = nullptr;
+        throw std::runtime_error("Can't map shared frame ring " + _name + ": " + std::strerror(errno));
+    }
+    _mapping_bytes = bytes;
+    _header = static_cast<shared_frame_ring::RingHeader *>(_mapping);
+    _slots = reinterpret_cast<shared_frame_ring::SlotInfo *>(static_cast<char *>(_mapping) + sizeof(shared_frame_ring::RingHeader));
+}
+
+cv::Mat SharedFrameRing::_slot_frame(uint64_t frame_index) const {
+    char *data = static_cast<char *>(_mapping) + _header->data_offset + (frame_index % _header->num_slots) * _header->slot_bytes;
+    return {_header->height, _header->width, _header->type, data, static_cast<size_t>(_header->step)};
+}
+
+template<typename Condition>
+bool SharedFrameRing::_wait(Condition condition, const std::atomic<int32_t> &peer_pid) const {
+    // Frames arrive at most every few milliseconds: spin briefly for low latency, then sleep to leave the core
+    auto next_liveness_check = std::chrono::steady_clock::now();
+    for (int i = 0; !condition(); i++) {
+        if (_header->closed.load(std::memory_order_acquire) && !condition()) {
+            return false;
+        }
+        if (i < 1000) {
+            cpu_relax();
+            continue;
+        }
+
+        // A peer that crashed would never update the counters
+        if (std::chrono::steady_clock::now() >= next_liveness_check) {
+            if (process_exited(peer_pid.load(std::memory_order_relaxed)) && !condition()) {
+                throw std::runtime_error("Shared frame ring " + _name + ": the other process has exited");
+            }
+            next_liveness_check += std::chrono::milliseconds(100);
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    return true;
+}
+
+
+SharedFrameProducer::SharedFrameProducer(const std::string &name, cv::Size frame_size, int type, size_t num_slots)
+    : SharedFrameRing(name) {
+    if (frame_size.empty() || num_slots == 0) {
+        throw std::runtime_error("Invalid shared frame ring " + name);
+    }
+
+    const size_t step = static_cast<size_t>(frame_size.width) * CV_ELEM_SIZE(type);
+    const size_t slot_bytes = round_up(step * static_cast<size_t>(frame_size.height), PAGE_BYTES);
+    const size_t data_offset = round_up(sizeof(shared_frame_ring::RingHeader) + num_slots * sizeof(shared_frame_ring::SlotInfo), PAGE_BYTES);
+    const size_t bytes = data_offset + num_slots * slot_bytes;
+
+    shm_unlink(_name.c_str());
+    int fd = shm_open(_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("Can't create shared frame ring " + _name + ": " + std::strerror(errno));
+    }
+    if (ftruncate(fd, static_cast<off_t>(bytes)) < 0) {
+        ::close(fd);
+        shm_unlink(_name.c_str());
+        throw std::runtime_error("Can't allocate shared frame ring " + _name + ": " + std::strerror(errno));
+    }
+    try {
+        _map(fd, bytes);
+    } catch (...) {
+        ::close(fd);
+        shm_unlink(_name.c_str());
+        throw;
+    }
+    ::close(fd);
+
+    // The object is zero-filled by ftruncate, the header is published to the consumer by the magic number
+    _header = new (_mapping) shared_frame_ring::RingHeader();
+    _header->version = shared_frame_ring::VERSION;
+    _header->num_slots = static_cast<uint32_t>(num_slots);
+    _header->width = frame_size.width;
+    _header->height = frame_size.height;
+    _header->type = type;
+    _header->step = step;
+    _header->slot_bytes = slot_bytes;
+    _header->data_offset = data_offset;
+    _header->write_count.store(0, std::memory_order_relaxed);
+    _header->read_count.store(0, std::memory_order_relaxed);
+    _header->closed.store(0, std::memory_order_relaxed);
+    _header->producer_pid.store(static_cast<int32_t>(getpid()), std::memory_order_relaxed);
+    _header->consumer_pid.store(0, std::memory_order_relaxed);
+    _header->magic.store(shared_frame_ring::MAGIC, std::memory_order_release);
+}
+
+SharedFrameProducer::~SharedFrameProducer() {
+    close();
+    shm_unlink(_name.c_str());
+}
+
+cv::Mat SharedFrameProducer::acquire() {
+    if (_acquired) {
+        throw std::runtime_error("Shared frame ring " + _name + ": the acquired frame was not published");
+    }
+
+    // The slot is free once the consumer has released the frame num_slots frames back
+    const uint64_t num_slots = _header->num_slots;
+    _wait([this, num_slots]() { return _write_count - _header->read_count.load(std::memory_order_acquire) < num_slots; },
+          _header->consumer_pid);
+    _acquired = true;
+    return _slot_frame(_write_count);
+}
+
+void SharedFrameProducer::publish(uint32_t frame_id, double timestamp) {
+    if (!_acquired) {
+        throw std::runtime_error("Shared frame ring " + _name + ": no frame acquired");
+    }
+
+    _slots[_write_count % _header->num_slots] = {frame_id, timestamp};
+    _acquired = false;
+    _header->write_count.store(++_write_count, std::memory_order_release);
+}
+
+void SharedFrameProducer::close() {
+    _header->closed.store(1, std::memory_order_release);
+}
+
+
+SharedFrameConsumer::SharedFrameConsumer(const std::string &name, int timeout_ms)
+    : SharedFrameRing(name) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+    // The ring is usable once the producer has sized it and written its header
+    while (true) {
+        int fd = shm_open(_name.c_str(), O_RDWR, 0600);
+        if (fd >= 0) {
+            struct stat st {};
+            if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= PAGE_BYTES) {
+                try {
+                    _map(fd, static_cast<size_t>(st.st_size));
+                } catch (...) {
+                    ::close(fd);
+                    throw;
+                }
+                ::close(fd);
+
+                if (_header->magic.load(std::memory_order_acquire) == shared_frame_ring::MAGIC) {
+                    break;
+                }
+                munmap(_mapping, _mapping_bytes);
+                _mapping = nullptr;
+            } else {
+                ::close(fd);
+            }
+        }
+
+        if (std::chrono::steady_clock::now() > deadline) {
+            throw std::runtime_error("Timed out waiting for shared frame ring " + _name);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    if (_header->version != shared_frame_ring::VERSION) {
+        throw std::runtime_error("Unsupported shared frame ring version: " + std::to_string(_header->version));
+    }
+    if (!valid_layout(*_header, _mapping_bytes)) {
+        throw std::runtime_error("Corrupted shared frame ring " + _name + ": the frames do not fit in the " +
+                                 std::to_string(_mapping_bytes) + " bytes of the segment");
+    }
+    _read_count = _header->read_count.load(std::memory_order_acquire);
+    _header->consumer_pid.store(static_cast<int32_t>(getpid()), std::memory_order_relaxed);
+}
+
+bool SharedFrameConsumer::acquire(cv::Mat &frame, uint32_t *frame_id, double *timestamp) {
+    if (_acquired) {
+        throw std::runtime_error("Shared frame ring " + _name + ": the acquired frame was not released");
+    }
+
+    if (!_wait([this]() { return _header->write_count.load(std::memory_order_acquire) > _read_count; },
+               _header->producer_pid)) {
+        return false;
+    }
+
+    const shared_frame_ring::SlotInfo &info = _slots[_read_count % _header->num_slots];
+    if (frame_id) {
+        *frame_id = info.frame_id;
+    }
+    if (timestamp) {
+        *timestamp = info.timestamp;
+    }
+
+    frame = _slot_frame(_read_count);
+    _acquired = true;
+    return true;
+}
+
+void SharedFrameConsumer::release() {
+    if (_acquired) {
+        _acquired = false;
+        _header->read_count.store(++_read_count, std::memory_order_release);
+    }
+}
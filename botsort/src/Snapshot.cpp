@@ -0,0 +1,41 @@
+#include "Snapshot.h"
+
+
+void SnapshotWriter::write_mat(const cv::Mat &mat) {
+    write(static_cast<int32_t>(mat.rows));
+    write(static_cast<int32_t>(mat.cols));
+    write(static_cast<int32_t>(mat.type()));
+
+    const size_t row_bytes = static_cast<size_t>(mat.cols) * mat.elemSize();
+    if (mat.isContinuous()) {
+        write_bytes(mat.data, row_bytes * static_cast<size_t>(mat.rows));
+        return;
+    }
+    for (int y = 0; y < mat.rows; y++) {
+        write_bytes(mat.ptr<uchar>(y), row_bytes);
+    }
+}
+
+void SnapshotReader::read_mat(cv::Mat &mat) {
+    auto rows = read<int32_t>(), cols = read<int32_t>(), type = read<int32_t>();
+    if (rows < 0 || cols < 0) {
+        throw std::runtime_error("Malformed tracker snapshot: unexpected image dimensions");
+    }
+    if (type < 0 || type > CV_MAT_TYPE_MASK) {
+        throw std::runtime_error("Malformed tracker snapshot: unknown image type " + std::to_string(type));
+    }
+    if (rows == 0 || cols == 0) {
+        mat.release();
+        return;
+    }
+
+    const size_t row_bytes = static_cast<size_t>(cols) * CV_ELEM_SIZE(type);
+    if (row_bytes == 0 || static_cast<size_t>(rows) > static_cast<size_t>(_end - _pos) / row_bytes) {
+        throw std::runtime_error("Truncated tracker snapshot");
+    }
+
+    mat.create(rows, cols, type);
+    for (int y = 0; y < rows; y++) {
+        read_bytes(mat.ptr<uchar>(y), row_bytes);
+    }
+}
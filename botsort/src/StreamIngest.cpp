@@ -0,0 +1,128 @@
+#include "StreamIngest.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+#include <unistd.h>
+
+
+StreamIngest::StreamIngest(int input_fd, int output_fd, size_t max_queued_frames)
+    : _input_fd(input_fd),
+      _output_fd(output_fd),
+      _max_queued_frames(std::max<size_t>(max_queued_frames, 1)) {
+    if (pipe(_stop_pipe) < 0) {
+        throw std::runtime_error("Can't create the stop pipe of the stream reader");
+    }
+    _reader = std::thread(&StreamIngest::_read_loop, this);
+    _writer = std::thread(&StreamIngest::_write_loop, this);
+}
+
+StreamIngest::~StreamIngest() {
+    {
+        std::lock_guard<std::mutex> lock(_output_mutex);
+        _output_done = true;
+    }
+    _output_ready.notify_one();
+    _writer.join();
+
+    // Wake the reader thread whether it is blocked on a full queue or on the input stream (the client may keep it open)
+    {
+        std::lock_guard<std::mutex> lock(_input_mutex);
+        _max_queued_frames = SIZE_MAX;
+    }
+    _frame_free.notify_one();
+    const char stop = 0;
+    [[maybe_unused]] ssize_t written = write(_stop_pipe[1], &stop, 1);
+    _reader.join();
+
+    close(_stop_pipe[0]);
+    close(_stop_pipe[1]);
+}
+
+bool StreamIngest::receive(stream_protocol::FrameMessage &frame) {
+    std::unique_lock<std::mutex> lock(_input_mutex);
+    _frame_ready.wait(lock, [this]() { return !_frames.empty() || _input_done; });
+    if (_frames.empty()) {
+        if (_input_error) {
+            std::rethrow_exception(_input_error);
+        }
+        return false;
+    }
+
+    std::swap(frame, _frames.front());
+    _spare_frames.push_back(std::move(_frames.front()));
+    _frames.pop_front();
+    lock.unlock();
+
+    _frame_free.notify_one();
+    return true;
+}
+
+void StreamIngest::send(uint32_t frame_id, double timestamp, const std::vector<std::shared_ptr<Track>> &tracks) {
+    {
+        std::lock_guard<std::mutex> lock(_output_mutex);
+        if (_output_error) {
+            std::rethrow_exception(_output_error);
+        }
+        stream_protocol::encode_tracks(_pending_output, frame_id, timestamp, tracks);
+    }
+    _output_ready.notify_one();
+}
+
+void StreamIngest::_read_loop() {
+    stream_protocol::MessageReader reader(_input_fd, 1 << 16, _stop_pipe[0]);
+    stream_protocol::FrameMessage frame;
+    std::string_view payload;
+
+    try {
+        while (reader.next(payload)) {
+            stream_protocol::decode_frame(payload, frame);
+
+            std::unique_lock<std::mutex> lock(_input_mutex);
+            _frame_free.wait(lock, [this]() { return _frames.size() < _max_queued_frames; });
+            _frames.push_back(std::move(frame));
+            if (!_spare_frames.empty()) {
+                frame = std::move(_spare_frames.back());
+                _spare_frames.pop_back();
+            }
+            lock.unlock();
+            _frame_ready.notify_one();
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(_input_mutex);
+        _input_error = std::current_exception();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_input_mutex);
+        _input_done = true;
+    }
+    _frame_ready.notify_one();
+}
+
+void StreamIngest::_write_loop() {
+    std::string output;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(_output_mutex);
+            _output_ready.wait(lock, [this]() { return !_pending_output.empty() || _output_done; });
+            if (_pending_output.empty()) {
+                return;
+            }
+            // Take all the messages queued while the previous ones were being written
+            std::swap(output, _pending_output);
+        }
+
+        try {
+            stream_protocol::write_all(_output_fd, output.data(), output.size());
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(_output_mutex);
+            _output_error = std::current_exception();
+            return;
+        }
+        output.clear();
+    }
+}
@@ -0,0 +1,243 @@
+#include "StreamProtocol.h"
+
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+namespace stream_protocol {
+namespace {
+template<typename T>
+inline void append(std::string &out, const T &value) {
+    out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+sockaddr_un unix_socket_address(const std::string &path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Socket path too long: " + path);
+    }
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    return address;
+}
+}// namespace
+
+
+void encode_frame(std::string &out, uint32_t frame_id, double timestamp, cv::Size image_size, const Detection *detections, size_t num_detections) {
+    const auto payload_bytes = static_cast<uint32_t>(sizeof(FrameHeader) + num_detections * sizeof(PackedDetection));
+    out.reserve(out.size() + sizeof(uint32_t) + payload_bytes);
+
+    append(out, payload_bytes);
+    append(out, FrameHeader{frame_id, static_cast<uint32_t>(num_detections), static_cast<uint32_t>(image_size.width),
+                            static_cast<uint32_t>(image_size.height), timestamp});
+    for (size_t i = 0; i < num_detections; i++) {
+        const Detection &det = detections[i];
+        append(out, PackedDetection{det.bbox_tlwh.x, det.bbox_tlwh.y, det.bbox_tlwh.width, det.bbox_tlwh.height,
+                                    det.confidence, det.class_id});
+    }
+}
+
+void decode_frame(std::string_view payload, FrameMessage &message) {
+    FrameHeader header{};
+    if (payload.size() < sizeof(header)) {
+        throw std::runtime_error("Malformed frame message");
+    }
+    std::memcpy(&header, payload.data(), sizeof(header));
+    if (payload.size() != sizeof(header) + static_cast<size_t>(header.num_detections) * sizeof(PackedDetection)) {
+        throw std::runtime_error("Malformed frame message: frame " + std::to_string(header.frame_id));
+    }
+    // The size is given to the tracker as a cv::Size, which holds ints
+    const auto max_size = static_cast<uint32_t>(std::numeric_limits<int>::max());
+    if (header.image_width == 0 || header.image_height == 0 || header.image_width > max_size || header.image_height > max_size) {
+        throw std::runtime_error("Malformed frame message: frame " + std::to_string(header.frame_id) + " has an invalid image size " +
+                                 std::to_string(header.image_width) + "x" + std::to_string(header.image_height));
+    }
+
+    message.frame_id = header.frame_id;
+    message.timestamp = header.timestamp;
+    message.image_size = cv::Size(static_cast<int>(header.image_width), static_cast<int>(header.image_height));
+    message.detections.resize(header.num_detections);
+
+    const char *p = payload.data() + sizeof(header);
+    for (Detection &det: message.detections) {
+        PackedDetection packed{};
+        std::memcpy(&packed, p, sizeof(packed));
+        p += sizeof(packed);
+
+        det.bbox_tlwh = cv::Rect_<float>(packed.x, packed.y, packed.width, packed.height);
+        det.confidence = packed.confidence;
+        det.class_id = packed.class_id;
+    }
+}
+
+void encode_tracks(std::string &out, uint32_t frame_id, double timestamp, const std::vector<std::shared_ptr<Track>> &tracks) {
+    const auto payload_bytes = static_cast<uint32_t>(sizeof(TrackHeader) + tracks.size() * sizeof(PackedTrack));
+    out.reserve(out.size() + sizeof(uint32_t) + payload_bytes);
+
+    append(out, payload_bytes);
+    append(out, TrackHeader{frame_id, static_cast<uint32_t>(tracks.size()), timestamp});
+    for (const std::shared_ptr<Track> &track: tracks) {
+        std::vector<float> tlwh = track->get_tlwh();
+        append(out, PackedTrack{track->track_id, tlwh[0], tlwh[1], tlwh[2], tlwh[3], track->get_score(),
+                                track->get_class_id(), static_cast<uint8_t>(track->state), {0, 0}});
+    }
+}
+
+const char *decode_tracks(std::string_view payload, TrackHeader &header) {
+    if (payload.size() < sizeof(header)) {
+        throw std::runtime_error("Malformed track message");
+    }
+    std::memcpy(&header, payload.data(), sizeof(header));
+    if (payload.size() != sizeof(header) + static_cast<size_t>(header.num_tracks) * sizeof(PackedTrack)) {
+        throw std::runtime_error("Malformed track message: frame " + std::to_string(header.frame_id));
+    }
+    return payload.data() + sizeof(header);
+}
+
+void write_all(int fd, const char *data, size_t size) {
+    while (size > 0) {
+        // MSG_NOSIGNAL keeps a client disconnecting from killing the process, FIFOs and stdout fall back to write()
+        ssize_t written = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (written < 0 && errno == ENOTSOCK) {
+            written = ::write(fd, data, size);
+        }
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EPIPE) {
+                throw std::runtime_error("Stream write failed: the reader has closed the stream");
+            }
+            throw std::runtime_error(std::string("Stream write failed: ") + std::strerror(errno));
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+int accept_unix_socket(const std::string &path) {
+    sockaddr_un address = unix_socket_address(path);
+    int server_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server_fd < 0) {
+        throw std::runtime_error("Can't create socket " + path);
+    }
+
+    unlink(path.c_str());
+    if (bind(server_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 || listen(server_fd, 1) < 0) {
+        close(server_fd);
+        throw std::runtime_error("Can't listen on socket " + path);
+    }
+
+    int fd = accept(server_fd, nullptr, nullptr);
+    close(server_fd);
+    unlink(path.c_str());
+    if (fd < 0) {
+        throw std::runtime_error("Can't accept a connection on socket " + path);
+    }
+    return fd;
+}
+
+int connect_unix_socket(const std::string &path) {
+    sockaddr_un address = unix_socket_address(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        throw std::runtime_error("Can't connect to socket " + path);
+    }
+    return fd;
+}
+
+
+MessageReader::MessageReader(int fd, size_t chunk_size, int stop_fd)
+    : _fd(fd),
+      _stop_fd(stop_fd),
+      _buffer(chunk_size) {
+}
+
+bool MessageReader::next(std::string_view &payload) {
+    while (true) {
+        const size_t available = _end - _begin;
+        if (available >= sizeof(uint32_t)) {
+            uint32_t payload_bytes;
+            std::memcpy(&payload_bytes, _buffer.data() + _begin, sizeof(payload_bytes));
+            if (payload_bytes > MAX_MESSAGE_BYTES) {
+                throw std::runtime_error("Stream message too large: " + std::to_string(payload_bytes) + " bytes");
+            }
+
+            const size_t message_bytes = sizeof(uint32_t) + payload_bytes;
+            if (available >= message_bytes) {
+                payload = std::string_view(_buffer.data() + _begin + sizeof(uint32_t), payload_bytes);
+                _begin += message_bytes;
+                return true;
+            }
+            if (message_bytes > _buffer.size()) {
+                _buffer.resize(message_bytes);
+            }
+        }
+
+        if (!_fill()) {
+            if (_end != _begin) {
+                throw std::runtime_error("Stream ended in the middle of a message");
+            }
+            return false;
+        }
+    }
+}
+
+bool MessageReader::_fill() {
+    if (_eof) {
+        return false;
+    }
+
+    // Move the partial message to the front, the previous payloads are no longer referenced
+    if (_begin > 0) {
+        std::memmove(_buffer.data(), _buffer.data() + _begin, _end - _begin);
+        _end -= _begin;
+        _begin = 0;
+    }
+    if (_end == _buffer.size()) {
+        _buffer.resize(_buffer.size() * 2);
+    }
+
+    while (_stop_fd >= 0) {
+        pollfd fds[2] = {{_fd, POLLIN, 0}, {_stop_fd, POLLIN, 0}};
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("Stream poll failed: ") + std::strerror(errno));
+        }
+        if (fds[1].revents != 0) {
+            _eof = true;
+            _begin = _end = 0;
+            return false;
+        }
+        break;
+    }
+
+    while (true) {
+        ssize_t bytes_read = ::read(_fd, _buffer.data() + _end, _buffer.size() - _end);
+        if (bytes_read < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytes_read < 0) {
+            throw std::runtime_error(std::string("Stream read failed: ") + std::strerror(errno));
+        }
+        if (bytes_read == 0) {
+            _eof = true;
+            return false;
+        }
+        _end += static_cast<size_t>(bytes_read);
+        return true;
+    }
+}
+}// namespace stream_protocol
@@ -0,0 +1,261 @@
+#include "SyntheticScene.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <stdexcept>
+
+
+std::map<std::string, MotionModel> SyntheticScene::motion_model_map = {
+        {"constant_velocity", MotionModel::ConstantVelocity},
+        {"random_walk", MotionModel::RandomWalk},
+        {"coordinated_turn", MotionModel::CoordinatedTurn},
+        {"mixed", MotionModel::MixedMotion},
+};
+
+
+SyntheticScene::SyntheticScene(const SyntheticSceneParams &params) : _params(params), _rng(params.seed) {
+    auto in_unit_range = [](float value) { return value >= 0.0F && value <= 1.0F; };
+    if (_params.num_targets < 0 || _params.frame_size.width <= 0 || _params.frame_size.height <= 0) {
+        throw std::runtime_error("Synthetic scene: invalid number of targets or frame size");
+    }
+    if (_params.min_height <= 0.0F || _params.min_height > _params.max_height ||
+        _params.min_aspect_ratio <= 0.0F || _params.min_aspect_ratio > _params.max_aspect_ratio) {
+        throw std::runtime_error("Synthetic scene: invalid target size range");
+    }
+    if (!in_unit_range(_params.miss_rate) || !in_unit_range(_params.min_visibility) ||
+        _params.false_positives_per_target < 0.0F || _params.mean_lifetime < 0.0F) {
+        throw std::runtime_error("Synthetic scene: invalid detector or lifetime parameters");
+    }
+
+    _targets.reserve(_params.num_targets);
+    for (int i = 0; i < _params.num_targets; i++) {
+        _targets.push_back(_spawn_target());
+    }
+}
+
+
+SyntheticFrame SyntheticScene::next() {
+    SyntheticFrame frame;
+    frame.frame_id = ++_frame_id;
+    frame.camera_motion.setIdentity();
+
+    const cv::Rect_<float> view(0.0F, 0.0F, static_cast<float>(_params.frame_size.width), static_cast<float>(_params.frame_size.height));
+    if (_frame_id > 1) {
+        float dx = _params.pan_x + _params.pan_jitter * _normal();
+        float dy = _params.pan_y + _params.pan_jitter * _normal();
+        _camera_x += dx, _camera_y += dy;
+        frame.camera_motion(0, 2) = -dx;
+        frame.camera_motion(1, 2) = -dy;
+
+        // Targets die at the end of their lifetime or when they leave the view, and are replaced right away
+        for (Target &target: _targets) {
+            _move_target(target);
+            if (--target.frames_left <= 0 || (_image_box(target) & view).area() <= 0.0F) {
+                target = _spawn_target();
+            }
+        }
+    }
+
+    std::vector<cv::Rect_<float>> boxes;
+    boxes.reserve(_targets.size());
+    for (const Target &target: _targets) {
+        boxes.push_back(_image_box(target));
+    }
+    std::vector<float> visibility = _visibility(boxes);
+
+    frame.ground_truth.reserve(_targets.size());
+    frame.detections.reserve(_targets.size());
+    for (size_t i = 0; i < _targets.size(); i++) {
+        frame.ground_truth.push_back({_targets[i].id, boxes[i], visibility[i]});
+        if (visibility[i] < _params.min_visibility || _uniform() < _params.miss_rate) {
+            continue;
+        }
+
+        // Occluded targets get lower scores, down to the second association of BoT-SORT
+        const cv::Rect_<float> &box = boxes[i];
+        Detection detection;
+        detection.bbox_tlwh = cv::Rect_<float>(box.x + _params.position_noise * box.width * _normal(),
+                                               box.y + _params.position_noise * box.height * _normal(),
+                                               box.width * std::max(0.1F, 1.0F + _params.size_noise * _normal()),
+                                               box.height * std::max(0.1F, 1.0F + _params.size_noise * _normal()));
+        detection.class_id = 0;
+        detection.confidence = std::clamp(0.95F - 0.6F * (1.0F - visibility[i]) + 0.05F * _normal(), 0.05F, 1.0F);
+        frame.detections.push_back(detection);
+    }
+
+    const int num_false_positives = _poisson(_params.false_positives_per_target * static_cast<float>(_params.num_targets));
+    for (int i = 0; i < num_false_positives; i++) {
+        float height = std::min(_uniform(_params.min_height, _params.max_height), 0.8F * view.height);
+        float width = height * _uniform(_params.min_aspect_ratio, _params.max_aspect_ratio);
+        Detection detection;
+        detection.bbox_tlwh = cv::Rect_<float>(_uniform() * (view.width - width), _uniform() * (view.height - height), width, height);
+        detection.class_id = 0;
+        detection.confidence = _uniform(0.1F, 0.6F);
+        frame.detections.push_back(detection);
+    }
+
+    // Fisher-Yates, std::shuffle is not reproducible across standard libraries
+    for (size_t i = frame.detections.size(); i > 1; i--) {
+        size_t j = std::min(static_cast<size_t>(_uniform() * static_cast<float>(i)), i - 1);
+        std::swap(frame.detections[i - 1], frame.detections[j]);
+    }
+    return frame;
+}
+
+
+std::vector<SyntheticFrame> SyntheticScene::generate(int num_frames, bool keep_ground_truth) {
+    std::vector<SyntheticFrame> frames;
+    frames.reserve(std::max(0, num_frames));
+    for (int i = 0; i < num_frames; i++) {
+        frames.push_back(next());
+        if (!keep_ground_truth) {
+            frames.back().ground_truth = std::vector<GroundTruthObject>();
+        }
+    }
+    return frames;
+}
+
+
+SyntheticScene::Target SyntheticScene::_spawn_target() {
+    const auto frame_width = static_cast<float>(_params.frame_size.width);
+    const auto frame_height = static_cast<float>(_params.frame_size.height);
+
+    Target target{};
+    target.id = _next_target_id++;
+    target.motion_model = _params.motion_model == MotionModel::MixedMotion
+                                  ? static_cast<MotionModel>(std::min(2, static_cast<int>(_uniform() * 3.0F)))
+                                  : _params.motion_model;
+    target.height = std::min(_uniform(_params.min_height, _params.max_height), 0.8F * frame_height);
+    target.width = target.height * _uniform(_params.min_aspect_ratio, _params.max_aspect_ratio);
+    target.x = _camera_x + _uniform(0.5F * target.width, frame_width - 0.5F * target.width);
+    target.y = _camera_y + _uniform(target.height, frame_height);
+
+    float angle = _uniform(0.0F, 2.0F * static_cast<float>(M_PI));
+    float speed = _params.speed * _uniform(0.5F, 1.5F);
+    target.vx = speed * std::cos(angle);
+    target.vy = speed * std::sin(angle);
+    target.turn_rate = _uniform(-_params.max_turn_rate, _params.max_turn_rate);
+    target.frames_left = _params.mean_lifetime > 0.0F
+                                 ? std::max(1, static_cast<int>(std::lround(-_params.mean_lifetime * std::log(1.0F - _uniform()))))
+                                 : INT_MAX;
+
+    _num_births++;
+    return target;
+}
+
+
+void SyntheticScene::_move_target(Target &target) {
+    switch (target.motion_model) {
+        case MotionModel::RandomWalk: {
+            target.vx += 0.3F * _params.speed * _normal();
+            target.vy += 0.3F * _params.speed * _normal();
+            float speed = std::hypot(target.vx, target.vy), max_speed = 3.0F * _params.speed;
+            if (speed > max_speed) {
+                target.vx *= max_speed / speed, target.vy *= max_speed / speed;
+            }
+            break;
+        }
+        case MotionModel::CoordinatedTurn: {
+            float c = std::cos(target.turn_rate), s = std::sin(target.turn_rate);
+            float vx = c * target.vx - s * target.vy;
+            target.vy = s * target.vx + c * target.vy;
+            target.vx = vx;
+            break;
+        }
+        default:
+            target.vx += 0.02F * _params.speed * _normal();
+            target.vy += 0.02F * _params.speed * _normal();
+            break;
+    }
+    target.x += target.vx;
+    target.y += target.vy;
+}
+
+
+cv::Rect_<float> SyntheticScene::_image_box(const Target &target) const {
+    return {target.x - 0.5F * target.width - _camera_x, target.y - target.height - _camera_y, target.width, target.height};
+}
+
+
+std::vector<float> SyntheticScene::_visibility(const std::vector<cv::Rect_<float>> &boxes) const {
+    const cv::Rect_<float> view(0.0F, 0.0F, static_cast<float>(_params.frame_size.width), static_cast<float>(_params.frame_size.height));
+    constexpr float cell_size = 128.0F;
+    const int grid_width = static_cast<int>(std::ceil(view.width / cell_size));
+    const int grid_height = static_cast<int>(std::ceil(view.height / cell_size));
+    auto cell_x = [&](float x) { return std::clamp(static_cast<int>(x / cell_size), 0, grid_width - 1); };
+    auto cell_y = [&](float y) { return std::clamp(static_cast<int>(y / cell_size), 0, grid_height - 1); };
+
+    // Uniform grid over the frame, each box is listed in the cells its visible part overlaps
+    std::vector<cv::Rect_<float>> clipped(boxes.size());
+    std::vector<std::vector<int>> cells(static_cast<size_t>(grid_width) * grid_height);
+    for (size_t i = 0; i < boxes.size(); i++) {
+        clipped[i] = boxes[i] & view;
+        if (clipped[i].area() <= 0.0F) {
+            continue;
+        }
+        for (int cy = cell_y(clipped[i].y); cy <= cell_y(clipped[i].br().y); cy++) {
+            for (int cx = cell_x(clipped[i].x); cx <= cell_x(clipped[i].br().x); cx++) {
+                cells[cy * grid_width + cx].push_back(static_cast<int>(i));
+            }
+        }
+    }
+
+    auto in_front = [&](size_t occluder, size_t i) {
+        float occluder_bottom = boxes[occluder].br().y, bottom = boxes[i].br().y;
+        return occluder_bottom > bottom || (occluder_bottom == bottom && occluder > i);
+    };
+
+    std::vector<float> visibility(boxes.size(), 0.0F);
+    for (size_t i = 0; i < boxes.size(); i++) {
+        if (clipped[i].area() <= 0.0F) {
+            continue;
+        }
+
+        // An overlap spans several cells, it is only counted in the cell of its top left corner
+        float occluded = 0.0F;
+        for (int cy = cell_y(clipped[i].y); cy <= cell_y(clipped[i].br().y); cy++) {
+            for (int cx = cell_x(clipped[i].x); cx <= cell_x(clipped[i].br().x); cx++) {
+                for (int j: cells[cy * grid_width + cx]) {
+                    if (!in_front(j, i)) {
+                        continue;
+                    }
+                    cv::Rect_<float> overlap = clipped[i] & clipped[j];
+                    if (overlap.area() > 0.0F && cell_x(overlap.x) == cx && cell_y(overlap.y) == cy) {
+                        occluded += overlap.area();
+                    }
+                }
+            }
+        }
+        visibility[i] = std::max(0.0F, clipped[i].area() - occluded) / boxes[i].area();
+    }
+    return visibility;
+}
+
+
+float SyntheticScene::_uniform() {
+    return static_cast<float>(_rng() >> 8) * (1.0F / 16777216.0F);
+}
+
+float SyntheticScene::_normal() {
+    // Box-Muller, u1 in (0, 1]
+    float u1 = 1.0F - _uniform(), u2 = _uniform();
+    return std::sqrt(-2.0F * std::log(u1)) * std::cos(2.0F * static_cast<float>(M_PI) * u2);
+}
+
+int SyntheticScene::_poisson(float mean) {
+    if (mean <= 0.0F) {
+        return 0;
+    }
+    if (mean > 30.0F) {
+        return std::max(0, static_cast<int>(std::lround(mean + std::sqrt(mean) * _normal())));
+    }
+
+    // Knuth
+    const float limit = std::exp(-mean);
+    int count = 0;
+    for (float product = _uniform(); product > limit; product *= _uniform()) {
+        count++;
+    }
+    return count;
+}
@@ -0,0 +1,148 @@
+#include "Tracing.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+
+namespace tracing {
+namespace {
+struct Event {
+    const char *name, *category;
+    int64_t begin_ns, end_ns;
+    int32_t stream_id;
+    uint32_t frame_id;
+};
+
+/**
+ * @brief Events of one thread: only the owning thread appends, the exporter reads the published prefix
+ */
+struct ThreadBuffer {
+    std::unique_ptr<Event[]> events;
+    size_t capacity;
+    std::atomic<size_t> size{0};
+    std::atomic<uint64_t> dropped{0};
+    uint32_t thread_index;
+    uint64_t session;
+
+    ThreadBuffer(size_t capacity, uint32_t thread_index, uint64_t session)
+        : events(new Event[capacity]), capacity(capacity), thread_index(thread_index), session(session) {}
+};
+
+// Buffers of the current recording, the mutex is only taken when a thread records its first event and on export
+std::mutex registry_mutex;
+std::vector<std::shared_ptr<ThreadBuffer>> registry;
+std::atomic<uint64_t> session{0};
+size_t events_per_thread = size_t(1) << 18;
+int64_t session_start_ns = 0;
+uint32_t next_thread_index = 0;
+
+thread_local std::shared_ptr<ThreadBuffer> thread_buffer;
+thread_local int32_t thread_stream_id = -1;
+thread_local uint32_t thread_frame_id = 0;
+
+
+ThreadBuffer &get_thread_buffer() {
+    const uint64_t current_session = session.load(std::memory_order_acquire);
+    if (!thread_buffer || thread_buffer->session != current_session) {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        thread_buffer = std::make_shared<ThreadBuffer>(events_per_thread, next_thread_index++, current_session);
+        registry.push_back(thread_buffer);
+    }
+    return *thread_buffer;
+}
+}// namespace
+
+
+namespace detail {
+std::atomic<bool> enabled{false};
+
+void record(const char *name, const char *category, int64_t begin_ns, int64_t end_ns) {
+    ThreadBuffer &buffer = get_thread_buffer();
+    const size_t size = buffer.size.load(std::memory_order_relaxed);
+    if (size == buffer.capacity) {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer.events[size] = {name, category, begin_ns, end_ns, thread_stream_id, thread_frame_id};
+    buffer.size.store(size + 1, std::memory_order_release);
+}
+}// namespace detail
+
+
+void start(size_t capacity) {
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        registry.clear();
+        events_per_thread = std::max<size_t>(1, capacity);
+        next_thread_index = 0;
+        session_start_ns = now_ns();
+        session.fetch_add(1, std::memory_order_release);
+    }
+    detail::enabled.store(true, std::memory_order_relaxed);
+}
+
+void stop() {
+    detail::enabled.store(false, std::memory_order_relaxed);
+}
+
+uint64_t dropped_events() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    uint64_t dropped = 0;
+    for (const std::shared_ptr<ThreadBuffer> &buffer: registry) {
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+}
+
+size_t write_chrome_trace(const std::string &path) {
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error("Can't write the trace to " + path);
+    }
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    size_t num_events = 0;
+    file << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    file << std::fixed << std::setprecision(3);
+    for (const std::shared_ptr<ThreadBuffer> &buffer: registry) {
+        file << (num_events ? ",\n" : "\n")
+             << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->thread_index
+             << ", \"args\": {\"name\": \"thread " << buffer->thread_index << "\"}}";
+        num_events++;
+
+        // Timestamps and durations are in microseconds
+        const size_t size = buffer->size.load(std::memory_order_acquire);
+        for (size_t i = 0; i < size; i++) {
+            const Event &event = buffer->events[i];
+            file << ",\n{\"name\": \"" << event.name << "\", \"cat\": \"" << event.category << "\", \"ph\": \"X\""
+                 << ", \"ts\": " << static_cast<double>(event.begin_ns - session_start_ns) * 1e-3
+                 << ", \"dur\": " << static_cast<double>(event.end_ns - event.begin_ns) * 1e-3
+                 << ", \"pid\": 1, \"tid\": " << buffer->thread_index
+                 << ", \"args\": {\"stream\": " << event.stream_id << ", \"frame\": " << event.frame_id << "}}";
+        }
+        num_events += size;
+    }
+    file << "\n]}\n";
+    if (!file) {
+        throw std::runtime_error("Can't write the trace to " + path);
+    }
+    return num_events;
+}
+
+
+FrameContext::FrameContext(int32_t stream_id, uint32_t frame_id)
+    : _prev_stream_id(thread_stream_id), _prev_frame_id(thread_frame_id) {
+    thread_stream_id = stream_id;
+    thread_frame_id = frame_id;
+}
+
+FrameContext::~FrameContext() {
+    thread_stream_id = _prev_stream_id;
+    thread_frame_id = _prev_frame_id;
+}
+}// namespace tracing
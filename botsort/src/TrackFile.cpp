@@ -0,0 +1,289 @@
+#include "TrackFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+
+namespace {
+inline uint32_t zigzag_encode(int32_t value) {
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+inline int32_t zigzag_decode(uint32_t value) {
+    return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+}
+
+inline void put_varint(std::vector<uint8_t> &out, int32_t value) {
+    uint32_t encoded = zigzag_encode(value);
+    while (encoded >= 0x80) {
+        out.push_back(static_cast<uint8_t>(encoded | 0x80));
+        encoded >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(encoded));
+}
+
+inline int32_t get_varint(const uint8_t *&p, const uint8_t *end) {
+    uint32_t encoded = 0;
+    for (int shift = 0; p < end && shift < 35; shift += 7) {
+        uint8_t byte = *p++;
+        encoded |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return zigzag_decode(encoded);
+        }
+    }
+    throw std::runtime_error("Corrupted track file: truncated varint");
+}
+
+template<typename T>
+inline void put_column(std::vector<uint8_t> &out, const std::vector<T> &column) {
+    const auto *bytes = reinterpret_cast<const uint8_t *>(column.data());
+    out.insert(out.end(), bytes, bytes + column.size() * sizeof(T));
+}
+
+inline void pad_to_4(std::vector<uint8_t> &out) {
+    out.resize((out.size() + 3) & ~size_t(3), 0);
+}
+}// namespace
+
+
+TrackFileWriter::TrackFileWriter(const std::string &output_file, bool delta_encoding, uint32_t keyframe_interval)
+    : _path(output_file),
+      _file(output_file, std::ios::binary | std::ios::trunc),
+      _delta_encoding(delta_encoding),
+      _keyframe_interval(std::max(keyframe_interval, 1U)) {
+    if (!_file.is_open()) {
+        throw std::runtime_error("Can't open " + output_file);
+    }
+
+    track_file::FileHeader header{};
+    std::memcpy(header.magic, track_file::MAGIC, sizeof(header.magic));
+    header.version = track_file::VERSION;
+    header.flags = _delta_encoding ? track_file::FILE_FLAG_DELTA : 0;
+    header.keyframe_interval = _keyframe_interval;
+    _file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    _check_stream();
+}
+
+TrackFileWriter::~TrackFileWriter() {
+    // Only report the failures the caller has not already seen through write() or flush()
+    const bool failed_before = !_file;
+    _file.close();
+    if (!failed_before && !_file) {
+        std::cerr << "Can't close " << _path << ", the track file may be incomplete" << std::endl;
+    }
+}
+
+void TrackFileWriter::write(uint32_t frame_id, const std::vector<std::shared_ptr<Track>> &tracks) {
+    const size_t num_tracks = tracks.size();
+    std::vector<int32_t> track_ids(num_tracks);
+    std::vector<float> x(num_tracks), y(num_tracks), width(num_tracks), height(num_tracks), score(num_tracks);
+    std::vector<uint8_t> class_ids(num_tracks), states(num_tracks);
+
+    for (size_t i = 0; i < num_tracks; i++) {
+        std::vector<float> tlwh = tracks[i]->get_tlwh();
+        track_ids[i] = tracks[i]->track_id;
+        x[i] = tlwh[0], y[i] = tlwh[1], width[i] = tlwh[2], height[i] = tlwh[3];
+        score[i] = tracks[i]->get_score();
+        class_ids[i] = tracks[i]->get_class_id();
+        states[i] = static_cast<uint8_t>(tracks[i]->state);
+    }
+
+    track_file::FrameHeader frame_header{frame_id, static_cast<uint32_t>(num_tracks), 0, 0};
+    _payload.clear();
+
+    if (!_delta_encoding) {
+        put_column(_payload, track_ids);
+        put_column(_payload, x), put_column(_payload, y), put_column(_payload, width), put_column(_payload, height);
+    } else {
+        const bool keyframe = _num_frames % _keyframe_interval == 0;
+        if (keyframe) {
+            frame_header.flags |= track_file::FRAME_FLAG_KEYFRAME;
+            _previous_boxes.clear();
+        }
+
+        int32_t previous_id = 0;
+        for (int32_t track_id: track_ids) {
+            put_varint(_payload, track_id - previous_id);
+            previous_id = track_id;
+        }
+
+        // Boxes of the same track move little from frame to frame, the deltas mostly fit in one or two bytes
+        _current_boxes.clear();
+        for (size_t i = 0; i < num_tracks; i++) {
+            std::array<int32_t, 4> box = {static_cast<int32_t>(std::lround(x[i] * track_file::COORDINATE_SCALE)),
+                                          static_cast<int32_t>(std::lround(y[i] * track_file::COORDINATE_SCALE)),
+                                          static_cast<int32_t>(std::lround(width[i] * track_file::COORDINATE_SCALE)),
+                                          static_cast<int32_t>(std::lround(height[i] * track_file::COORDINATE_SCALE))};
+
+            auto previous = _previous_boxes.find(track_ids[i]);
+            const std::array<int32_t, 4> reference = previous != _previous_boxes.end() ? previous->second : std::array<int32_t, 4>{};
+            for (int k = 0; k < 4; k++) {
+                put_varint(_payload, box[k] - reference[k]);
+            }
+            _current_boxes[track_ids[i]] = box;
+        }
+        std::swap(_previous_boxes, _current_boxes);
+    }
+
+    put_column(_payload, score);
+    put_column(_payload, class_ids);
+    put_column(_payload, states);
+    pad_to_4(_payload);
+
+    frame_header.payload_bytes = static_cast<uint32_t>(_payload.size());
+    _file.write(reinterpret_cast<const char *>(&frame_header), sizeof(frame_header));
+    _file.write(reinterpret_cast<const char *>(_payload.data()), static_cast<std::streamsize>(_payload.size()));
+    _check_stream();
+    _num_frames++;
+}
+
+void TrackFileWriter::flush() {
+    _file.flush();
+    _check_stream();
+}
+
+void TrackFileWriter::_check_stream() const {
+    if (!_file) {
+        throw std::runtime_error("Can't write the track file " + _path + " (e.g. disk full), the file is incomplete");
+    }
+}
+
+
+TrackFileReader::TrackFileReader(const std::string &input_file)
+    : _file(input_file) {
+    std::string_view data = _file.view();
+    if (data.size() < sizeof(track_file::FileHeader)) {
+        throw std::runtime_error("Not a track file: " + input_file);
+    }
+
+    std::memcpy(&_header, data.data(), sizeof(_header));
+    if (std::memcmp(_header.magic, track_file::MAGIC, sizeof(_header.magic)) != 0 || _header.version != track_file::VERSION) {
+        throw std::runtime_error("Not a track file (or unsupported version): " + input_file);
+    }
+
+    // Index the frames by following the payload sizes, a truncated last frame (e.g. still being written) is ignored
+    size_t offset = sizeof(track_file::FileHeader);
+    while (offset + sizeof(track_file::FrameHeader) <= data.size()) {
+        track_file::FrameHeader frame_header{};
+        std::memcpy(&frame_header, data.data() + offset, sizeof(frame_header));
+
+        size_t next_offset = offset + sizeof(track_file::FrameHeader) + frame_header.payload_bytes;
+        if (next_offset > data.size()) {
+            break;
+        }
+        _frame_offsets.push_back(offset);
+        offset = next_offset;
+    }
+}
+
+size_t TrackFileReader::num_frames() const {
+    return _frame_offsets.size();
+}
+
+bool TrackFileReader::delta_encoded() const {
+    return (_header.flags & track_file::FILE_FLAG_DELTA) != 0;
+}
+
+TrackFrame TrackFileReader::frame(size_t index) {
+    if (index >= _frame_offsets.size()) {
+        throw std::out_of_range("Frame index out of range: " + std::to_string(index));
+    }
+
+    const char *frame_data = _file.view().data() + _frame_offsets[index];
+    track_file::FrameHeader frame_header{};
+    std::memcpy(&frame_header, frame_data, sizeof(frame_header));
+    const size_t n = frame_header.num_tracks;
+
+    TrackFrame frame;
+    frame.frame_id = frame_header.frame_id;
+    frame.num_tracks = n;
+
+    // The payload is 4-byte aligned (page aligned mapping, 16 byte headers and padded payloads)
+    if (!delta_encoded()) {
+        if (n * (sizeof(int32_t) + 5 * sizeof(float) + 2) > frame_header.payload_bytes) {
+            throw std::runtime_error("Corrupted track file: frame " + std::to_string(frame_header.frame_id));
+        }
+        const char *payload = frame_data + sizeof(track_file::FrameHeader);
+        frame.track_ids = reinterpret_cast<const int32_t *>(payload);
+        const auto *columns = reinterpret_cast<const float *>(payload + n * sizeof(int32_t));
+        frame.x = columns, frame.y = columns + n, frame.width = columns + 2 * n, frame.height = columns + 3 * n;
+        frame.score = columns + 4 * n;
+        frame.class_id = reinterpret_cast<const uint8_t *>(columns + 5 * n);
+        frame.state = frame.class_id + n;
+        return frame;
+    }
+
+    if (_decoded_frame == SIZE_MAX || index != _decoded_frame + 1) {
+        // Seek back to the closest keyframe
+        size_t keyframe = index;
+        while (keyframe > 0) {
+            track_file::FrameHeader header{};
+            std::memcpy(&header, _file.view().data() + _frame_offsets[keyframe], sizeof(header));
+            if (header.flags & track_file::FRAME_FLAG_KEYFRAME) {
+                break;
+            }
+            keyframe--;
+        }
+        _previous_boxes.clear();
+        for (size_t i = keyframe; i < index; i++) {
+            _decode_frame(i);
+        }
+    }
+    _decode_frame(index);
+
+    frame.track_ids = _track_ids.data();
+    frame.x = _columns.data(), frame.y = _columns.data() + n, frame.width = _columns.data() + 2 * n, frame.height = _columns.data() + 3 * n;
+    frame.score = _scores.data();
+    frame.class_id = _class_ids.data();
+    frame.state = _states.data();
+    return frame;
+}
+
+void TrackFileReader::_decode_frame(size_t index) {
+    const char *frame_data = _file.view().data() + _frame_offsets[index];
+    track_file::FrameHeader frame_header{};
+    std::memcpy(&frame_header, frame_data, sizeof(frame_header));
+    const size_t n = frame_header.num_tracks;
+    const auto *p = reinterpret_cast<const uint8_t *>(frame_data + sizeof(track_file::FrameHeader));
+    const uint8_t *end = p + frame_header.payload_bytes;
+
+    if (frame_header.flags & track_file::FRAME_FLAG_KEYFRAME) {
+        _previous_boxes.clear();
+    }
+
+    _track_ids.resize(n);
+    int32_t previous_id = 0;
+    for (size_t i = 0; i < n; i++) {
+        previous_id += get_varint(p, end);
+        _track_ids[i] = previous_id;
+    }
+
+    _columns.resize(4 * n);
+    _current_boxes.clear();
+    for (size_t i = 0; i < n; i++) {
+        auto previous = _previous_boxes.find(_track_ids[i]);
+        const std::array<int32_t, 4> reference = previous != _previous_boxes.end() ? previous->second : std::array<int32_t, 4>{};
+
+        std::array<int32_t, 4> box{};
+        for (int k = 0; k < 4; k++) {
+            box[k] = reference[k] + get_varint(p, end);
+            _columns[k * n + i] = static_cast<float>(box[k]) / track_file::COORDINATE_SCALE;
+        }
+        _current_boxes[_track_ids[i]] = box;
+    }
+    std::swap(_previous_boxes, _current_boxes);
+
+    // Score, class and state columns are stored raw (but unaligned) after the varints
+    if (p + n * (sizeof(float) + 2) > end) {
+        throw std::runtime_error("Corrupted track file: frame " + std::to_string(frame_header.frame_id));
+    }
+    _scores.resize(n);
+    std::memcpy(_scores.data(), p, n * sizeof(float));
+    p += n * sizeof(float);
+    _class_ids.assign(p, p + n);
+    _states.assign(p + n, p + 2 * n);
+    _decoded_frame = index;
+}
@@ -0,0 +1,37 @@
+#include "TrackerConfig.h"
+#include "GlobalMotionCompensation.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+
+
+TrackerConfig TrackerConfig::load(const std::string &config_dir) {
+    TrackerConfig config;
+    config.config_dir = config_dir;
+    config.tracker = INIReader(config_dir + "/tracker.ini");
+    if (config.tracker.ParseError() < 0) {
+        std::cout << "Can't load " << config_dir << "/tracker.ini" << std::endl;
+        exit(1);
+    }
+    config.gmc = INIReader(config_dir + "/gmc.ini");
+    return config;
+}
+
+
+void TrackerConfig::set(const std::string &section, const std::string &name, const std::string &value) {
+    (is_gmc_section(section) ? gmc : tracker).Set(section, name, value);
+}
+
+
+bool TrackerConfig::is_gmc_section(const std::string &section) {
+    return std::any_of(GlobalMotionCompensation::GMC_section_map.begin(), GlobalMotionCompensation::GMC_section_map.end(),
+                       [&section](const auto &method_section) { return same_section(section, method_section.second); });
+}
+
+
+bool TrackerConfig::same_section(const std::string &a, const std::string &b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+               return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+           });
+}
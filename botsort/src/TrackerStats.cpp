@@ -0,0 +1,85 @@
+#include "TrackerStats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+
+uint64_t LatencyHistogram::percentile(double percentile) const {
+    if (_count == 0) {
+        return 0;
+    }
+
+    const double clamped = std::clamp(percentile, 0.0, 100.0);
+    const auto target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(clamped / 100.0 * static_cast<double>(_count))));
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < _counts.size(); i++) {
+        cumulative += _counts[i];
+        if (cumulative >= target) {
+            return std::min(_bucket_highest_value(i), _max);
+        }
+    }
+    return _max;
+}
+
+void LatencyHistogram::reset() {
+    std::fill(_counts.begin(), _counts.end(), 0);
+    _count = 0, _sum = 0, _min = UINT64_MAX, _max = 0;
+}
+
+uint64_t LatencyHistogram::_bucket_highest_value(size_t index) {
+    if (index < SUB_BUCKET_COUNT) {
+        return index;
+    }
+    const size_t shift = index / SUB_BUCKET_COUNT - 1;
+    const uint64_t sub_bucket = index % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT;
+    return ((sub_bucket + 1) << shift) - 1;
+}
+
+
+const std::array<const char *, NUM_TRACKER_STAGES> TrackerStats::stage_names = {
+        "detection_intake",
+        "predict",
+        "gmc",
+        "first_association",
+        "second_association",
+        "unconfirmed",
+        "new_tracks",
+        "lifecycle",
+        "cleanup",
+        "total",
+};
+
+void TrackerStats::reset() {
+    for (StageStats &stats: _stages) {
+        stats.latency.reset();
+        stats.tracks = 0, stats.detections = 0, stats.matches = 0;
+    }
+}
+
+std::string TrackerStats::summary() const {
+    std::ostringstream out;
+    const double frames = std::max<double>(1.0, static_cast<double>(this->frames()));
+
+    out << "| Stage | Calls | Mean (us) | p50 (us) | p90 (us) | p99 (us) | Max (us) | Tracks / frame | Detections / frame | Matches / frame |\n"
+        << "| --- | --- | --- | --- | --- | --- | --- | --- | --- | --- |\n";
+    out << std::fixed;
+    for (size_t i = 0; i < NUM_TRACKER_STAGES; i++) {
+        const StageStats &stats = _stages[i];
+        out << std::setprecision(3)
+            << "| " << stage_names[i]
+            << " | " << stats.latency.count()
+            << " | " << stats.latency.mean() * 1e-3
+            << " | " << static_cast<double>(stats.latency.percentile(50)) * 1e-3
+            << " | " << static_cast<double>(stats.latency.percentile(90)) * 1e-3
+            << " | " << static_cast<double>(stats.latency.percentile(99)) * 1e-3
+            << " | " << static_cast<double>(stats.latency.max()) * 1e-3
+            << std::setprecision(1)
+            << " | " << static_cast<double>(stats.tracks) / frames
+            << " | " << static_cast<double>(stats.detections) / frames
+            << " | " << static_cast<double>(stats.matches) / frames
+            << " |\n";
+    }
+    return out.str();
+}
@@ -43,9 +43,106 @@ CostMatrix iou_distance(const std::vector<std::shared_ptr<Track>> &tracks,
     return cost_matrix;
 }
 
+namespace {
+template<int Dim>
+CostMatrix embedding_distance_kernel(const std::vector<std::shared_ptr<Track>> &tracks,
+                                     const std::vector<std::shared_ptr<Track>> &detections) {
+    const auto num_tracks = static_cast<Eigen::Index>(tracks.size());
+    const auto num_detections = static_cast<Eigen::Index>(detections.size());
+    const Eigen::Index feature_dim = detections[0]->curr_feat->size();
+
+    // Gather detection features into a contiguous matrix
+    FeatureMatrixT<Dim> detection_features(num_detections, feature_dim);
+    for (Eigen::Index j = 0; j < num_detections; j++) {
+        detection_features.row(j) = *detections[j]->curr_feat;
+    }
+
+    // Smoothed features of active tracks are gathered for a single GEMM, while lost tracks
+    // keep their features compacted in the appearance store and are scored on the stored form
+    std::vector<Eigen::Index> resident_rows, compacted_rows;
+    std::vector<AppearanceStore::Slot> compacted_slots;
+    for (Eigen::Index i = 0; i < num_tracks; i++) {
+        if (tracks[i]->smooth_feat) {
+            resident_rows.push_back(i);
+        } else {
+            compacted_rows.push_back(i);
+            compacted_slots.push_back(tracks[i]->smooth_feat_slot());
+        }
+    }
+
+    // Features are L2-normalized in Track::_update_features, so the cosine distance
+    // between all pairs reduces to a single GEMM: 1 - A * B^T
+    CostMatrix cost_matrix(num_tracks, num_detections);
+    if (resident_rows.size() == tracks.size()) {
+        FeatureMatrixT<Dim> track_features(num_tracks, feature_dim);
+        for (Eigen::Index i = 0; i < num_tracks; i++) {
+            track_features.row(i) = *tracks[i]->smooth_feat;
+        }
+        cost_matrix.noalias() = track_features * detection_features.transpose();
+    } else {
+        FeatureMatrixT<Dim> track_features(static_cast<Eigen::Index>(resident_rows.size()), feature_dim);
+        for (size_t i = 0; i < resident_rows.size(); i++) {
+            track_features.row(static_cast<Eigen::Index>(i)) = *tracks[resident_rows[i]]->smooth_feat;
+        }
+        CostMatrix resident_products = track_features * detection_features.transpose();
+        CostMatrix compacted_products = tracks[compacted_rows[0]]->appearance_store()->dot(compacted_slots, detection_features);
+
+        for (size_t i = 0; i < resident_rows.size(); i++) {
+            cost_matrix.row(resident_rows[i]) = resident_products.row(static_cast<Eigen::Index>(i));
+        }
+        for (size_t i = 0; i < compacted_rows.size(); i++) {
+            cost_matrix.row(compacted_rows[i]) = compacted_products.row(static_cast<Eigen::Index>(i));
+        }
+    }
+
+    return (1.0F - cost_matrix.array()).max(0.0F);
+}
+
+void apply_history_distance(CostMatrix &cost_matrix,
+                            const std::vector<std::shared_ptr<Track>> &tracks,
+                            const std::vector<std::shared_ptr<Track>> &detections,
+                            AppearanceMetric metric) {
+    FeatureMatrix detection_features(static_cast<Eigen::Index>(detections.size()), detections[0]->curr_feat->size());
+    for (size_t j = 0; j < detections.size(); j++) {
+        detection_features.row(static_cast<Eigen::Index>(j)) = *detections[j]->curr_feat;
+    }
+
+    // Tracks without a history keep the distance to their smoothed feature
+    for (size_t i = 0; i < tracks.size(); i++) {
+        const FeatureHistory *history = tracks[i]->feature_history();
+        if (history == nullptr || history->size() == 0) {
+            continue;
+        }
+
+        cost_matrix.row(static_cast<Eigen::Index>(i)) = metric == AppearanceMetric::HistoryMin
+                                                                ? history->min_distance(detection_features)
+                                                                : history->mean_distance(detection_features);
+    }
+}
+}// namespace
+
+EmbeddingDistanceKernel select_embedding_distance_kernel(int feature_dim) {
+    switch (feature_dim) {
+        case 128:
+            return &embedding_distance_kernel<128>;
+        case 256:
+            return &embedding_distance_kernel<256>;
+        case 512:
+            return &embedding_distance_kernel<512>;
+        case 1024:
+            return &embedding_distance_kernel<1024>;
+        case 2048:
+            return &embedding_distance_kernel<2048>;
+        default:
+            return &embedding_distance_kernel<Eigen::Dynamic>;
+    }
+}
+
 std::tuple<CostMatrix, CostMatrix> embedding_distance(const std::vector<std::shared_ptr<Track>> &tracks,
                                                       const std::vector<std::shared_ptr<Track>> &detections,
-                                                      float max_embedding_distance) {
+                                                      float max_embedding_distance,
+                                                      EmbeddingDistanceKernel kernel,
+                                                      AppearanceMetric metric) {
     size_t num_tracks = tracks.size();
     size_t num_detections = detections.size();
 
@@ -53,15 +150,15 @@ std::tuple<CostMatrix, CostMatrix> embedding_distance(const std::vector<std::sha
     CostMatrix embedding_dists_mask = Eigen::MatrixXf::Zero(static_cast<Eigen::Index>(num_tracks), static_cast<Eigen::Index>(num_detections));
 
     if (num_tracks > 0 && num_detections > 0) {
-        for (int i = 0; i < num_tracks; i++) {
-            for (int j = 0; j < num_detections; j++) {
-                cost_matrix(i, j) = std::max(0.0f, cosine_distance(tracks[i]->smooth_feat, detections[j]->curr_feat));
+        if (kernel == nullptr) {
+            kernel = select_embedding_distance_kernel(static_cast<int>(detections[0]->curr_feat->size()));
+        }
 
-                if (cost_matrix(i, j) > max_embedding_distance) {
-                    embedding_dists_mask(i, j) = 1.0F;
-                }
-            }
+        cost_matrix = kernel(tracks, detections);
+        if (metric != AppearanceMetric::Smooth) {
+            apply_history_distance(cost_matrix, tracks, detections, metric);
         }
+        embedding_dists_mask = (cost_matrix.array() > max_embedding_distance).cast<float>();
     }
 
     return {cost_matrix, embedding_dists_mask};
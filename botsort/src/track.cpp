@@ -1,30 +1,43 @@
 #include "track.h"
 
+#include <stdexcept>
 #include <utility>
 
-Track::Track(std::vector<float> tlwh, float score, uint8_t class_id, std::optional<FeatureVector> feat, int feat_history_size)
+Track::Track(std::vector<float> tlwh,
+             float score,
+             uint8_t class_id,
+             std::optional<FeatureVector> feat,
+             std::shared_ptr<AppearanceStore> appearance_store,
+             int feat_history_size)
     : det_tlwh(std::move(tlwh)),
       _score(score),
       _class_id(class_id),
       tracklet_len(0),
       is_activated(false),
-      state(TrackState::New) {
+      state(TrackState::New),
+      _appearance_store(std::move(appearance_store)) {
 
+    // Features may also be provided later through update_features()
+    _feat_history_size = feat_history_size;
     if (feat) {
-        _feat_history_size = feat_history_size;
         _update_features(std::make_shared<FeatureVector>(feat.value()));
     } else {
         curr_feat = nullptr;
         smooth_feat = nullptr;
-        _feat_history_size = 0;
     }
 
     _update_class_id(class_id, score);
     _update_tracklet_tlwh_inplace();
 }
 
-void Track::activate(KalmanFilter &kalman_filter, uint32_t frame_id) {
-    track_id = next_id();
+Track::~Track() {
+    if (_appearance_store) {
+        _appearance_store->release(_smooth_feat_slot);
+    }
+}
+
+void Track::activate(KalmanFilter &kalman_filter, uint32_t frame_id, int track_id) {
+    this->track_id = track_id;
 
     // Create DetVec from det_tlwh
     DetVec detection_bbox;
@@ -43,9 +56,14 @@ void Track::activate(KalmanFilter &kalman_filter, uint32_t frame_id) {
     state = TrackState::Tracked;
     tracklet_len = 1;
     _update_tracklet_tlwh_inplace();
+
+    // The feature of the detection only enters the history once the detection starts a track
+    if (curr_feat) {
+        _push_feature_history();
+    }
 }
 
-void Track::re_activate(KalmanFilter &kalman_filter, Track &new_track, uint32_t frame_id, bool new_id) {
+void Track::re_activate(KalmanFilter &kalman_filter, Track &new_track, uint32_t frame_id, std::optional<int> new_track_id) {
     DetVec new_track_bbox;
     _populate_DetVec_xywh(new_track_bbox, new_track._tlwh);
 
@@ -55,10 +73,12 @@ void Track::re_activate(KalmanFilter &kalman_filter, Track &new_track, uint32_t
 
     if (new_track.curr_feat) {
         _update_features(new_track.curr_feat);
+        feat_frame_id = new_track.feat_frame_id;
     }
+    det_tlwh = new_track.det_tlwh;
 
-    if (new_id) {
-        track_id = next_id();
+    if (new_track_id) {
+        track_id = new_track_id.value();
     }
 
     tracklet_len = 0;
@@ -113,7 +133,9 @@ void Track::update(KalmanFilter &kalman_filter, Track &new_track, uint32_t frame
 
     if (new_track.curr_feat) {
         _update_features(new_track.curr_feat);
+        feat_frame_id = new_track.feat_frame_id;
     }
+    det_tlwh = new_track.det_tlwh;
 
     mean = state_space.first;
     covariance = state_space.second;
@@ -127,31 +149,89 @@ void Track::update(KalmanFilter &kalman_filter, Track &new_track, uint32_t frame
     _update_tracklet_tlwh_inplace();
 }
 
+void Track::update_features(const FeatureVector &feat) {
+    _update_features(std::make_shared<FeatureVector>(feat));
+
+    if (state == TrackState::Lost || state == TrackState::LongLost) {
+        _compact_features();
+    }
+}
+
 void Track::_update_features(const std::shared_ptr<FeatureVector>& feat) {
     *feat /= feat->norm();
+    _restore_features();
 
-    if (_feat_history.empty()) {
-        curr_feat = feat;
+    curr_feat = feat;
+    if (!smooth_feat) {
         smooth_feat = std::make_unique<FeatureVector>(*curr_feat);
     } else {
         *smooth_feat = _alpha * (*smooth_feat) + (1 - _alpha) * (*feat);
     }
 
-    if (_feat_history.size() == _feat_history_size) {
-        _feat_history.pop_front();
+    // Detections that do not start a track never need a history, see activate()
+    if (state != TrackState::New) {
+        _push_feature_history();
     }
-    _feat_history.push_back(curr_feat);
     *smooth_feat /= smooth_feat->norm();
 }
 
-int Track::next_id() {
-    static int _count = 0;
-    _count++;
-    return _count;
+void Track::_push_feature_history() {
+    // Feature history is kept inline in the track, in the (possibly quantized) storage precision of the appearance store
+    if (_appearance_store && _feat_history_size > 0) {
+        if (!_feat_history) {
+            _feat_history = std::make_unique<FeatureHistory>(_appearance_store->feature_dim(),
+                                                             _appearance_store->precision(),
+                                                             _feat_history_size);
+        }
+        _feat_history->push(*curr_feat);
+    }
+}
+
+void Track::_compact_features() {
+    if (!_appearance_store || !smooth_feat) {
+        return;
+    }
+
+    _smooth_feat_slot = _appearance_store->allocate();
+    _appearance_store->store(_smooth_feat_slot, *smooth_feat);
+    smooth_feat.reset();
+}
+
+void Track::_restore_features() {
+    if (_smooth_feat_slot == AppearanceStore::INVALID_SLOT) {
+        return;
+    }
+
+    smooth_feat = std::make_unique<FeatureVector>(_appearance_store->load(_smooth_feat_slot));
+    _appearance_store->release(_smooth_feat_slot);
+    _smooth_feat_slot = AppearanceStore::INVALID_SLOT;
+}
+
+std::optional<FeatureVector> Track::get_smooth_feat() const {
+    if (smooth_feat) {
+        return *smooth_feat;
+    }
+    if (_smooth_feat_slot != AppearanceStore::INVALID_SLOT) {
+        return _appearance_store->load(_smooth_feat_slot);
+    }
+    return std::nullopt;
+}
+
+AppearanceStore::Slot Track::smooth_feat_slot() const {
+    return _smooth_feat_slot;
+}
+
+const std::shared_ptr<AppearanceStore> &Track::appearance_store() const {
+    return _appearance_store;
+}
+
+const FeatureHistory *Track::feature_history() const {
+    return _feat_history.get();
 }
 
 void Track::mark_lost() {
     state = TrackState::Lost;
+    _compact_features();
 }
 
 void Track::mark_long_lost() {
@@ -190,6 +270,10 @@ float Track::get_score() const {
     return _score;
 }
 
+uint8_t Track::get_class_id() const {
+    return _class_id;
+}
+
 void Track::_update_class_id(uint8_t class_id, float score) {
     if (!_class_hist.empty()) {
         int max_freq = 0;
@@ -214,4 +298,104 @@ void Track::_update_class_id(uint8_t class_id, float score) {
         _class_hist.emplace_back(class_id, score);
         _class_id = class_id;
     }
-}
\ No newline at end of file
+}
+
+void Track::save_state(SnapshotWriter &writer) const {
+    writer.write(static_cast<int32_t>(track_id));
+    writer.write(static_cast<int32_t>(state));
+    writer.write(static_cast<uint8_t>(is_activated));
+    writer.write(frame_id);
+    writer.write(tracklet_len);
+    writer.write(start_frame);
+    writer.write(feat_frame_id);
+    writer.write_vector(det_tlwh);
+    writer.write_vector(_tlwh);
+    writer.write(_score);
+    writer.write(_class_id);
+
+    writer.write(static_cast<uint64_t>(_class_hist.size()));
+    for (const std::pair<uint8_t, float> &class_hist: _class_hist) {
+        writer.write(class_hist.first);
+        writer.write(class_hist.second);
+    }
+
+    writer.write_matrix(mean);
+    writer.write_matrix(covariance);
+
+    writer.write(static_cast<uint8_t>(curr_feat != nullptr));
+    if (curr_feat) {
+        writer.write_matrix(*curr_feat);
+    }
+
+    // The smoothed feature of a lost track stays compacted, in the storage precision of the appearance store
+    if (smooth_feat) {
+        writer.write(static_cast<uint8_t>(1));
+        writer.write_matrix(*smooth_feat);
+    } else if (_smooth_feat_slot != AppearanceStore::INVALID_SLOT) {
+        writer.write(static_cast<uint8_t>(2));
+        _appearance_store->save_slot(_smooth_feat_slot, writer);
+    } else {
+        writer.write(static_cast<uint8_t>(0));
+    }
+
+    writer.write(static_cast<uint8_t>(_feat_history != nullptr));
+    if (_feat_history) {
+        _feat_history->save_state(writer);
+    }
+}
+
+std::shared_ptr<Track> Track::load_state(SnapshotReader &reader, std::shared_ptr<AppearanceStore> appearance_store, int feat_history_size) {
+    auto track = std::make_shared<Track>(std::vector<float>(4, 0.0F), 0.0F, 0, std::nullopt, std::move(appearance_store), feat_history_size);
+
+    track->track_id = reader.read<int32_t>();
+    track->state = reader.read<int32_t>();
+    if (track->state < TrackState::New || track->state > TrackState::Removed) {
+        throw std::runtime_error("Malformed tracker snapshot: unknown track state " + std::to_string(track->state));
+    }
+    track->is_activated = reader.read<uint8_t>() != 0;
+    track->frame_id = reader.read<uint32_t>();
+    track->tracklet_len = reader.read<uint32_t>();
+    track->start_frame = reader.read<uint32_t>();
+    track->feat_frame_id = reader.read<uint32_t>();
+    reader.read_vector(track->det_tlwh);
+    reader.read_vector(track->_tlwh);
+    track->_score = reader.read<float>();
+    track->_class_id = reader.read<uint8_t>();
+
+    track->_class_hist.resize(reader.read_count(sizeof(uint8_t) + sizeof(float)));
+    for (std::pair<uint8_t, float> &class_hist: track->_class_hist) {
+        class_hist.first = reader.read<uint8_t>();
+        class_hist.second = reader.read<float>();
+    }
+
+    reader.read_matrix(track->mean);
+    reader.read_matrix(track->covariance);
+
+    if (reader.read<uint8_t>()) {
+        track->curr_feat = std::make_shared<FeatureVector>();
+        reader.read_matrix(*track->curr_feat);
+    }
+
+    const std::shared_ptr<AppearanceStore> &store = track->_appearance_store;
+    auto smooth_feat_mode = reader.read<uint8_t>();
+    if (smooth_feat_mode == 1) {
+        track->smooth_feat = std::make_unique<FeatureVector>();
+        reader.read_matrix(*track->smooth_feat);
+    } else if (smooth_feat_mode == 2) {
+        if (!store) {
+            throw std::runtime_error("Tracker snapshot has compacted features but the Re-ID module is disabled");
+        }
+        track->_smooth_feat_slot = store->allocate();
+        store->load_slot(track->_smooth_feat_slot, reader);
+    }
+
+    if (reader.read<uint8_t>()) {
+        if (!store) {
+            throw std::runtime_error("Tracker snapshot has feature histories but the Re-ID module is disabled");
+        }
+        track->_feat_history = std::make_unique<FeatureHistory>(store->feature_dim(), store->precision(), feat_history_size);
+        track->_feat_history->load_state(reader);
+    }
+
+    return track;
+}
@@ -1,14 +1,21 @@
+#include <cstring>
 #include <iostream>
 
+#include "Tracing.h"
 #include "lapjv.h"
 #include "utils.h"
 
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
 double lapjv(CostMatrix &cost,
              std::vector<int> &rowsol,
              std::vector<int> &colsol,
              bool extend_cost,
              float cost_limit,
              bool return_cost) {
+    tracing::Scope trace("lapjv", "matching");
     std::vector<std::vector<float>> cost_c;
 
     for (Eigen::Index i = 0; i < cost.rows(); i++) {
@@ -136,3 +143,117 @@ double lapjv(CostMatrix &cost,
 
     return opt;
 }
+
+
+namespace {
+#if !defined(__aarch64__) && !defined(__F16C__)
+// IEEE 754 binary16 conversions, round to nearest even
+uint16_t float_to_half(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const uint32_t sign = (bits >> 16) & 0x8000U;
+    const uint32_t abs_bits = bits & 0x7FFFFFFFU;
+
+    if (abs_bits >= 0x47800000U) {
+        // Overflow to infinity, keep NaN payload non-zero
+        return static_cast<uint16_t>(sign | (abs_bits > 0x7F800000U ? 0x7E00U : 0x7C00U));
+    }
+    if (abs_bits < 0x38800000U) {
+        // Subnormal half (or zero)
+        const uint32_t shift = 113U - (abs_bits >> 23);
+        if (shift > 24U) {
+            return static_cast<uint16_t>(sign);
+        }
+        const uint32_t mantissa = (abs_bits & 0x007FFFFFU) | 0x00800000U;
+        uint32_t half = mantissa >> (shift + 13U);
+        const uint32_t remainder = mantissa & ((1U << (shift + 13U)) - 1U);
+        const uint32_t halfway = 1U << (shift + 12U);
+        if (remainder > halfway || (remainder == halfway && (half & 1U))) {
+            half++;
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    uint32_t half = (abs_bits - 0x38000000U) >> 13;
+    const uint32_t remainder = abs_bits & 0x1FFFU;
+    if (remainder > 0x1000U || (remainder == 0x1000U && (half & 1U))) {
+        half++;
+    }
+    return static_cast<uint16_t>(sign | half);
+}
+
+float half_to_float(uint16_t half) {
+    const uint32_t sign = static_cast<uint32_t>(half & 0x8000U) << 16;
+    uint32_t exponent = (half >> 10) & 0x1FU;
+    uint32_t mantissa = half & 0x03FFU;
+    uint32_t bits;
+
+    if (exponent == 0x1FU) {
+        bits = sign | 0x7F800000U | (mantissa << 13);
+    } else if (exponent != 0) {
+        bits = sign | ((exponent + 112U) << 23) | (mantissa << 13);
+    } else if (mantissa != 0) {
+        // Normalize the subnormal half
+        exponent = 113U;
+        while (!(mantissa & 0x0400U)) {
+            mantissa <<= 1;
+            exponent--;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x03FFU) << 13);
+    } else {
+        bits = sign;
+    }
+
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+#endif
+
+}// namespace
+
+void floats_to_halfs(const float *in, uint16_t *out, int n) {
+    int i = 0;
+#if defined(__aarch64__)
+    for (; i < n; i++) {
+        __fp16 half = static_cast<__fp16>(in[i]);
+        std::memcpy(&out[i], &half, sizeof(uint16_t));
+    }
+#elif defined(__F16C__)
+    for (; i + 8 <= n; i += 8) {
+        __m128i half = _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), half);
+    }
+    for (; i < n; i++) {
+        out[i] = _cvtss_sh(in[i], _MM_FROUND_TO_NEAREST_INT);
+    }
+#else
+    for (; i < n; i++) {
+        out[i] = float_to_half(in[i]);
+    }
+#endif
+}
+
+void halfs_to_floats(const uint16_t *in, float *out, int n) {
+    int i = 0;
+#if defined(__aarch64__)
+    for (; i < n; i++) {
+        __fp16 half;
+        std::memcpy(&half, &in[i], sizeof(uint16_t));
+        out[i] = static_cast<float>(half);
+    }
+#elif defined(__F16C__)
+    for (; i + 8 <= n; i += 8) {
+        __m128i half = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        _mm256_storeu_ps(out + i, _mm256_cvtph_ps(half));
+    }
+    for (; i < n; i++) {
+        out[i] = _cvtsh_ss(in[i]);
+    }
+#else
+    for (; i < n; i++) {
+        out[i] = half_to_float(in[i]);
+    }
+#endif
+}
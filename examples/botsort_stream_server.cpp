@@ -0,0 +1,140 @@
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <optional>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "BoTSORT.h"
+#include "StreamIngest.h"
+#include "StreamProtocol.h"
+
+
+/**
+ * @brief Command line options of the streaming server
+ */
+struct ServerOptions {
+    std::string config_dir = "../../config";
+    std::string socket_path;              // Unix-domain socket, frames in and tracks out on the same connection
+    std::string input_fifo, output_fifo;  // Named pipes, frames in and tracks out
+    bool stdio = false;                   // Frames on stdin, tracks on stdout
+    size_t max_queued_frames = 8;
+};
+
+
+void print_usage() {
+    std::cerr << "Usage: ./botsort_stream_server [options] (--socket <path> | --fifo <input> <output> | --stdio)\n"
+              << "  Tracks the frames of detections received in the binary format of StreamProtocol.h and sends back the tracks.\n"
+              << "  The tracker runs without images (GMC disabled, Re-ID must be disabled in the config).\n"
+              << "  --socket <path>            listen on a Unix-domain socket and serve a single client\n"
+              << "  --fifo <input> <output>    read frames from / write tracks to named pipes\n"
+              << "  --stdio                    read frames from stdin, write tracks to stdout\n"
+              << "  --config <dir>             config directory (default: ../../config)\n"
+              << "  --queue <n>                maximum number of received frames waiting to be tracked (default: 8)" << std::endl;
+}
+
+
+std::optional<ServerOptions> parse_args(int argc, char **argv) {
+    ServerOptions options;
+    int num_transports = 0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            options.socket_path = argv[++i];
+            num_transports++;
+        } else if (arg == "--fifo" && i + 2 < argc) {
+            options.input_fifo = argv[++i];
+            options.output_fifo = argv[++i];
+            num_transports++;
+        } else if (arg == "--stdio") {
+            options.stdio = true;
+            num_transports++;
+        } else if (arg == "--config" && i + 1 < argc) {
+            options.config_dir = argv[++i];
+        } else if (arg == "--queue" && i + 1 < argc) {
+            options.max_queued_frames = std::stoul(argv[++i]);
+        } else {
+            std::cerr << "Unknown option (or missing value): " << arg << std::endl;
+            return std::nullopt;
+        }
+    }
+
+    if (num_transports != 1) {
+        return std::nullopt;
+    }
+    return options;
+}
+
+
+int main(int argc, char **argv) {
+    std::optional<ServerOptions> parsed_options = parse_args(argc, argv);
+    if (!parsed_options) {
+        print_usage();
+        return -1;
+    }
+    const ServerOptions &options = parsed_options.value();
+
+    int input_fd = STDIN_FILENO, output_fd = STDOUT_FILENO;
+    if (options.stdio) {
+        // Tracks get their own copy of stdout, stdout itself is redirected to stderr to keep the log out of the stream
+        output_fd = dup(STDOUT_FILENO);
+        dup2(STDERR_FILENO, STDOUT_FILENO);
+    }
+
+    // Check the config before waiting for a client, frames without images can't be tracked with Re-ID
+    BoTSORT tracker(options.config_dir, "none");
+    if (!tracker.can_track_without_frames()) {
+        std::cerr << "The streaming server tracks without images, disable the Re-ID module in the config" << std::endl;
+        return -1;
+    }
+
+    // Write failures (client gone) are reported by StreamIngest, they must not kill the server
+    signal(SIGPIPE, SIG_IGN);
+
+    if (!options.socket_path.empty()) {
+        std::cerr << "Waiting for a client on " << options.socket_path << std::endl;
+        input_fd = output_fd = stream_protocol::accept_unix_socket(options.socket_path);
+    } else if (!options.input_fifo.empty()) {
+        // Opening a FIFO blocks until the other end is opened, the client must open them in the same order
+        input_fd = open(options.input_fifo.c_str(), O_RDONLY);
+        output_fd = open(options.output_fifo.c_str(), O_WRONLY);
+        if (input_fd < 0 || output_fd < 0) {
+            std::cerr << "Can't open FIFOs " << options.input_fifo << ", " << options.output_fifo << std::endl;
+            return -1;
+        }
+    }
+
+    size_t num_frames = 0, num_detections = 0;
+    int status = 0;
+    auto start = std::chrono::steady_clock::now();
+    try {
+        // Frames are received and tracks sent on background threads, while the tracker works on the current frame
+        StreamIngest ingest(input_fd, output_fd, options.max_queued_frames);
+        stream_protocol::FrameMessage frame;
+        while (ingest.receive(frame)) {
+            std::vector<std::shared_ptr<Track>> tracks = tracker.track(frame.detections, frame.image_size);
+            ingest.send(frame.frame_id, frame.timestamp, tracks);
+
+            num_frames++;
+            num_detections += frame.detections.size();
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Stream error: " << e.what() << std::endl;
+        status = -1;
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (input_fd != STDIN_FILENO) {
+        close(input_fd);
+    }
+    if (output_fd != input_fd) {
+        close(output_fd);
+    }
+
+    std::cerr << "Tracked " << num_frames << " frames (" << num_detections << " detections) in " << elapsed << " s, "
+              << (elapsed > 0 ? static_cast<double>(num_frames) / elapsed : 0.0) << " FPS" << std::endl;
+    return status;
+}
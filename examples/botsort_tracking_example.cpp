@@ -1,109 +1,172 @@
 #include <filesystem>
 #include <fstream>
+#include <future>
 #include <iomanip>
 #include <iostream>
-#include <iterator>
 #include <map>
 #include <memory>
 #include <opencv2/core/types.hpp>
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
 #include <opencv2/videoio.hpp>
+#include <optional>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 
 #include "BoTSORT.h"
 #include "DataType.h"
+#include "DetectionLoader.h"
 #include "GlobalMotionCompensation.h"
+#include "ImageSequenceReader.h"
+#include "MOTMetrics.h"
+#include "MOTWriter.h"
+#include "SharedFrameRing.h"
 #include "track.h"
-
-
-#define TEST_GMC 0
-#define GT_AS_PREDS 1
-#define YOLOv8_PREDS 0
+#include "TrackFile.h"
+#include "Tracing.h"
 
 
 /**
- * @brief Read detections from MOTChallenge format file
- * 
- * @param tracks Tracks
- * @param output_file Output file where the tracks will be written
+ * @brief Command line options of the tracking example
  */
-void mot_format_writer(const std::vector<std::shared_ptr<Track>> &tracks, const std::string &output_file) {
-    std::ofstream mot_file(output_file, std::ios::app);
-    for (const std::shared_ptr<Track> &track: tracks) {
-        std::vector<float> bbox_tlwh = track->get_tlwh();
-
-        mot_file << track->frame_id << "," << track->track_id << "," << bbox_tlwh[0] << ","
-                 << bbox_tlwh[1] << "," << bbox_tlwh[2] << "," << bbox_tlwh[3] << ",-1,-1,-1,0" << std::endl;
-    }
-    mot_file.close();
+struct Options {
+    std::string config_dir = "../../config";
+    std::string source, detections_path, output_dir;
+    std::string input_format = "mot";  // mot (single MOTChallenge file), yolo (directory with one label file per frame)
+    std::string output_format = "mot"; // mot, binary, binary-delta (see TrackFile.h), none
+    std::optional<std::string> gmc_method;// Overrides gmc_method of tracker.ini
+    bool visualize = true;
+    bool decode_video = true;
+    cv::Size frame_size;// Required without video decoding when it can not be read from the source
+    std::string load_state_path, save_state_path;// Tracker state snapshots (see BoTSORT::save_state)
+    int save_state_interval = 300;
+    std::string record_path;// Input log of the tracker, for replay_tracker_inputs (see BoTSORT::record_inputs)
+    std::string trace_path; // Chrome trace of the tracker execution (see Tracing.h)
+    std::string gt_path;    // MOTChallenge ground truth, to report the accuracy of the tracks (see MOTMetrics.h)
+    float gt_min_visibility = 0.0F;
+};
+
+
+void print_usage() {
+    std::cout << "Usage: ./botsort_tracking_example [options] [<config_dir>] <source> <detections> <output_dir>\n"
+              << "  <source>                   video file (mp4, avi, mkv, webm), directory of images, or shm:<name> for the\n"
+              << "                             shared frame ring of another process (e.g. shm_frame_producer)\n"
+              << "  <detections>               MOTChallenge detection file, or directory of YOLO label files (--input-format yolo)\n"
+              << "Options:\n"
+              << "  --config <dir>             config directory (default: ../../config)\n"
+              << "  --input-format <format>    mot (default) or yolo\n"
+              << "  --output-format <format>   mot (default), binary, binary-delta or none\n"
+              << "  --viz / --no-viz           save the frames with the tracks drawn on them (default: on)\n"
+              << "  --gmc <method>             override the GMC method: orb, ecc, sparseOptFlow, optFlowModified, OpenCV_VideoStab, none\n"
+              << "  --no-video-decode          do not decode the source, tracks from the detections only (requires --gmc none, --no-viz,\n"
+              << "                             MOT input and Re-ID disabled)\n"
+              << "  --frame-size <W>x<H>       frame size, if it can not be read from the source (only with --no-video-decode)\n"
+              << "  --load-state <file>        restore the tracker state (track IDs, ...) from a snapshot before tracking\n"
+              << "  --save-state <file>        save a snapshot of the tracker state periodically and at the end\n"
+              << "  --save-state-interval <n>  frames between two snapshots (default: 300)\n"
+              << "  --record <file>            record the tracker inputs to a log, to replay them with replay_tracker_inputs\n"
+              << "  --trace <file>             write a Chrome trace (JSON) of the tracker stages, GMC steps and lapjv calls\n"
+              << "  --gt <file>                MOTChallenge ground truth, report MOTA, IDF1, HOTA, ... of the tracks at the end\n"
+              << "  --gt-min-visibility <v>    ignore the ground truth objects less visible than this (default: 0)" << std::endl;
 }
 
 
 /**
- * @brief Read detections from YOLOv8 format file
- * 
- * @param detection_file Detection file
- * @param frame_width Image width (used to convert normalized bounding box to absolute coordinates)
- * @param frame_height Image height (used to convert normalized bounding box to absolute coordinates)
- * @return std::vector<Detection> Detections
+ * @brief Parse the command line, the positional arguments are [<config_dir>] <source> <detections> <output_dir>
+ *
+ * @return std::optional<Options> Parsed options (nullopt on invalid arguments)
  */
-std::vector<Detection> read_detections_from_file(const std::string &detection_file, int frame_width, int frame_height) {
-    std::vector<Detection> detections;
-    std::ifstream det_file(detection_file);
-    std::string line;
-    while (std::getline(det_file, line)) {
-        std::istringstream iss(line);
-        std::vector<float> values(std::istream_iterator<float>{iss}, std::istream_iterator<float>());
-
-        Detection det;
-        if (values[0] != 0)
-            continue;
-        det.class_id = static_cast<int>(values[0]);
-        det.bbox_tlwh = cv::Rect_(values[1] - values[3] / 2, values[2] - values[4] / 2, values[3], values[4]);
-        // bounding box is normalized, so convert to absolute coordinates
-        det.bbox_tlwh.x *= frame_width;
-        det.bbox_tlwh.y *= frame_height;
-        det.bbox_tlwh.width *= frame_width;
-        det.bbox_tlwh.height *= frame_height;
-
-        det.confidence = values[5];
-        detections.push_back(det);
-    }
-    det_file.close();
-    return detections;
-}
-
-
-std::vector<std::vector<Detection>> read_mot_gt_from_file(const std::string &gt_filepath) {
-    // https://stackoverflow.com/questions/57678677/multiple-object-tracking-mot-benchmark-data-set-format-for-ground-truth-tracki
-    // BB format is: frame_no,object_id,bb_left,bb_top,bb_width,bb_height,score,X,Y,Z
-
-    std::vector<std::vector<Detection>> all_gt_for_curr_sequence;
-    std::ifstream gt_file(gt_filepath);
-    std::string line;
-    while (std::getline(gt_file, line)) {
-        std::istringstream iss(line);
-        std::vector<float> values;
-
-        while (std::getline(iss, line, ',')) {
-            values.push_back(std::stof(line));
+std::optional<Options> parse_args(int argc, char **argv) {
+    Options options;
+    std::vector<std::string> positional;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (arg == "--help" || arg == "-h") {
+            return std::nullopt;
+        } else if (arg == "--config" && has_value) {
+            options.config_dir = argv[++i];
+        } else if (arg == "--input-format" && has_value) {
+            options.input_format = argv[++i];
+        } else if (arg == "--output-format" && has_value) {
+            options.output_format = argv[++i];
+        } else if (arg == "--gmc" && has_value) {
+            options.gmc_method = argv[++i];
+        } else if (arg == "--frame-size" && has_value) {
+            std::string size = argv[++i];
+            size_t x = size.find('x');
+            if (x == std::string::npos) {
+                std::cout << "Invalid frame size: " << size << std::endl;
+                return std::nullopt;
+            }
+            options.frame_size = cv::Size(std::stoi(size.substr(0, x)), std::stoi(size.substr(x + 1)));
+        } else if (arg == "--load-state" && has_value) {
+            options.load_state_path = argv[++i];
+        } else if (arg == "--save-state" && has_value) {
+            options.save_state_path = argv[++i];
+        } else if (arg == "--save-state-interval" && has_value) {
+            options.save_state_interval = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--record" && has_value) {
+            options.record_path = argv[++i];
+        } else if (arg == "--trace" && has_value) {
+            options.trace_path = argv[++i];
+        } else if (arg == "--gt" && has_value) {
+            options.gt_path = argv[++i];
+        } else if (arg == "--gt-min-visibility" && has_value) {
+            options.gt_min_visibility = std::stof(argv[++i]);
+        } else if (arg == "--viz") {
+            options.visualize = true;
+        } else if (arg == "--no-viz") {
+            options.visualize = false;
+        } else if (arg == "--no-video-decode") {
+            options.decode_video = false;
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cout << "Unknown option (or missing value): " << arg << std::endl;
+            return std::nullopt;
+        } else {
+            positional.push_back(arg);
         }
+    }
 
-        Detection det;
-        int frame_id = static_cast<int>(values[0]);
-        det.class_id = 0;// class_id is not provided in MOTChallenge format, so set it to 0 to indicate person
-        det.bbox_tlwh = cv::Rect_(values[2], values[3], values[4], values[5]);
-        det.confidence = static_cast<float>(values[6]) == 0 ? 1.0f : static_cast<float>(values[6]);
+    if (positional.size() == 4) {
+        options.config_dir = positional[0];
+        positional.erase(positional.begin());
+    }
+    if (positional.size() != 3) {
+        return std::nullopt;
+    }
+    options.source = positional[0];
+    options.detections_path = positional[1];
+    options.output_dir = positional[2];
 
-        while (all_gt_for_curr_sequence.size() < frame_id) {
-            all_gt_for_curr_sequence.emplace_back();
-        }
-        all_gt_for_curr_sequence[frame_id - 1].push_back(det);
+    if (DetectionLoader::format_map.find(options.input_format) == DetectionLoader::format_map.end()) {
+        std::cout << "Unknown input format: " << options.input_format << std::endl;
+        return std::nullopt;
+    }
+    if (options.output_format != "mot" && options.output_format != "binary" && options.output_format != "binary-delta" &&
+        options.output_format != "none") {
+        std::cout << "Unknown output format: " << options.output_format << std::endl;
+        return std::nullopt;
+    }
+    if (options.gmc_method && GlobalMotionCompensation::GMC_method_map.find(options.gmc_method.value()) == GlobalMotionCompensation::GMC_method_map.end()) {
+        std::cout << "Unknown GMC method: " << options.gmc_method.value() << std::endl;
+        return std::nullopt;
+    }
+    if (!options.decode_video && (options.gmc_method != "none" || options.visualize)) {
+        std::cout << "--no-video-decode requires --gmc none and --no-viz (and the Re-ID module disabled)" << std::endl;
+        return std::nullopt;
+    }
+    // YOLO labels are matched to the frames by image name, which is not known without decoding the source
+    if (!options.decode_video && options.input_format != "mot") {
+        std::cout << "--no-video-decode requires MOT detections (--input-format mot)" << std::endl;
+        return std::nullopt;
     }
 
-    return all_gt_for_curr_sequence;
+    return options;
 }
 
 
@@ -168,175 +231,239 @@ bool check_source(const std::string &source) {
 }
 
 
-int main(int argc, char **argv) {
+/**
+ * @brief Write a tracker state snapshot, replacing the previous one atomically. Throws std::runtime_error on failure
+ * 
+ * @param path Snapshot file
+ * @param snapshot Snapshot written by BoTSORT::save_state
+ */
+void write_snapshot(const std::string &path, const std::string &snapshot) {
+    std::string tmp_path = path + ".tmp";
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+    file.write(snapshot.data(), static_cast<std::streamsize>(snapshot.size()));
+    file.close();
+    if (!file) {
+        throw std::runtime_error("Can't write the tracker state to " + tmp_path);
+    }
+    std::filesystem::rename(tmp_path, path);
+}
 
-    if (argc < 4) {
-        std::cout << "Usage eg. 1: ./botsort_tracking_example <source> <dir_containing_per_frame_detections> <dir_to_save_mot_format_output>" << std::endl;
-        std::cout << "Usage eg. 2: ./botsort_tracking_example <config_dir> <source> <dir_containing_per_frame_detections> <dir_to_save_mot_format_output> <gt_file>" << std::endl;
-        return -1;
-    } else if (argc > 5) {
-        std::cout << "Usage eg. 1: ./botsort_tracking_example <source> <dir_containing_per_frame_detections> <dir_to_save_mot_format_output>" << std::endl;
-        std::cout << "Usage eg. 2: ./botsort_tracking_example <config_dir> <source> <dir_containing_per_frame_detections> <dir_to_save_mot_format_output> <gt_file>" << std::endl;
-        return -1;
+
+/**
+ * @brief Wait for the snapshot being written in the background, if any, and report its failure
+ * 
+ * @param snapshot_written Future of the asynchronous write_snapshot call
+ */
+void finish_snapshot(std::future<void> &snapshot_written) {
+    if (!snapshot_written.valid()) {
+        return;
+    }
+    try {
+        snapshot_written.get();
+    } catch (const std::exception &e) {
+        std::cout << "Tracker state snapshot failed: " << e.what() << std::endl;
     }
+}
+
 
-    std::string config_dir, source, labels_dir, output_dir, gt_filepath;
-
-    if (argc == 4) {
-        source = argv[1];
-        labels_dir = argv[2];
-        output_dir = argv[3];
-    } else {
-        config_dir = argv[1];
-        source = argv[2];
-        labels_dir = argv[3];
-        output_dir = argv[4];
+int main(int argc, char **argv) {
+    std::optional<Options> parsed_options = parse_args(argc, argv);
+    if (!parsed_options) {
+        print_usage();
+        return -1;
     }
+    const Options &options = parsed_options.value();
 
 
     // Setup output directories
-    std::string output_dir_mot = output_dir + "/mot";
-    std::string output_dir_img = output_dir + "/img";
+    std::string output_dir_mot = options.output_dir + "/mot";
+    std::string output_dir_img = options.output_dir + "/img";
     std::filesystem::create_directories(output_dir_mot);
-    std::filesystem::create_directories(output_dir_img);
-
-
-// // Initialize GlobalMotionCompensation
-#if (TEST_GMC == 1)
-    /*
-        {"orb", GMC_Method::ORB},
-        {"ecc", GMC_Method::ECC},
-        {"sparseOptFlow", GMC_Method::SparseOptFlow},
-        {"optFlowModified", GMC_Method::OptFlowModified},
-        {"OpenCV_VideoStab", GMC_Method::OpenCV_VideoStab},
-    */
-    GlobalMotionCompensation gmc = GlobalMotionCompensation(GlobalMotionCompensation::GMC_method_map["OpenCV_VideoStab"], 2.0);
-    cv::VideoCapture cap("/home/vipin/datasets/test_videos/0x100000A9_424_20220427_094317.mp4");
-    cv::Mat frame;
-
-    while (cap.read(frame)) {
-        HomographyMatrix H = gmc.apply(frame, {});
-        cv::Mat H_cv;
-        cv::eigen2cv(H, H_cv);
-        cv::Mat warped_frame;
-        cv::warpPerspective(frame, warped_frame, H_cv, frame.size());
-
-        cv::imshow("frame", frame);
-        cv::imshow("warped", warped_frame);
-
-        if (cv::waitKey(1) == 27) {
-            break;
-        }
+    if (options.visualize) {
+        std::filesystem::create_directories(output_dir_img);
     }
-    return 0;
-#endif
 
 
+    // Frame source, the frame size is needed upfront to load YOLO labels (normalized coordinates)
     cv::Mat frame;
     cv::VideoCapture cap;
-    int frame_counter = 0;
-    double tracker_time_sum = 0, tracker_time_total = 0;
-    std::string output_file_txt = output_dir_mot + "/all.txt";
     std::vector<std::string> image_filepaths;
-    bool is_video = check_source(source);
-
-    // Initialize BoTSORT tracker
-    std::unique_ptr<BoTSORT> tracker;
-    if (argc == 4) {
-        tracker = std::make_unique<BoTSORT>();
-    } else {
-        tracker = std::make_unique<BoTSORT>(config_dir);
-    }
-
-    if (is_video) {
-        cap = cv::VideoCapture(source);
-        cap.set(cv::CAP_PROP_POS_FRAMES, 0);
-    } else {
-        // Read filenames in labels dir
-        for (const auto &entry: std::filesystem::directory_iterator(source)) {
+    std::unique_ptr<SharedFrameConsumer> shm_consumer;
+    bool is_video = check_source(options.source);
+    cv::Size frame_size = options.frame_size;
+
+    if (options.source.rfind("shm:", 0) == 0) {
+        // Frames are read in place from the shared memory of the decoder process
+        shm_consumer = std::make_unique<SharedFrameConsumer>(options.source.substr(4));
+        if (frame_size.empty()) {
+            frame_size = shm_consumer->frame_size();
+        }
+    } else if (is_video) {
+        // Without video decoding, the video is only opened to read the frame size
+        if (options.decode_video || frame_size.empty()) {
+            cap = cv::VideoCapture(options.source);
+            cap.set(cv::CAP_PROP_POS_FRAMES, 0);
+        }
+        if (frame_size.empty()) {
+            frame_size = cv::Size(static_cast<int>(cap.get(cv::CAP_PROP_FRAME_WIDTH)), static_cast<int>(cap.get(cv::CAP_PROP_FRAME_HEIGHT)));
+        }
+    } else if (std::filesystem::is_directory(options.source)) {
+        for (const auto &entry: std::filesystem::directory_iterator(options.source)) {
             image_filepaths.push_back(entry.path());
         }
         std::sort(image_filepaths.begin(), image_filepaths.end());
+        if (frame_size.empty() && !image_filepaths.empty()) {
+            frame_size = cv::imread(image_filepaths[0]).size();
+        }
     }
 
+    if (frame_size.empty()) {
+        std::cout << "Can't read the frame size from " << options.source << ", use --frame-size" << std::endl;
+        return -1;
+    }
 
-#if (YOLOv8_PREDS == 1)
-    // Read detections and execute MultiObjectTracker
-    while (cap.read(frame) || frame_counter < image_filepaths.size()) {
-        std::string filename;
 
-        if (is_video) {
-            std::ostringstream ss;
-            ss << std::setw(6) << std::setfill('0') << frame_counter;
-            filename = ss.str();
-        } else {
-            frame = cv::imread(image_filepaths[frame_counter]);
-            filename = image_filepaths[frame_counter].substr(image_filepaths[frame_counter].find_last_of('/') + 1);
-            filename = filename.substr(0, filename.find_last_of('.'));
-        }
+    // Detections of the whole sequence
+    DetectionFormat input_format = DetectionLoader::format_map[options.input_format];
+    DetectionLoader detection_loader = input_format == DetectionFormat::YOLO
+                                               ? DetectionLoader(input_format, options.detections_path, frame_size.width, frame_size.height, 0)
+                                               : DetectionLoader(input_format, options.detections_path);
 
-        std::string detection_file = labels_dir + "/" + filename + ".txt";
-        std::vector<Detection> detections = read_detections_from_file(detection_file, frame.cols, frame.rows);
-        std::string output_file_img = output_dir_img + "/" + filename + ".jpg";
 
-        // Execute tracker
-        auto start = std::chrono::high_resolution_clock::now();
-        std::vector<std::shared_ptr<Track>> tracks = tracker->track(detections, frame);
-        auto end = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double> elapsed = end - start;
-        tracker_time_sum += elapsed.count();
+    // Outputs
+    std::unique_ptr<MOTWriter> mot_writer;
+    std::unique_ptr<TrackFileWriter> track_file_writer;
+    if (options.output_format == "mot") {
+        mot_writer = std::make_unique<MOTWriter>(output_dir_mot + "/all.txt");
+    } else if (options.output_format == "binary" || options.output_format == "binary-delta") {
+        track_file_writer = std::make_unique<TrackFileWriter>(output_dir_mot + "/all.btrk", options.output_format == "binary-delta");
+    }
 
-        // Outputs
-        mot_format_writer(tracks, output_file_txt);
 
-        plot_tracks(frame, detections, tracks);
-        cv::imwrite(output_file_img, frame);
+    // Initialize BoTSORT tracker
+    std::unique_ptr<BoTSORT> tracker = std::make_unique<BoTSORT>(options.config_dir, options.gmc_method);
+    if (!options.decode_video && !tracker->can_track_without_frames()) {
+        std::cout << "--no-video-decode requires the Re-ID module disabled in " << options.config_dir << "/tracker.ini" << std::endl;
+        return -1;
+    }
+    if (!options.load_state_path.empty()) {
+        std::ifstream file(options.load_state_path, std::ios::binary);
+        std::string snapshot((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (!file) {
+            std::cout << "Can't read the tracker state from " << options.load_state_path << std::endl;
+            return -1;
+        }
+        tracker->load_state(snapshot);
+        std::cout << "Restored the tracker state from " << options.load_state_path << std::endl;
+    }
+    if (!options.record_path.empty()) {
+        tracker->record_inputs(options.record_path);
+    }
+    if (!options.trace_path.empty()) {
+        tracing::start();
+    }
 
-        frame_counter++;
+    // Accuracy, accumulated frame by frame
+    std::vector<std::vector<GroundTruthObject>> ground_truth;
+    std::unique_ptr<MOTMetricsEvaluator> evaluator;
+    if (!options.gt_path.empty()) {
+        ground_truth = MOTMetricsEvaluator::load_mot_file(options.gt_path);
+        MOTMetricsParams metrics_params;
+        metrics_params.min_visibility = options.gt_min_visibility;
+        evaluator = std::make_unique<MOTMetricsEvaluator>(metrics_params);
+    }
 
-        if (frame_counter % 100 == 0) {
-            std::cout << "Processed " << frame_counter << " frames\t";
-            std::cout << "Tracker FPS (last 100 frames): " << 100 / tracker_time_sum << std::endl;
-            tracker_time_total += tracker_time_sum;
-            tracker_time_sum = 0;
-        }
+    // Snapshots are taken on the tracking thread (a copy of the state) and written to disk in the background
+    std::string snapshot;
+    std::future<void> snapshot_written;
+
+    // Images are decoded ahead of the tracker on a pool of threads
+    std::unique_ptr<ImageSequenceReader> image_reader;
+    if (!is_video && !shm_consumer && options.decode_video) {
+        image_reader = std::make_unique<ImageSequenceReader>(image_filepaths);
     }
-#endif
 
 
-#if (GT_AS_PREDS == 1)
-    std::vector<std::vector<Detection>> gt_per_frame = read_mot_gt_from_file(labels_dir);
+    int frame_counter = 0;
+    double tracker_time_sum = 0, tracker_time_total = 0;
+    auto processing_start = std::chrono::high_resolution_clock::now();
 
-    while (cap.read(frame) || frame_counter < image_filepaths.size()) {
+    while (true) {
         std::string filename;
 
-        if (is_video) {
-            std::ostringstream ss;
-            ss << std::setw(6) << std::setfill('0') << frame_counter;
-            filename = ss.str();
+        if (!options.decode_video) {
+            if (static_cast<size_t>(frame_counter) >= detection_loader.num_frames()) {
+                break;
+            }
+        } else if (shm_consumer) {
+            if (!shm_consumer->acquire(frame)) {
+                break;
+            }
+        } else if (is_video) {
+            if (!cap.read(frame)) {
+                break;
+            }
         } else {
-            frame = cv::imread(image_filepaths[frame_counter]);
+            if (!image_reader->read(frame)) {
+                break;
+            }
             filename = image_filepaths[frame_counter].substr(image_filepaths[frame_counter].find_last_of('/') + 1);
             filename = filename.substr(0, filename.find_last_of('.'));
         }
 
-        std::string output_file_img = output_dir_img + "/" + filename + ".jpg";
+        if (filename.empty()) {
+            std::ostringstream ss;
+            ss << std::setw(6) << std::setfill('0') << frame_counter;
+            filename = ss.str();
+        }
+
+        // MOT detections are indexed by frame, YOLO label files are matched by name
+        DetectionSpan detection_span;
+        if (input_format == DetectionFormat::MOT) {
+            detection_span = detection_loader.frame(frame_counter);
+        } else if (std::optional<size_t> frame_index = detection_loader.frame_index(filename)) {
+            detection_span = detection_loader.frame(frame_index.value());
+        }
+        std::vector<Detection> detections(detection_span.begin(), detection_span.end());
 
         // Execute tracker
         auto start = std::chrono::high_resolution_clock::now();
-        std::vector<std::shared_ptr<Track>> tracks = tracker->track(gt_per_frame[frame_counter], frame);
+        std::vector<std::shared_ptr<Track>> tracks = options.decode_video ? tracker->track(detections, frame)
+                                                                           : tracker->track(detections, frame_size);
         auto end = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double> elapsed = end - start;
         tracker_time_sum += elapsed.count();
 
         // Outputs
-        mot_format_writer(tracks, output_file_txt);
+        if (mot_writer) {
+            mot_writer->write(tracks);
+        } else if (track_file_writer) {
+            track_file_writer->write(frame_counter + 1, tracks);
+        }
+
+        if (evaluator) {
+            evaluator->update(static_cast<size_t>(frame_counter) < ground_truth.size() ? ground_truth[frame_counter] : std::vector<GroundTruthObject>(),
+                              tracks);
+        }
 
-        plot_tracks(frame, gt_per_frame[frame_counter], tracks);
-        cv::imwrite(output_file_img, frame);
+        if (options.visualize) {
+            plot_tracks(frame, detections, tracks);
+            cv::imwrite(output_dir_img + "/" + filename + ".jpg", frame);
+        }
+
+        // The tracker keeps no reference to the frame, its slot can be reused by the producer
+        if (shm_consumer) {
+            shm_consumer->release();
+        }
 
         frame_counter++;
 
+        if (!options.save_state_path.empty() && frame_counter % options.save_state_interval == 0) {
+            finish_snapshot(snapshot_written);
+            tracker->save_state(snapshot);
+            snapshot_written = std::async(std::launch::async, write_snapshot, options.save_state_path, std::cref(snapshot));
+        }
+
         if (frame_counter % 100 == 0) {
             std::cout << "Processed " << frame_counter << " frames\t";
             std::cout << "Tracker FPS (last 100 frames): " << 100 / tracker_time_sum << std::endl;
@@ -344,11 +471,39 @@ int main(int argc, char **argv) {
             tracker_time_sum = 0;
         }
     }
-#endif
+    tracker_time_total += tracker_time_sum;
+    if (!options.save_state_path.empty()) {
+        finish_snapshot(snapshot_written);
+        tracker->save_state(snapshot);
+        try {
+            write_snapshot(options.save_state_path, snapshot);
+        } catch (const std::exception &e) {
+            std::cout << "Tracker state snapshot failed: " << e.what() << std::endl;
+        }
+    }
+    tracker->stop_recording();
+    if (!options.trace_path.empty()) {
+        tracing::stop();
+        size_t num_events = tracing::write_chrome_trace(options.trace_path);
+        std::cout << "Wrote " << num_events << " trace events to " << options.trace_path
+                  << " (" << tracing::dropped_events() << " dropped)" << std::endl;
+    }
+    mot_writer.reset();
+    track_file_writer.reset();
+    std::chrono::duration<double> processing_time = std::chrono::high_resolution_clock::now() - processing_start;
 
     std::cout << "Average tracker FPS: " << frame_counter / tracker_time_total << std::endl;
     std::cout << "Average processing time per frame (ms): " << (tracker_time_total / frame_counter) * 1000 << std::endl;
+    std::cout << "End-to-end FPS (decoding, tracking, outputs): " << frame_counter / processing_time.count() << std::endl;
+    if (evaluator) {
+        std::cout << "Accuracy:\n"
+                  << evaluator->compute().summary() << std::flush;
+    }
+    if (TrackerStats::enabled) {
+        std::cout << "Tracker stages:\n"
+                  << tracker->stats().summary() << std::flush;
+    }
     cap.release();
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,55 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "MOTMetrics.h"
+
+
+int main(int argc, char **argv) {
+    MOTMetricsParams params;
+    std::string gt_path, tracks_path;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--iou" && has_value) {
+            params.iou_threshold = std::stof(argv[++i]);
+        } else if (arg == "--min-visibility" && has_value) {
+            params.min_visibility = std::stof(argv[++i]);
+        } else if (arg == "--no-hota") {
+            params.compute_hota = false;
+        } else if (arg[0] != '-' && gt_path.empty()) {
+            gt_path = arg;
+        } else if (arg[0] != '-' && tracks_path.empty()) {
+            tracks_path = arg;
+        } else {
+            gt_path.clear();
+            break;
+        }
+    }
+
+    if (gt_path.empty() || tracks_path.empty()) {
+        std::cout << "Usage: ./evaluate_mot_metrics [options] <gt_file> <tracks_file>\n"
+                  << "  --iou <t>                  minimum IoU of a match for CLEAR MOT and IDF1 (default: 0.5)\n"
+                  << "  --min-visibility <v>       ignore the ground truth objects less visible than this (default: 0)\n"
+                  << "  --no-hota                  skip HOTA" << std::endl;
+        return -1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::vector<GroundTruthObject>> ground_truth = MOTMetricsEvaluator::load_mot_file(gt_path);
+    std::vector<std::vector<GroundTruthObject>> tracks = MOTMetricsEvaluator::load_mot_file(tracks_path);
+
+    // Like mot_metrics_evaluator.py, the frames after the last ground truth frame are not evaluated
+    MOTMetricsEvaluator evaluator(params);
+    const std::vector<GroundTruthObject> none;
+    for (size_t f = 0; f < ground_truth.size(); f++) {
+        evaluator.update(ground_truth[f], f < tracks.size() ? tracks[f] : none);
+    }
+    MOTMetrics metrics = evaluator.compute();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << metrics.summary();
+    std::cout << "Evaluated " << metrics.num_frames << " frames in " << elapsed.count() * 1000 << " ms" << std::endl;
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "SyntheticScene.h"
+
+
+int main(int argc, char **argv) {
+    SyntheticSceneParams params;
+    int num_frames = 500;
+    std::string det_path, gt_path;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--targets" && has_value) {
+            params.num_targets = std::stoi(argv[++i]);
+        } else if (arg == "--frames" && has_value) {
+            num_frames = std::stoi(argv[++i]);
+        } else if (arg == "--size" && i + 2 < argc) {
+            params.frame_size = cv::Size(std::stoi(argv[i + 1]), std::stoi(argv[i + 2]));
+            i += 2;
+        } else if (arg == "--seed" && has_value) {
+            params.seed = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--motion" && has_value) {
+            std::string model = argv[++i];
+            if (SyntheticScene::motion_model_map.count(model) == 0) {
+                std::cout << "Unknown motion model: " << model << std::endl;
+                return -1;
+            }
+            params.motion_model = SyntheticScene::motion_model_map[model];
+        } else if (arg == "--speed" && has_value) {
+            params.speed = std::stof(argv[++i]);
+        } else if (arg == "--lifetime" && has_value) {
+            params.mean_lifetime = std::stof(argv[++i]);
+        } else if (arg == "--miss-rate" && has_value) {
+            params.miss_rate = std::stof(argv[++i]);
+        } else if (arg == "--false-positives" && has_value) {
+            params.false_positives_per_target = std::stof(argv[++i]);
+        } else if (arg == "--noise" && has_value) {
+            params.position_noise = params.size_noise = std::stof(argv[++i]);
+        } else if (arg == "--pan" && i + 2 < argc) {
+            params.pan_x = std::stof(argv[i + 1]);
+            params.pan_y = std::stof(argv[i + 2]);
+            i += 2;
+        } else if (arg == "--jitter" && has_value) {
+            params.pan_jitter = std::stof(argv[++i]);
+        } else if (arg[0] != '-' && det_path.empty()) {
+            det_path = arg;
+        } else if (arg[0] != '-' && gt_path.empty()) {
+            gt_path = arg;
+        } else {
+            det_path.clear();
+            break;
+        }
+    }
+
+    if (det_path.empty() || gt_path.empty()) {
+        std::cout << "Usage: ./generate_synthetic_scene [options] <det_output_file> <gt_output_file>\n"
+                  << "  --targets <n>              targets alive in every frame (default: 100)\n"
+                  << "  --frames <n>               number of frames (default: 500)\n"
+                  << "  --size <width> <height>    frame size (default: 1920 1080)\n"
+                  << "  --seed <n>                 random seed, the scene is reproducible (default: 42)\n"
+                  << "  --motion <model>           constant_velocity, random_walk, coordinated_turn or mixed (default)\n"
+                  << "  --speed <px>               mean target speed in pixels per frame (default: 2)\n"
+                  << "  --lifetime <frames>        mean target lifetime, 0 for targets leaving the view only (default: 300)\n"
+                  << "  --miss-rate <p>            probability to miss a visible target (default: 0.05)\n"
+                  << "  --false-positives <r>      false positives per frame, relative to the number of targets (default: 0.02)\n"
+                  << "  --noise <r>                standard deviation of the box noise, relative to the box size (default: 0.03)\n"
+                  << "  --pan <dx> <dy>            camera pan in pixels per frame (default: 0 0)\n"
+                  << "  --jitter <px>              standard deviation of the camera shake (default: 0)\n"
+                  << "Writes the detections (frame,-1,left,top,width,height,score,-1,-1,-1) and the ground truth\n"
+                  << "(frame,id,left,top,width,height,1,1,visibility) in MOTChallenge format" << std::endl;
+        return -1;
+    }
+
+    std::ofstream det_file(det_path), gt_file(gt_path);
+    if (!det_file || !gt_file) {
+        std::cout << "Can't write to " << (det_file ? gt_path : det_path) << std::endl;
+        return -1;
+    }
+
+    SyntheticScene scene(params);
+    size_t num_detections = 0, num_objects = 0;
+    for (int f = 0; f < num_frames; f++) {
+        SyntheticFrame frame = scene.next();
+        for (const Detection &detection: frame.detections) {
+            const cv::Rect_<float> &box = detection.bbox_tlwh;
+            det_file << frame.frame_id << ",-1," << box.x << "," << box.y << "," << box.width << "," << box.height << ","
+                     << detection.confidence << ",-1,-1,-1\n";
+        }
+        for (const GroundTruthObject &object: frame.ground_truth) {
+            const cv::Rect_<float> &box = object.bbox_tlwh;
+            gt_file << frame.frame_id << "," << object.id << "," << box.x << "," << box.y << "," << box.width << ","
+                    << box.height << ",1,1," << object.visibility << "\n";
+        }
+        num_detections += frame.detections.size();
+        num_objects += frame.ground_truth.size();
+    }
+
+    std::cout << "Generated " << num_frames << " frames: " << num_detections << " detections, " << num_objects
+              << " ground truth boxes, " << scene.num_births() << " targets" << std::endl;
+    return 0;
+}
@@ -0,0 +1,488 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BoTSORT.h"
+#include "DataType.h"
+#include "DetectionLoader.h"
+#include "GlobalMotionCompensation.h"
+#include "INIReader.h"
+#include "ImageSequenceReader.h"
+#include "MOTMetrics.h"
+#include "SyntheticScene.h"
+#include "TrackerConfig.h"
+
+
+/**
+ * @brief Swept parameter: Section.key and the values it takes
+ */
+struct SweptParam {
+    std::string section, name;
+    std::vector<std::string> values;
+};
+
+
+/**
+ * @brief Sequence held in memory, shared by all the configs. The homographies are estimated once for each
+ *  distinct GMC setting of the grid, before tracking
+ */
+struct Sequence {
+    std::string name;
+    int frame_rate = 30;
+    cv::Size image_size;
+    std::vector<std::vector<Detection>> detections;
+    std::vector<std::vector<GroundTruthObject>> ground_truth;
+    std::vector<std::string> image_paths;                         // Empty for synthetic sequences
+    std::vector<HomographyMatrix> camera_motion;                  // Synthetic sequences only, the exact camera pan
+    std::map<std::string, std::vector<HomographyMatrix>> homographies;// By GMC setting (see gmc_setting)
+};
+
+
+/**
+ * @brief Accuracy and latency of one config on one sequence
+ */
+struct JobResult {
+    std::unique_ptr<MOTMetricsEvaluator> evaluator;
+    size_t num_frames = 0;
+    double track_seconds = 0;// Time spent in the tracker only
+};
+
+
+void print_usage() {
+    std::cout << "Usage: ./parameter_sweep [options] --sequence <dir> [--sequence <dir> ...]\n"
+              << "Tracks every sequence with every combination of the swept parameters and reports the accuracy\n"
+              << "and the latency of each config. The configs run in parallel, each sequence is decoded once and its\n"
+              << "homographies are estimated once per GMC setting\n"
+              << "  --config <dir>             base config directory (default: ../../config)\n"
+              << "  --param <Section.key=v,..> swept parameter and its values, e.g. BoTSORT.match_thresh=0.6,0.7,0.8\n"
+              << "                             or orb.downscale=2,4 (gmc.ini sections), repeat for a grid\n"
+              << "  --sequence <dir>           MOTChallenge sequence: seqinfo.ini, det/det.txt, gt/gt.txt (optional)\n"
+              << "                             and the images (only decoded for the GMC methods other than none)\n"
+              << "  --synthetic <targets>      add a synthetic crowd scene of this many targets (see SyntheticScene.h),\n"
+              << "                             its homographies are the exact camera motion whatever the GMC method\n"
+              << "  --synthetic-frames <n>     length of the synthetic scenes (default: 500)\n"
+              << "  --jobs <n>                 number of trackers running at once (default: number of cores)\n"
+              << "  --iou <t>                  minimum IoU of a match for CLEAR MOT and IDF1 (default: 0.5)\n"
+              << "  --no-hota                  skip HOTA\n"
+              << "  --csv <file>               also write the results as CSV\n"
+              << "Re-ID is not supported: the configs are replayed without frames (see BoTSORT::replay)" << std::endl;
+}
+
+
+/**
+ * @brief Run job(i) for i in [0, num_jobs) on num_threads threads, rethrows the first exception of the jobs
+ */
+template<typename Job>
+void parallel_for(size_t num_jobs, unsigned int num_threads, const Job &job) {
+    std::atomic<size_t> next_job{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto worker = [&]() {
+        for (size_t i = next_job++; i < num_jobs; i = next_job++) {
+            try {
+                job(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                next_job = num_jobs;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < std::min<size_t>(num_threads, num_jobs); t++) {
+        threads.emplace_back(worker);
+    }
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+
+std::vector<std::string> split(const std::string &text, char delimiter) {
+    std::vector<std::string> parts;
+    std::stringstream stream(text);
+    for (std::string part; std::getline(stream, part, delimiter);) {
+        parts.push_back(part);
+    }
+    return parts;
+}
+
+
+/**
+ * @brief Key of the GMC setting of a config: the method and the parameters of its gmc.ini section,
+ *  empty for gmc_method = none. The method must be one of GlobalMotionCompensation::GMC_method_map
+ */
+std::string gmc_setting(const TrackerConfig &config, const std::vector<SweptParam> &params, const std::vector<size_t> &point) {
+    const std::string method = config.tracker.Get("BoTSORT", "gmc_method", "sparseOptFlow");
+    const GMC_Method gmc_method = GlobalMotionCompensation::GMC_method_map.at(method);
+    if (gmc_method == GMC_Method::NoGMC) {
+        return "";
+    }
+
+    // The method name does not always match the case of its section (optFlowModified -> [OptFlowModified])
+    const std::string &section = GlobalMotionCompensation::GMC_section_map.at(gmc_method);
+    std::string key = method;
+    for (size_t p = 0; p < params.size(); p++) {
+        if (TrackerConfig::same_section(params[p].section, section)) {
+            key += "," + params[p].name + "=" + params[p].values[point[p]];
+        }
+    }
+    return key;
+}
+
+
+Sequence load_mot_sequence(const std::string &dir) {
+    INIReader seqinfo(dir + "/seqinfo.ini");
+    if (seqinfo.ParseError() < 0) {
+        throw std::runtime_error("Can't load " + dir + "/seqinfo.ini");
+    }
+
+    Sequence sequence;
+    sequence.name = seqinfo.Get("Sequence", "name", std::filesystem::path(dir).filename().string());
+    sequence.frame_rate = static_cast<int>(seqinfo.GetInteger("Sequence", "frameRate", 30));
+    sequence.image_size = cv::Size(static_cast<int>(seqinfo.GetInteger("Sequence", "imWidth", 0)),
+                                   static_cast<int>(seqinfo.GetInteger("Sequence", "imHeight", 0)));
+    if (sequence.image_size.empty()) {
+        throw std::runtime_error(dir + "/seqinfo.ini: imWidth and imHeight are required");
+    }
+
+    DetectionLoader detections(DetectionFormat::MOT, dir + "/det/det.txt");
+    const auto num_frames = static_cast<size_t>(seqinfo.GetInteger("Sequence", "seqLength", static_cast<long>(detections.num_frames())));
+    sequence.detections.resize(num_frames);
+    for (size_t f = 0; f < num_frames; f++) {
+        DetectionSpan span = detections.frame(f);
+        sequence.detections[f].assign(span.begin(), span.end());
+    }
+
+    if (std::filesystem::exists(dir + "/gt/gt.txt")) {
+        sequence.ground_truth = MOTMetricsEvaluator::load_mot_file(dir + "/gt/gt.txt");
+    }
+
+    const std::string image_dir = dir + "/" + seqinfo.Get("Sequence", "imDir", "img1");
+    const std::string image_ext = seqinfo.Get("Sequence", "imExt", ".jpg");
+    for (size_t f = 1; f <= num_frames; f++) {
+        std::ostringstream path;
+        path << image_dir << "/" << std::setw(6) << std::setfill('0') << f << image_ext;
+        sequence.image_paths.push_back(path.str());
+    }
+    return sequence;
+}
+
+
+Sequence synthetic_sequence(int num_targets, int num_frames) {
+    SyntheticSceneParams params;
+    params.num_targets = num_targets;
+
+    Sequence sequence;
+    sequence.name = "synthetic-" + std::to_string(num_targets);
+    sequence.image_size = params.frame_size;
+    SyntheticScene scene(params);
+    for (SyntheticFrame &frame: scene.generate(num_frames)) {
+        sequence.detections.push_back(std::move(frame.detections));
+        sequence.ground_truth.push_back(std::move(frame.ground_truth));
+        sequence.camera_motion.push_back(frame.camera_motion);
+    }
+    return sequence;
+}
+
+
+/**
+ * @brief Estimate the homographies of a sequence for each GMC setting, the frames are decoded once
+ *  and the settings estimated in parallel on each frame
+ */
+void estimate_homographies(Sequence &sequence, const std::map<std::string, INIReader> &gmc_settings) {
+    if (!sequence.camera_motion.empty()) {
+        for (const auto &[key, gmc_config]: gmc_settings) {
+            sequence.homographies[key] = sequence.camera_motion;
+        }
+        return;
+    }
+
+    std::vector<std::pair<std::vector<HomographyMatrix> *, std::unique_ptr<GlobalMotionCompensation>>> estimators;
+    for (const auto &[key, gmc_config]: gmc_settings) {
+        const std::string method = key.substr(0, key.find(','));
+        std::vector<HomographyMatrix> &homographies = sequence.homographies[key];
+        homographies.reserve(sequence.detections.size());
+        estimators.emplace_back(&homographies, std::make_unique<GlobalMotionCompensation>(GlobalMotionCompensation::GMC_method_map.at(method), gmc_config));
+    }
+
+    ImageSequenceReader reader(sequence.image_paths);
+    cv::Mat frame;
+    std::vector<std::future<HomographyMatrix>> futures(estimators.size());
+    for (size_t f = 0; f < sequence.detections.size(); f++) {
+        if (!reader.read(frame) || frame.empty()) {
+            throw std::runtime_error("Can't read " + sequence.image_paths[f]);
+        }
+        for (size_t e = 1; e < estimators.size(); e++) {
+            futures[e] = std::async(std::launch::async, [&, e, f]() { return estimators[e].second->apply(frame, sequence.detections[f]); });
+        }
+        estimators[0].first->push_back(estimators[0].second->apply(frame, sequence.detections[f]));
+        for (size_t e = 1; e < estimators.size(); e++) {
+            estimators[e].first->push_back(futures[e].get());
+        }
+    }
+}
+
+
+int main(int argc, char **argv) {
+    std::string config_dir = "../../config", csv_path;
+    std::vector<SweptParam> params;
+    std::vector<std::string> sequence_dirs;
+    std::vector<int> synthetic_targets;
+    int synthetic_frames = 500;
+    unsigned int num_threads = std::max(std::thread::hardware_concurrency(), 1U);
+    MOTMetricsParams metrics_params;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--config" && has_value) {
+            config_dir = argv[++i];
+        } else if (arg == "--param" && has_value) {
+            std::string spec = argv[++i];
+            size_t dot = spec.find('.'), equal = spec.find('=');
+            if (dot == 0 || dot == std::string::npos || equal == std::string::npos || equal < dot + 2 || equal + 1 == spec.size()) {
+                std::cout << "Invalid parameter: " << spec << ", expected Section.key=v1,v2,..." << std::endl;
+                return -1;
+            }
+            params.push_back({spec.substr(0, dot), spec.substr(dot + 1, equal - dot - 1), split(spec.substr(equal + 1), ',')});
+        } else if (arg == "--sequence" && has_value) {
+            sequence_dirs.emplace_back(argv[++i]);
+        } else if (arg == "--synthetic" && has_value) {
+            synthetic_targets.push_back(std::stoi(argv[++i]));
+        } else if (arg == "--synthetic-frames" && has_value) {
+            synthetic_frames = std::stoi(argv[++i]);
+        } else if (arg == "--jobs" && has_value) {
+            num_threads = static_cast<unsigned int>(std::max(1, std::stoi(argv[++i])));
+        } else if (arg == "--iou" && has_value) {
+            metrics_params.iou_threshold = std::stof(argv[++i]);
+        } else if (arg == "--no-hota") {
+            metrics_params.compute_hota = false;
+        } else if (arg == "--csv" && has_value) {
+            csv_path = argv[++i];
+        } else {
+            print_usage();
+            return -1;
+        }
+    }
+    if (sequence_dirs.empty() && synthetic_targets.empty()) {
+        print_usage();
+        return -1;
+    }
+
+
+    // Grid: cartesian product of the values of the swept parameters
+    const TrackerConfig base_config = TrackerConfig::load(config_dir);
+    for (const SweptParam &param: params) {
+        // A misspelled parameter would silently sweep nothing
+        const bool gmc_param = TrackerConfig::is_gmc_section(param.section);
+        if (!(gmc_param ? base_config.gmc : base_config.tracker).Get(param.section, param.name)) {
+            std::cout << "Unknown parameter: " << param.section << "." << param.name << " is not in " << config_dir
+                      << (gmc_param ? "/gmc.ini" : "/tracker.ini") << std::endl;
+            return -1;
+        }
+    }
+    std::vector<std::vector<size_t>> grid(1);
+    for (const SweptParam &param: params) {
+        std::vector<std::vector<size_t>> expanded;
+        for (const std::vector<size_t> &point: grid) {
+            for (size_t v = 0; v < param.values.size(); v++) {
+                expanded.push_back(point);
+                expanded.back().push_back(v);
+            }
+        }
+        grid = std::move(expanded);
+    }
+
+    std::vector<TrackerConfig> configs;
+    std::vector<std::string> config_gmc_settings;
+    std::map<std::string, INIReader> gmc_settings;
+    for (const std::vector<size_t> &point: grid) {
+        TrackerConfig config = base_config;
+        for (size_t p = 0; p < params.size(); p++) {
+            config.set(params[p].section, params[p].name, params[p].values[point[p]]);
+        }
+        if (config.tracker.Get("BoTSORT", "model_path") || config.tracker.Get("BoTSORT", "reid_method", "cnn") != "cnn") {
+            std::cout << "Re-ID is not supported by the sweep, remove model_path and reid_method from the config" << std::endl;
+            return -1;
+        }
+        // Checked here, an unknown method would otherwise only fail once the sweep runs, in every worker
+        const std::string gmc_method = config.tracker.Get("BoTSORT", "gmc_method", "sparseOptFlow");
+        if (GlobalMotionCompensation::GMC_method_map.find(gmc_method) == GlobalMotionCompensation::GMC_method_map.end()) {
+            std::cout << "Unknown gmc_method: " << gmc_method << std::endl;
+            return -1;
+        }
+
+        std::string setting = gmc_setting(config, params, point);
+        if (!setting.empty() && config.gmc.ParseError() < 0) {
+            std::cout << "Can't load " << config_dir << "/gmc.ini" << std::endl;
+            return -1;
+        }
+        if (!setting.empty()) {
+            gmc_settings.emplace(setting, config.gmc);
+        }
+        config_gmc_settings.push_back(setting);
+        configs.push_back(std::move(config));
+    }
+
+
+    // Load the sequences and estimate their homographies, in parallel
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Sequence> sequences(sequence_dirs.size() + synthetic_targets.size());
+    try {
+        parallel_for(sequences.size(), num_threads, [&](size_t s) {
+            sequences[s] = s < sequence_dirs.size() ? load_mot_sequence(sequence_dirs[s])
+                                                    : synthetic_sequence(synthetic_targets[s - sequence_dirs.size()], synthetic_frames);
+            if (!gmc_settings.empty()) {
+                estimate_homographies(sequences[s], gmc_settings);
+            }
+        });
+    } catch (const std::exception &e) {
+        std::cout << e.what() << std::endl;
+        return -1;
+    }
+    std::chrono::duration<double> preparation = std::chrono::steady_clock::now() - start;
+    std::cout << "Prepared " << sequences.size() << " sequences and " << gmc_settings.size() << " GMC settings in "
+              << preparation.count() << " s, running " << configs.size() * sequences.size() << " jobs on " << num_threads
+              << " threads" << std::endl;
+
+
+    // One independent tracker per (config, sequence), replaying the detections with the cached homographies
+    start = std::chrono::steady_clock::now();
+    std::vector<JobResult> results(configs.size() * sequences.size());
+    parallel_for(results.size(), num_threads, [&](size_t job) {
+        const size_t c = job / sequences.size();
+        const Sequence &sequence = sequences[job % sequences.size()];
+        TrackerConfig config = configs[c];
+        config.set("BoTSORT", "frame_rate", std::to_string(sequence.frame_rate));
+        BoTSORT tracker(config);
+        tracker.set_stream_id(static_cast<int>(job));
+
+        const std::vector<HomographyMatrix> *homographies =
+                config_gmc_settings[c].empty() ? nullptr : &sequence.homographies.at(config_gmc_settings[c]);
+        JobResult &result = results[job];
+        result.evaluator = std::make_unique<MOTMetricsEvaluator>(metrics_params);
+        const std::vector<GroundTruthObject> none;
+        RecordedFrame inputs;
+        inputs.image_size = sequence.image_size;
+        for (size_t f = 0; f < sequence.detections.size(); f++) {
+            inputs.frame_id = static_cast<uint32_t>(f + 1);
+            inputs.detections = sequence.detections[f];
+            inputs.homography = homographies ? (*homographies)[f] : HomographyMatrix::Identity();
+
+            auto call_start = std::chrono::steady_clock::now();
+            std::vector<std::shared_ptr<Track>> tracks = tracker.replay(inputs);
+            result.track_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - call_start).count();
+            if (!sequence.ground_truth.empty()) {
+                result.evaluator->update(f < sequence.ground_truth.size() ? sequence.ground_truth[f] : none, tracks);
+            }
+        }
+        result.num_frames = sequence.detections.size();
+    });
+    std::chrono::duration<double> sweep = std::chrono::steady_clock::now() - start;
+
+
+    // Accuracy over all the sequences and mean latency of each config
+    const bool has_ground_truth = std::any_of(sequences.begin(), sequences.end(),
+                                              [](const Sequence &sequence) { return !sequence.ground_truth.empty(); });
+    std::vector<std::string> header;
+    for (const SweptParam &param: params) {
+        header.push_back(param.section + "." + param.name);
+    }
+    for (const char *column: {"MOTA", "IDF1", "HOTA", "IDsw", "FP", "FN", "FPS", "ms/frame"}) {
+        header.emplace_back(column);
+    }
+
+    std::vector<std::vector<std::string>> rows;
+    for (size_t c = 0; c < configs.size(); c++) {
+        MOTMetricsEvaluator evaluator(metrics_params);
+        size_t num_frames = 0;
+        double track_seconds = 0;
+        for (size_t s = 0; s < sequences.size(); s++) {
+            const JobResult &result = results[c * sequences.size() + s];
+            evaluator.merge(*result.evaluator);
+            num_frames += result.num_frames;
+            track_seconds += result.track_seconds;
+        }
+        const MOTMetrics metrics = evaluator.compute();
+
+        auto format = [](double value, int precision) {
+            std::ostringstream text;
+            text << std::fixed << std::setprecision(precision) << value;
+            return text.str();
+        };
+        std::vector<std::string> row;
+        for (size_t p = 0; p < params.size(); p++) {
+            row.push_back(params[p].values[grid[c][p]]);
+        }
+        if (has_ground_truth) {
+            row.push_back(format(100.0 * metrics.mota, 1));
+            row.push_back(format(100.0 * metrics.idf1, 1));
+            row.push_back(metrics_params.compute_hota ? format(100.0 * metrics.hota, 1) : "-");
+            row.push_back(std::to_string(metrics.num_switches));
+            row.push_back(std::to_string(metrics.num_false_positives));
+            row.push_back(std::to_string(metrics.num_misses));
+        } else {
+            row.insert(row.end(), 6, "-");
+        }
+        row.push_back(format(track_seconds > 0 ? static_cast<double>(num_frames) / track_seconds : 0.0, 0));
+        row.push_back(format(num_frames > 0 ? 1000.0 * track_seconds / static_cast<double>(num_frames) : 0.0, 3));
+        rows.push_back(std::move(row));
+    }
+
+    std::cout << "\n|";
+    for (const std::string &column: header) {
+        std::cout << " " << column << " |";
+    }
+    std::cout << "\n|";
+    for (size_t i = 0; i < header.size(); i++) {
+        std::cout << (i < params.size() ? "---|" : "---:|");
+    }
+    for (const std::vector<std::string> &row: rows) {
+        std::cout << "\n|";
+        for (const std::string &cell: row) {
+            std::cout << " " << cell << " |";
+        }
+    }
+    std::cout << "\n\n"
+              << configs.size() << " configs x " << sequences.size() << " sequences in " << sweep.count() << " s" << std::endl;
+
+    if (!csv_path.empty()) {
+        std::ofstream csv(csv_path);
+        if (!csv) {
+            std::cout << "Can't write to " << csv_path << std::endl;
+            return -1;
+        }
+        auto write_line = [&csv](const std::vector<std::string> &cells) {
+            for (size_t i = 0; i < cells.size(); i++) {
+                csv << (i > 0 ? "," : "") << cells[i];
+            }
+            csv << "\n";
+        };
+        write_line(header);
+        for (const std::vector<std::string> &row: rows) {
+            write_line(row);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "BoTSORT.h"
+#include "InputLog.h"
+
+
+/**
+ * @brief Percentile of the sorted values
+ */
+double percentile(const std::vector<double> &sorted_values, double p) {
+    if (sorted_values.empty()) {
+        return 0.0;
+    }
+    size_t index = static_cast<size_t>(p * static_cast<double>(sorted_values.size() - 1) + 0.5);
+    return sorted_values[index];
+}
+
+
+/**
+ * @brief Re-executes the tracker on the inputs recorded by BoTSORT::record_inputs (botsort_tracking_example --record),
+ *  without video and at maximum speed, checks that the output tracks are the recorded ones and reports the timings
+ */
+int main(int argc, char **argv) {
+    int repeat = 1;
+    bool verify = true;
+    std::string config_dir = "../../config", load_state_path, log_path;
+    std::vector<std::string> positional;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--repeat" && i + 1 < argc) {
+            repeat = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--load-state" && i + 1 < argc) {
+            load_state_path = argv[++i];
+        } else if (arg == "--no-verify") {
+            verify = false;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    if (positional.size() == 2) {
+        config_dir = positional[0];
+        log_path = positional[1];
+    } else if (positional.size() == 1) {
+        log_path = positional[0];
+    }
+    if (log_path.empty()) {
+        std::cout << "Usage: ./replay_tracker_inputs [--repeat <n>] [--load-state <file>] [--no-verify] [<config_dir>] <log>\n"
+                  << "  --repeat <n>          replay the log n times, each time with a new tracker (default: 1)\n"
+                  << "  --load-state <file>   snapshot the recording tracker was restored from, if any\n"
+                  << "  --no-verify           do not compare the output tracks with the recorded ones\n"
+                  << "The tracker must use the config of the recording (Re-ID, embedding cache, thresholds, ...)\n"
+                  << "Example: ./replay_tracker_inputs ../config inputs.btil" << std::endl;
+        return -1;
+    }
+
+    std::string snapshot;
+    if (!load_state_path.empty()) {
+        std::ifstream file(load_state_path, std::ios::binary);
+        snapshot.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        if (!file) {
+            std::cout << "Can't read the tracker state from " << load_state_path << std::endl;
+            return -1;
+        }
+    }
+
+    // Replay times of the calls, in ms, over all the repetitions
+    std::vector<double> replay_times;
+    double recorded_time_total = 0.0;
+    size_t num_frames = 0, num_mismatches = 0;
+    uint32_t first_mismatch = 0;
+
+    RecordedFrame inputs;
+    for (int r = 0; r < repeat; r++) {
+        InputLogReader log(log_path);
+        BoTSORT tracker(config_dir);
+        if (log.feature_dim() != tracker.reid_feature_dim()) {
+            std::cout << "The log was recorded with Re-ID features of dimension " << log.feature_dim()
+                      << ", the tracker uses " << tracker.reid_feature_dim() << " (0: Re-ID disabled)" << std::endl;
+            return -1;
+        }
+        if (!snapshot.empty()) {
+            tracker.load_state(snapshot);
+        }
+
+        while (log.next(inputs)) {
+            auto start = std::chrono::steady_clock::now();
+            std::vector<std::shared_ptr<Track>> tracks = tracker.replay(inputs);
+            replay_times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+            if (r == 0) {
+                num_frames++;
+                recorded_time_total += static_cast<double>(inputs.duration_ns) * 1e-6;
+                if (verify && (tracks.size() != inputs.num_output_tracks || input_log::hash_tracks(tracks) != inputs.output_hash)) {
+                    if (num_mismatches++ == 0) {
+                        first_mismatch = inputs.frame_id;
+                    }
+                }
+            }
+        }
+    }
+    if (num_frames == 0) {
+        std::cout << "No track() call in " << log_path << std::endl;
+        return -1;
+    }
+
+    double replay_time_total = 0.0;
+    for (double time: replay_times) {
+        replay_time_total += time;
+    }
+    std::sort(replay_times.begin(), replay_times.end());
+
+    std::cout << "Replayed " << num_frames << " frames x " << repeat << "\n"
+              << "Replay time per frame (ms): mean " << replay_time_total / static_cast<double>(replay_times.size())
+              << ", p50 " << percentile(replay_times, 0.5) << ", p99 " << percentile(replay_times, 0.99)
+              << ", max " << replay_times.back() << "\n"
+              << "Replay FPS: " << static_cast<double>(replay_times.size()) / (replay_time_total * 1e-3) << "\n"
+              << "Recorded time per frame (ms, including GMC and Re-ID): " << recorded_time_total / static_cast<double>(num_frames) << std::endl;
+
+    if (!verify) {
+        return 0;
+    }
+    if (num_mismatches > 0) {
+        std::cout << "MISMATCH: the output tracks differ from the recorded ones in " << num_mismatches
+                  << " frames, first at frame " << first_mismatch << std::endl;
+        return 1;
+    }
+    std::cout << "Output tracks identical to the recorded ones" << std::endl;
+    return 0;
+}
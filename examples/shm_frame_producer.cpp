@@ -0,0 +1,82 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <opencv2/videoio.hpp>
+
+#include "SharedFrameRing.h"
+
+
+/**
+ * @brief Stand-in for an external decoder process: decodes a video straight into the slots of a shared frame ring,
+ *  for the tracker to read them without copies (botsort_tracking_example shm:<name> ...)
+ */
+int main(int argc, char **argv) {
+    size_t num_slots = 4;
+    double fps = 0.0;
+    std::string video_path, ring_name;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--slots" && i + 1 < argc) {
+            num_slots = std::stoul(argv[++i]);
+        } else if (arg == "--fps" && i + 1 < argc) {
+            fps = std::stod(argv[++i]);
+        } else if (video_path.empty()) {
+            video_path = arg;
+        } else {
+            ring_name = arg;
+        }
+    }
+    if (video_path.empty() || ring_name.empty()) {
+        std::cout << "Usage: ./shm_frame_producer [--slots <n>] [--fps <rate>] <video> <ring_name>\n"
+                  << "  --slots <n>      number of frame slots in the ring (default: 4)\n"
+                  << "  --fps <rate>     frames published per second (default: 0, as fast as the consumer reads them)\n"
+                  << "Example: ./shm_frame_producer ../examples/data/MOT20-01.mp4 /botsort_frames" << std::endl;
+        return -1;
+    }
+
+    cv::VideoCapture cap(video_path);
+    if (!cap.isOpened()) {
+        std::cout << "Can't open " << video_path << std::endl;
+        return -1;
+    }
+    cv::Size frame_size(static_cast<int>(cap.get(cv::CAP_PROP_FRAME_WIDTH)), static_cast<int>(cap.get(cv::CAP_PROP_FRAME_HEIGHT)));
+
+    SharedFrameProducer producer(ring_name, frame_size, CV_8UC3, num_slots);
+    std::cout << "Publishing " << frame_size.width << "x" << frame_size.height << " frames of " << video_path << " to " << ring_name << std::endl;
+
+    uint32_t frame_id = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (true) {
+        // The decoder writes into the slot in place, as the header has the size and type of the decoded frames
+        cv::Mat slot = producer.acquire();
+        cv::Mat decoded = slot;
+        if (!cap.read(decoded)) {
+            break;
+        }
+        if (decoded.data != slot.data) {
+            // copyTo() would reallocate the header instead of writing to the slot if the frame doesn't fit it
+            if (decoded.size() != slot.size() || decoded.type() != slot.type()) {
+                std::cout << "Frame " << frame_id + 1 << " is " << decoded.cols << "x" << decoded.rows << " (type " << decoded.type()
+                          << "), the ring holds " << slot.cols << "x" << slot.rows << " frames (type " << slot.type() << ")" << std::endl;
+                return -1;
+            }
+            decoded.copyTo(slot);
+        }
+
+        frame_id++;
+        if (fps > 0) {
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                          std::chrono::duration<double>(frame_id / fps)));
+        }
+        double timestamp = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        producer.publish(frame_id, timestamp);
+    }
+    producer.close();
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Published " << frame_id << " frames in " << elapsed << " s" << std::endl;
+    return 0;
+}
@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "DetectionLoader.h"
+#include "StreamProtocol.h"
+
+
+/**
+ * @brief Command line options of the replay client
+ */
+struct ClientOptions {
+    std::string detections_path;
+    std::string socket_path;
+    std::string input_fifo, output_fifo;// Server side names: frames are written to input_fifo, tracks read from output_fifo
+    double fps = 0.0;                   // 0: as fast as the server accepts the frames
+    int repeat = 1;
+    cv::Size frame_size = cv::Size(1920, 1080);
+};
+
+
+void print_usage() {
+    std::cout << "Usage: ./stream_replay_client [options] (--socket <path> | --fifo <input> <output>) <detections>\n"
+              << "  Replays a MOTChallenge detection file (det.txt) to botsort_stream_server and reports the sustained\n"
+              << "  throughput and the latency from sending a frame to receiving its tracks.\n"
+              << "  --socket <path>            connect to the server's Unix-domain socket\n"
+              << "  --fifo <input> <output>    named pipes the server reads frames from / writes tracks to\n"
+              << "  --fps <rate>               frames sent per second (default: 0, as fast as possible)\n"
+              << "  --repeat <n>               replay the sequence n times (default: 1)\n"
+              << "  --frame-size <W>x<H>       frame size sent with each frame (default: 1920x1080)" << std::endl;
+}
+
+
+std::optional<ClientOptions> parse_args(int argc, char **argv) {
+    ClientOptions options;
+    std::vector<std::string> positional;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            options.socket_path = argv[++i];
+        } else if (arg == "--fifo" && i + 2 < argc) {
+            options.input_fifo = argv[++i];
+            options.output_fifo = argv[++i];
+        } else if (arg == "--fps" && i + 1 < argc) {
+            options.fps = std::stod(argv[++i]);
+        } else if (arg == "--repeat" && i + 1 < argc) {
+            options.repeat = std::max(std::stoi(argv[++i]), 1);
+        } else if (arg == "--frame-size" && i + 1 < argc) {
+            std::string size = argv[++i];
+            size_t x = size.find('x');
+            if (x == std::string::npos) {
+                std::cout << "Invalid frame size: " << size << std::endl;
+                return std::nullopt;
+            }
+            options.frame_size = cv::Size(std::stoi(size.substr(0, x)), std::stoi(size.substr(x + 1)));
+            if (options.frame_size.width <= 0 || options.frame_size.height <= 0) {
+                std::cout << "Invalid frame size: " << size << std::endl;
+                return std::nullopt;
+            }
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cout << "Unknown option (or missing value): " << arg << std::endl;
+            return std::nullopt;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (positional.size() != 1 || options.socket_path.empty() == options.input_fifo.empty()) {
+        return std::nullopt;
+    }
+    options.detections_path = positional[0];
+    return options;
+}
+
+
+double now_seconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+int main(int argc, char **argv) {
+    std::optional<ClientOptions> parsed_options = parse_args(argc, argv);
+    if (!parsed_options) {
+        print_usage();
+        return -1;
+    }
+    const ClientOptions &options = parsed_options.value();
+
+    DetectionLoader loader(DetectionFormat::MOT, options.detections_path);
+    const size_t num_frames = loader.num_frames() * static_cast<size_t>(options.repeat);
+
+    int output_fd, input_fd;
+    if (!options.socket_path.empty()) {
+        output_fd = input_fd = stream_protocol::connect_unix_socket(options.socket_path);
+    } else {
+        // Same order as the server to avoid a deadlock on open
+        output_fd = open(options.input_fifo.c_str(), O_WRONLY);
+        input_fd = open(options.output_fifo.c_str(), O_RDONLY);
+        if (input_fd < 0 || output_fd < 0) {
+            std::cout << "Can't open FIFOs " << options.input_fifo << ", " << options.output_fifo << std::endl;
+            return -1;
+        }
+    }
+
+    // Frames are sent on their own thread so that sending is never held back by the responses
+    const double start = now_seconds();
+    std::thread sender([&]() {
+        std::string buffer;
+        for (size_t i = 0; i < num_frames; i++) {
+            if (options.fps > 0) {
+                std::this_thread::sleep_until(std::chrono::steady_clock::time_point(
+                        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                std::chrono::duration<double>(start + static_cast<double>(i) / options.fps))));
+            }
+
+            DetectionSpan detections = loader.frame(i % loader.num_frames());
+            buffer.clear();
+            stream_protocol::encode_frame(buffer, static_cast<uint32_t>(i + 1), now_seconds(), options.frame_size,
+                                          detections.begin(), detections.size());
+            stream_protocol::write_all(output_fd, buffer.data(), buffer.size());
+        }
+
+        // End of the stream: the server finishes the queued frames and closes its side
+        if (output_fd == input_fd) {
+            shutdown(output_fd, SHUT_WR);
+        } else {
+            close(output_fd);
+        }
+    });
+
+    std::vector<double> latencies;
+    latencies.reserve(num_frames);
+    size_t num_tracks = 0;
+    double last_received = start;
+
+    stream_protocol::MessageReader reader(input_fd);
+    std::string_view payload;
+    while (reader.next(payload)) {
+        stream_protocol::TrackHeader header{};
+        stream_protocol::decode_tracks(payload, header);
+
+        last_received = now_seconds();
+        latencies.push_back(last_received - header.timestamp);
+        num_tracks += header.num_tracks;
+    }
+    sender.join();
+    close(input_fd);
+
+    if (latencies.size() != num_frames) {
+        std::cout << "Received tracks for " << latencies.size() << " of " << num_frames << " frames" << std::endl;
+    }
+    if (latencies.empty()) {
+        return -1;
+    }
+
+    const double elapsed = last_received - start;
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+        return latencies[std::min(latencies.size() - 1, static_cast<size_t>(p * static_cast<double>(latencies.size())))] * 1000.0;
+    };
+
+    std::cout << "Frames: " << latencies.size() << ", tracks: " << num_tracks << ", time: " << elapsed << " s\n"
+              << "Throughput: " << static_cast<double>(latencies.size()) / elapsed << " frames/s\n"
+              << "Latency (ms): p50 " << percentile(0.5) << ", p90 " << percentile(0.9) << ", p99 " << percentile(0.99)
+              << ", max " << latencies.back() * 1000.0 << std::endl;
+    return 0;
+}
@@ -0,0 +1,30 @@
+#include <iostream>
+#include <string>
+
+#include "MOTWriter.h"
+#include "TrackFile.h"
+
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        std::cout << "Usage: ./track_file_to_mot <track_file> <mot_output_file>" << std::endl;
+        return -1;
+    }
+
+    TrackFileReader reader(argv[1]);
+    MOTWriter mot_writer(argv[2]);
+
+    size_t num_lines = 0;
+    for (size_t i = 0; i < reader.num_frames(); i++) {
+        TrackFrame frame = reader.frame(i);
+        for (size_t j = 0; j < frame.num_tracks; j++) {
+            const float tlwh[4] = {frame.x[j], frame.y[j], frame.width[j], frame.height[j]};
+            mot_writer.write(frame.frame_id, frame.track_ids[j], tlwh);
+        }
+        num_lines += frame.num_tracks;
+    }
+
+    std::cout << "Converted " << reader.num_frames() << " frames (" << num_lines << " tracks, "
+              << (reader.delta_encoded() ? "delta encoded" : "raw") << ") to " << argv[2] << std::endl;
+    return 0;
+}